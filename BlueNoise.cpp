@@ -0,0 +1,127 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "BlueNoise.h"
+
+// Standard deviation of the energy gaussian, in pixels
+const float SIGMA = 1.5f;
+
+// Fraction of the pixels set in the initial pattern
+const float INITIAL_DENSITY = 0.1f;
+
+BlueNoise::BlueNoise() : size_(0) {}
+
+void BlueNoise::Generate(int size, unsigned int seed) {
+  const int n = size * size;
+  size_ = size;
+  // Gaussian of the toroidal offset (dx, dy), at dx + size * dy
+  kernel_.assign(n, 0);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      float dx = std::min(x, size - x);
+      float dy = std::min(y, size - y);
+      kernel_[x + size * y] = exp(-(dx * dx + dy * dy) /
+                                  (2 * SIGMA * SIGMA));
+    }
+  }
+  energy_.assign(n, 0);
+  pattern_.assign(n, false);
+  values_.assign(n, 0);
+
+  // Random initial pattern, relaxed by moving the tightest cluster to the
+  // largest void until it is the pixel just removed
+  std::mt19937 random(seed);
+  int n_initial = std::max((int)(n * INITIAL_DENSITY), 1);
+  for (int count = 0; count < n_initial;) {
+    int pixel = random() % n;
+    if (!pattern_[pixel]) {
+      Toggle(pixel);
+      count++;
+    }
+  }
+  while (true) {
+    int cluster = FindTightestCluster();
+    Toggle(cluster);
+    int void_pixel = FindLargestVoid();
+    Toggle(void_pixel);
+    if (void_pixel == cluster)
+      break;
+  }
+  auto initial_pattern = pattern_;
+  auto initial_energy = energy_;
+
+  // The pixels of the initial pattern are ranked removing the tightest
+  // clusters, the others filling the largest voids
+  for (int rank = n_initial - 1; rank >= 0; --rank) {
+    int cluster = FindTightestCluster();
+    Toggle(cluster);
+    values_[cluster] = (float)rank / n;
+  }
+  pattern_ = initial_pattern;
+  energy_ = initial_energy;
+  for (int rank = n_initial; rank < n; ++rank) {
+    int void_pixel = FindLargestVoid();
+    Toggle(void_pixel);
+    values_[void_pixel] = (float)rank / n;
+  }
+}
+
+int BlueNoise::GetSize() const { return size_; }
+
+const std::vector<float>& BlueNoise::GetValues() const { return values_; }
+
+void BlueNoise::Toggle(int pixel) {
+  pattern_[pixel] = !pattern_[pixel];
+  float sign = pattern_[pixel] ? 1 : -1;
+  int px = pixel % size_;
+  int py = pixel / size_;
+  for (int y = 0; y < size_; ++y) {
+    const float *row = &kernel_[size_ * ((y - py + size_) % size_)];
+    for (int x = 0; x < size_; ++x)
+      energy_[x + size_ * y] += sign * row[(x - px + size_) % size_];
+  }
+}
+
+int BlueNoise::FindTightestCluster() const {
+  int best = -1;
+  for (int i = 0; i < (int)energy_.size(); ++i) {
+    if (pattern_[i] && (best < 0 || energy_[i] > energy_[best]))
+      best = i;
+  }
+  return best;
+}
+
+int BlueNoise::FindLargestVoid() const {
+  int best = -1;
+  for (int i = 0; i < (int)energy_.size(); ++i) {
+    if (!pattern_[i] && (best < 0 || energy_[i] < energy_[best]))
+      best = i;
+  }
+  return best;
+}
@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef BLUENOISE_H
+#define BLUENOISE_H
+
+#include <vector>
+
+/**
+ * Tileable blue noise generated with the void and cluster method (Ulichney):
+ * the pixels are ranked so that the ones below any threshold are evenly
+ * spread, without low frequencies, also across the borders of the tile. The
+ * energy of a pixel is the sum of a gaussian of the toroidal distance to the
+ * pixels already set; the tightest cluster is the set pixel of highest
+ * energy and the largest void the empty pixel of lowest energy
+ */
+class BlueNoise {
+public:
+  /**
+   * Default constructor
+   */
+  BlueNoise();
+
+  /**
+   * Ranks the pixels of a size x size tile; the seed chooses the initial
+   * pattern, so the same seed gives the same noise
+   */
+  void Generate(int size, unsigned int seed);
+
+  /**
+   * Obtains the number of pixels in each axis
+   */
+  int GetSize() const;
+
+  /**
+   * Obtains the noise of each pixel (row major), the rank of the pixel
+   * divided by the number of pixels, in [0, 1)
+   */
+  const std::vector<float>& GetValues() const;
+
+private:
+  /**
+   * Sets or clears a pixel and updates the energy of every pixel
+   */
+  void Toggle(int pixel);
+
+  /**
+   * Finds the set pixel of highest energy (tightest cluster) or the empty
+   * pixel of lowest energy (largest void)
+   */
+  int FindTightestCluster() const;
+  int FindLargestVoid() const;
+
+  int size_;
+  std::vector<float> kernel_;
+  std::vector<float> energy_;
+  std::vector<bool> pattern_;
+  std::vector<float> values_;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Bounds.h"
+
+// Jacobi sweeps used to diagonalize the covariance matrix
+const int MAX_JACOBI_SWEEPS = 32;
+
+Bounds::Bounds()
+    : box_{glm::vec3(0), glm::vec3(0)},
+      oriented_box_{glm::vec3(0), glm::mat3(1), glm::vec3(0)},
+      sphere_{glm::vec3(0), 0} {}
+
+void Bounds::AddMesh(const std::vector<float>& positions) {
+  float inf = std::numeric_limits<float>::infinity();
+  AxisAlignedBox box = {glm::vec3(inf), glm::vec3(-inf)};
+  for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+    glm::vec3 point(positions[i], positions[i + 1], positions[i + 2]);
+    box.min = glm::min(box.min, point);
+    box.max = glm::max(box.max, point);
+    points_.push_back(point);
+  }
+  mesh_boxes_.push_back(box);
+}
+
+void Bounds::Compute() {
+  if (points_.empty())
+    return;
+  box_ = mesh_boxes_[0];
+  for (auto& box : mesh_boxes_) {
+    box_.min = glm::min(box_.min, box.min);
+    box_.max = glm::max(box_.max, box.max);
+  }
+  ComputeSphere();
+  ComputeOrientedBox();
+}
+
+const std::vector<AxisAlignedBox>& Bounds::GetMeshBoxes() const {
+  return mesh_boxes_;
+}
+
+const AxisAlignedBox& Bounds::GetBox() const { return box_; }
+
+const OrientedBox& Bounds::GetOrientedBox() const { return oriented_box_; }
+
+const BoundingSphere& Bounds::GetSphere() const { return sphere_; }
+
+void Bounds::ComputeSphere() {
+  auto Farthest = [this](const glm::vec3& from) {
+    size_t farthest = 0;
+    float max_distance = -1;
+    for (size_t i = 0; i < points_.size(); ++i) {
+      float distance = glm::distance(from, points_[i]);
+      if (distance > max_distance) {
+        max_distance = distance;
+        farthest = i;
+      }
+    }
+    return points_[farthest];
+  };
+  auto y = Farthest(points_[0]);
+  auto z = Farthest(y);
+  sphere_.center = (y + z) * 0.5f;
+  sphere_.radius = glm::distance(y, z) * 0.5f;
+  for (auto& point : points_) {
+    float distance = glm::distance(sphere_.center, point);
+    if (distance > sphere_.radius) {
+      float radius = (sphere_.radius + distance) * 0.5f;
+      sphere_.center += (point - sphere_.center) *
+                        ((distance - radius) / distance);
+      sphere_.radius = radius;
+    }
+  }
+}
+
+void Bounds::ComputeOrientedBox() {
+  glm::vec3 mean(0);
+  for (auto& point : points_)
+    mean += point;
+  mean /= (float)points_.size();
+
+  glm::mat3 covariance(0);
+  for (auto& point : points_) {
+    auto d = point - mean;
+    covariance += glm::outerProduct(d, d);
+  }
+  covariance /= (float)points_.size();
+
+  glm::vec3 eigenvalues;
+  auto axes = ComputeEigenvectors(covariance, &eigenvalues);
+
+  // Sorts the axes by decreasing variance and makes the basis right-handed
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2 - i; ++j) {
+      if (eigenvalues[j] < eigenvalues[j + 1]) {
+        std::swap(eigenvalues[j], eigenvalues[j + 1]);
+        std::swap(axes[j], axes[j + 1]);
+      }
+    }
+  }
+  axes[2] = glm::cross(axes[0], axes[1]);
+
+  float inf = std::numeric_limits<float>::infinity();
+  glm::vec3 local_min(inf);
+  glm::vec3 local_max(-inf);
+  auto to_local = glm::transpose(axes);
+  for (auto& point : points_) {
+    auto local = to_local * point;
+    local_min = glm::min(local_min, local);
+    local_max = glm::max(local_max, local);
+  }
+  oriented_box_.axes = axes;
+  oriented_box_.center = axes * ((local_min + local_max) * 0.5f);
+  oriented_box_.half_extents = (local_max - local_min) * 0.5f;
+}
+
+glm::mat3 Bounds::ComputeEigenvectors(const glm::mat3& matrix,
+                                      glm::vec3 *eigenvalues) {
+  auto a = matrix;
+  glm::mat3 v(1);
+  for (int sweep = 0; sweep < MAX_JACOBI_SWEEPS; ++sweep) {
+    float off_diagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] +
+                         a[1][2] * a[1][2];
+    if (off_diagonal < 1e-20f)
+      break;
+    for (int p = 0; p < 2; ++p) {
+      for (int q = p + 1; q < 3; ++q) {
+        if (std::abs(a[p][q]) < 1e-20f)
+          continue;
+        // Rotation that zeroes a[p][q]
+        float theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        float t = (theta >= 0 ? 1 : -1) /
+                  (std::abs(theta) + std::sqrt(theta * theta + 1));
+        float c = 1 / std::sqrt(t * t + 1);
+        float s = t * c;
+        glm::mat3 rotation(1);
+        rotation[p][p] = c;
+        rotation[q][q] = c;
+        rotation[q][p] = s;
+        rotation[p][q] = -s;
+        a = glm::transpose(rotation) * a * rotation;
+        v = v * rotation;
+      }
+    }
+  }
+  *eigenvalues = glm::vec3(a[0][0], a[1][1], a[2][2]);
+  return v;
+}
@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Axis aligned bounding box
+ */
+struct AxisAlignedBox {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+/**
+ * Oriented bounding box; the columns of axes are the box axes, sorted by
+ * decreasing variance of the points, and they form a right-handed basis
+ */
+struct OrientedBox {
+  glm::vec3 center;
+  glm::mat3 axes;
+  glm::vec3 half_extents;
+};
+
+/**
+ * Bounding sphere
+ */
+struct BoundingSphere {
+  glm::vec3 center;
+  float radius;
+};
+
+/**
+ * Bounding volumes of the scene meshes, computed at load time
+ * Each mesh has its own axis aligned box; the whole scene has a bounding
+ * sphere (Ritter) and an oriented box fitted with principal component
+ * analysis of the vertices.
+ */
+class Bounds {
+public:
+  /**
+   * Default constructor
+   */
+  Bounds();
+
+  /**
+   * Adds the vertices of a mesh (x, y, z triplets) and computes its box
+   */
+  void AddMesh(const std::vector<float>& positions);
+
+  /**
+   * Fits the bounding sphere and the oriented box of every mesh added
+   */
+  void Compute();
+
+  /**
+   * Obtains the axis aligned box of each mesh
+   */
+  const std::vector<AxisAlignedBox>& GetMeshBoxes() const;
+
+  /**
+   * Obtains the axis aligned box of the scene
+   */
+  const AxisAlignedBox& GetBox() const;
+
+  /**
+   * Obtains the oriented box of the scene
+   */
+  const OrientedBox& GetOrientedBox() const;
+
+  /**
+   * Obtains the bounding sphere of the scene
+   */
+  const BoundingSphere& GetSphere() const;
+
+private:
+  /**
+   * Ritter's bounding sphere: starts with two distant points and grows the
+   * sphere to include the points left outside
+   */
+  void ComputeSphere();
+
+  /**
+   * Oriented box aligned with the eigenvectors of the points covariance
+   */
+  void ComputeOrientedBox();
+
+  /**
+   * Eigenvectors of a symmetric matrix (Jacobi rotations), as the columns
+   * of the result; the eigenvalues are returned in the same order
+   */
+  static glm::mat3 ComputeEigenvectors(const glm::mat3& matrix,
+                                       glm::vec3 *eigenvalues);
+
+  std::vector<glm::vec3> points_;
+  std::vector<AxisAlignedBox> mesh_boxes_;
+  AxisAlignedBox box_;
+  OrientedBox oriented_box_;
+  BoundingSphere sphere_;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "BrickVolume.h"
+#include "Parallel.h"
+#include "VoxelVolume.h"
+
+// First page table entry that references the pool
+const uint32_t FIRST_POOL_ENTRY = 2;
+
+const int BrickVolume::BRICK_SIZE;
+const int BrickVolume::BRICK_WORDS;
+const uint32_t BrickVolume::EMPTY_BRICK;
+const uint32_t BrickVolume::FULL_BRICK;
+
+BrickVolume::BrickVolume() : table_resolution_(0), n_empty_(0), n_full_(0) {}
+
+void BrickVolume::Build(const VoxelVolume& volume) {
+  const int n = volume.GetResolution() / BRICK_SIZE;
+  table_resolution_ = n;
+  table_.assign((size_t)n * n * n, EMPTY_BRICK);
+
+  // Each row of bricks along x is built by a task, with its own pool
+  std::vector<std::vector<uint32_t>> row_pools(n * n);
+  ParallelFor(n * n, [&](int row) {
+    int brick_y = row % n;
+    int brick_z = row / n;
+    int word = brick_z * BRICK_SIZE / 32;
+    int shift = brick_z * BRICK_SIZE % 32;
+    auto& row_pool = row_pools[row];
+    for (int brick_x = 0; brick_x < n; ++brick_x) {
+      uint32_t brick[BRICK_WORDS] = {0};
+      bool empty = true;
+      bool full = true;
+      for (int y = 0; y < BRICK_SIZE; ++y) {
+        for (int x = 0; x < BRICK_SIZE; ++x) {
+          uint32_t column = (volume.GetWord(brick_x * BRICK_SIZE + x,
+                                            brick_y * BRICK_SIZE + y, word) >>
+                             shift) & 0xFF;
+          empty = empty && column == 0;
+          full = full && column == 0xFF;
+          int byte = x + BRICK_SIZE * y;
+          brick[byte / 4] |= column << (byte % 4 * 8);
+        }
+      }
+      size_t entry = brick_x + (size_t)n * row;
+      if (empty) {
+        table_[entry] = EMPTY_BRICK;
+      } else if (full) {
+        table_[entry] = FULL_BRICK;
+      } else {
+        // Index inside the row pool, offset below
+        table_[entry] = FIRST_POOL_ENTRY + row_pool.size() / BRICK_WORDS;
+        row_pool.insert(row_pool.end(), brick, brick + BRICK_WORDS);
+      }
+    }
+  });
+
+  pool_.clear();
+  n_empty_ = 0;
+  n_full_ = 0;
+  for (int row = 0; row < n * n; ++row) {
+    uint32_t offset = pool_.size() / BRICK_WORDS;
+    for (int brick_x = 0; brick_x < n; ++brick_x) {
+      auto& entry = table_[brick_x + (size_t)n * row];
+      if (entry == EMPTY_BRICK)
+        n_empty_++;
+      else if (entry == FULL_BRICK)
+        n_full_++;
+      else
+        entry += offset;
+    }
+    pool_.insert(pool_.end(), row_pools[row].begin(), row_pools[row].end());
+  }
+}
+
+int BrickVolume::GetTableResolution() const { return table_resolution_; }
+
+const std::vector<uint32_t>& BrickVolume::GetTable() const { return table_; }
+
+const std::vector<uint32_t>& BrickVolume::GetPool() const { return pool_; }
+
+size_t BrickVolume::GetNumberOfEmptyBricks() const { return n_empty_; }
+
+size_t BrickVolume::GetNumberOfFullBricks() const { return n_full_; }
+
+size_t BrickVolume::GetNumberOfMixedBricks() const {
+  return pool_.size() / BRICK_WORDS;
+}
+
+size_t BrickVolume::GetSize() const {
+  return (table_.size() + pool_.size()) * sizeof(uint32_t);
+}
@@ -0,0 +1,106 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef BRICKVOLUME_H
+#define BRICKVOLUME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class VoxelVolume;
+
+/**
+ * Bricked copy of the slice map
+ * The volume is split in 8^3 voxel bricks. The page table has one entry per
+ * brick (x + n * (y + n * z)): 0 is an empty brick, 1 a full brick,
+ * otherwise the entry is the index of the brick in the pool plus 2. Each
+ * brick of the pool has 16 words; the 8 voxels of the column (x, y) of the
+ * brick are the byte x + 8 * y, the voxel z being its bit z.
+ */
+class BrickVolume {
+public:
+  /**
+   * Voxels in each axis of a brick
+   */
+  static const int BRICK_SIZE = 8;
+
+  /**
+   * Words of each brick of the pool
+   */
+  static const int BRICK_WORDS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE / 32;
+
+  /**
+   * Page table entries of the uniform bricks
+   */
+  static const uint32_t EMPTY_BRICK = 0;
+  static const uint32_t FULL_BRICK = 1;
+
+  /**
+   * Default constructor
+   */
+  BrickVolume();
+
+  /**
+   * Builds the page table and the pool from a volume
+   */
+  void Build(const VoxelVolume& volume);
+
+  /**
+   * Obtains the number of bricks in each axis
+   */
+  int GetTableResolution() const;
+
+  /**
+   * Obtains the page table
+   */
+  const std::vector<uint32_t>& GetTable() const;
+
+  /**
+   * Obtains the pool, BRICK_WORDS words per brick
+   */
+  const std::vector<uint32_t>& GetPool() const;
+
+  /**
+   * Obtains the number of bricks of each kind
+   */
+  size_t GetNumberOfEmptyBricks() const;
+  size_t GetNumberOfFullBricks() const;
+  size_t GetNumberOfMixedBricks() const;
+
+  /**
+   * Obtains the size of the page table and of the pool in bytes
+   */
+  size_t GetSize() const;
+
+private:
+  int table_resolution_;
+  std::vector<uint32_t> table_;
+  std::vector<uint32_t> pool_;
+  size_t n_empty_;
+  size_t n_full_;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "DistanceField.h"
+#include "Parallel.h"
+#include "VoxelVolume.h"
+
+// Squared distance of the cells that can't reach any occupied cell
+const float INF = 1e20f;
+
+// Distance used when the volume is empty (same as the gpu path)
+const float MAX_DISTANCE = 2.0f;
+
+// Intersection between the parabolas rooted at the cells q and p
+static float Intersection(const float *f, int q, int p) {
+  return ((f[q] + q * q) - (f[p] + p * p)) / (2.0f * (q - p));
+}
+
+DistanceField::DistanceField() : resolution_(0) {}
+
+void DistanceField::Init(int resolution) {
+  resolution_ = resolution;
+  distances_.assign((size_t)resolution * resolution * resolution, INF);
+}
+
+void DistanceField::Compute(const VoxelVolume& volume) {
+  ComputeOccupancy(volume);
+  TransformAxis(0);
+  TransformAxis(1);
+  TransformAxis(2);
+
+  // Both the point and the active voxel may be anywhere inside their cells
+  ParallelFor(resolution_, [this](int z) {
+    size_t slice = (size_t)resolution_ * resolution_;
+    for (size_t i = z * slice; i < (z + 1) * slice; ++i) {
+      if (distances_[i] >= INF) {
+        distances_[i] = MAX_DISTANCE;
+      } else {
+        float cells = std::sqrt(distances_[i]) - std::sqrt(3.0f);
+        distances_[i] = std::max(cells, 0.0f) / resolution_;
+      }
+    }
+  });
+}
+
+const float *DistanceField::GetData() const { return distances_.data(); }
+
+int DistanceField::GetResolution() const { return resolution_; }
+
+void DistanceField::ComputeOccupancy(const VoxelVolume& volume) {
+  int cell_size = volume.GetResolution() / resolution_;
+  int n_words = volume.GetResolution() / 32;
+  std::fill(distances_.begin(), distances_.end(), INF);
+
+  // Each task handles a row of cells; the rows don't share cells
+  ParallelFor(resolution_, [&](int cell_y) {
+    size_t row = (size_t)cell_y * resolution_;
+    for (int y = cell_y * cell_size; y < (cell_y + 1) * cell_size; ++y) {
+      for (int x = 0; x < volume.GetResolution(); ++x) {
+        size_t column = row + x / cell_size;
+        for (int word = 0; word < n_words; ++word) {
+          uint32_t bits = volume.GetWord(x, y, word);
+          while (bits) {
+            int z = word * 32 + __builtin_ctz(bits);
+            int cell_z = z / cell_size;
+            distances_[column + (size_t)cell_z * resolution_ * resolution_] = 0;
+            // Skips the remaining voxels of the cell inside this word
+            int next = std::min((cell_z + 1) * cell_size - word * 32, 32);
+            bits = next >= 32 ? 0 : bits & (0xFFFFFFFFu << next);
+          }
+        }
+      }
+    }
+  });
+}
+
+void DistanceField::TransformAxis(int axis) {
+  size_t n = resolution_;
+  size_t stride = axis == 0 ? 1 : axis == 1 ? n : n * n;
+
+  // Each task handles the n lines of a plane perpendicular to another axis
+  ParallelFor(n, [&](int plane) {
+    std::vector<float> f(n), z(n + 1);
+    std::vector<int> v(n);
+    for (size_t line = 0; line < n; ++line) {
+      size_t first = axis == 0 ? (plane * n + line) * n :
+                     axis == 1 ? plane * n * n + line :
+                                 plane * n + line;
+      for (size_t q = 0; q < n; ++q)
+        f[q] = distances_[first + q * stride];
+
+      // Lower envelope of the parabolas rooted at each cell
+      int k = 0;
+      v[0] = 0;
+      z[0] = -INF;
+      z[1] = INF;
+      for (int q = 1; q < (int)n; ++q) {
+        float s = Intersection(f.data(), q, v[k]);
+        while (s <= z[k]) {
+          k--;
+          s = Intersection(f.data(), q, v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INF;
+      }
+
+      k = 0;
+      for (int q = 0; q < (int)n; ++q) {
+        while (z[k + 1] < q)
+          k++;
+        float d = q - v[k];
+        distances_[first + q * stride] = std::min(d * d + f[v[k]], INF);
+      }
+    }
+  });
+}
@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <vector>
+
+class VoxelVolume;
+
+/**
+ * Low resolution unsigned distance field of a voxel volume, computed on the
+ * cpu with an exact euclidean distance transform
+ * Each cell covers (volume resolution / resolution)^3 voxels and it is
+ * occupied if any of them is active. The stored value is the distance that
+ * can be traveled from any point of the cell without reaching an active
+ * voxel, in slice map units (the volume is the unit cube).
+ */
+class DistanceField {
+public:
+  /**
+   * Default constructor
+   */
+  DistanceField();
+
+  /**
+   * Allocates the field with resolution^3 cells
+   */
+  void Init(int resolution);
+
+  /**
+   * Computes the field of the volume using all the cpu cores
+   */
+  void Compute(const VoxelVolume& volume);
+
+  /**
+   * Obtains the distances, x varies faster, then y, then z
+   */
+  const float *GetData() const;
+
+  /**
+   * Obtains the number of cells in each axis
+   */
+  int GetResolution() const;
+
+private:
+  /**
+   * Marks the occupied cells with 0 and the empty ones with infinity
+   */
+  void ComputeOccupancy(const VoxelVolume& volume);
+
+  /**
+   * Squared distance transform of every line along an axis
+   * Felzenszwalb and Huttenlocher, Distance Transforms of Sampled Functions
+   */
+  void TransformAxis(int axis);
+
+  int resolution_;
+  std::vector<float> distances_;
+};
+
+#endif
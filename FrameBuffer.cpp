@@ -23,6 +23,7 @@
  */
 
 #include <stdexcept>
+#include <utility>
 
 #include <GL/glew.h>
 
@@ -119,10 +120,24 @@ void FrameBuffer::Bind() {
 
 void FrameBuffer::Unbind() { glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); }
 
+int FrameBuffer::GetWidth() const { return width_; }
+
+int FrameBuffer::GetHeight() const { return height_; }
+
 const std::vector<unsigned int>& FrameBuffer::GetTextures() {
   return textures_;
 }
 
+void FrameBuffer::Swap(FrameBuffer& other) {
+  std::swap(width_, other.width_);
+  std::swap(height_, other.height_);
+  std::swap(framebuffer_, other.framebuffer_);
+  std::swap(depthbuffer_, other.depthbuffer_);
+  std::swap(current_texture_, other.current_texture_);
+  textures_.swap(other.textures_);
+  textures_infos_.swap(other.textures_infos_);
+}
+
 void FrameBuffer::UpdateDepthBufferSize(int width, int height) {
   glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer_);
   glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer_);
@@ -53,9 +53,16 @@ public:
   /// Binds the default buffer
   void Unbind();
 
+  /// Obtains the frame buffer size
+  int GetWidth() const;
+  int GetHeight() const;
+
   /// Obtains the render buffers textures
   const std::vector<unsigned int>& GetTextures();
 
+  /// Exchanges the buffers and the textures with another frame buffer
+  void Swap(FrameBuffer& other);
+
 private:
   /// Updates the depthbuffer size
   void UpdateDepthBufferSize(int width, int height);
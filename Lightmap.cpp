@@ -0,0 +1,196 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <lodepng.h>
+
+#include "Lightmap.h"
+#include "OcclusionBaker.h"
+#include "Parallel.h"
+#include "VoxelVolume.h"
+
+// Texels in each axis of the tiles baked by a task
+const int TILE_SIZE = 16;
+
+// Twice the signed area of the triangle (a, b, c)
+static float EdgeFunction(const glm::vec2& a, const glm::vec2& b,
+                          const glm::vec2& c) {
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+Lightmap::Lightmap() : width_(0), height_(0) {}
+
+void Lightmap::Init(int width, int height) {
+  width_ = width;
+  height_ = height;
+  size_t n = (size_t)width * height;
+  coverage_.assign(n, EMPTY);
+  points_.assign(n, glm::vec3(0));
+  normals_.assign(n, glm::vec3(0));
+  occlusion_.assign(n, 0);
+}
+
+void Lightmap::Rasterize(const std::vector<float>& positions,
+                         const std::vector<float>& normals,
+                         const std::vector<float>& texcoords,
+                         const std::vector<unsigned int>& indices,
+                         const glm::mat4& voxel_from_object) {
+  auto normal_matrix = glm::transpose(glm::inverse(
+      glm::mat3(voxel_from_object)));
+  auto size = glm::vec2(width_, height_);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    glm::vec2 uv[3];
+    glm::vec3 p[3], n[3];
+    for (int k = 0; k < 3; ++k) {
+      size_t v = indices[i + k];
+      uv[k] = glm::vec2(texcoords[2 * v], texcoords[2 * v + 1]) * size;
+      p[k] = glm::vec3(voxel_from_object *
+                       glm::vec4(positions[3 * v], positions[3 * v + 1],
+                                 positions[3 * v + 2], 1));
+      n[k] = normal_matrix * glm::vec3(normals[3 * v], normals[3 * v + 1],
+                                       normals[3 * v + 2]);
+    }
+    float area = EdgeFunction(uv[0], uv[1], uv[2]);
+    if (std::abs(area) < 1e-12f)
+      continue;
+
+    // Texels whose centre is inside the triangle (in any winding)
+    auto lo = glm::min(uv[0], glm::min(uv[1], uv[2])) - 0.5f;
+    auto hi = glm::max(uv[0], glm::max(uv[1], uv[2])) - 0.5f;
+    int x0 = (int)std::max(std::ceil(lo.x), 0.0f);
+    int y0 = (int)std::max(std::ceil(lo.y), 0.0f);
+    int x1 = (int)std::min(std::floor(hi.x), size.x - 1);
+    int y1 = (int)std::min(std::floor(hi.y), size.y - 1);
+    for (int y = y0; y <= y1; ++y) {
+      for (int x = x0; x <= x1; ++x) {
+        auto c = glm::vec2(x + 0.5f, y + 0.5f);
+        float w0 = EdgeFunction(uv[1], uv[2], c) / area;
+        float w1 = EdgeFunction(uv[2], uv[0], c) / area;
+        float w2 = 1 - w0 - w1;
+        auto normal = w0 * n[0] + w1 * n[1] + w2 * n[2];
+        if (w0 < 0 || w1 < 0 || w2 < 0 || glm::length(normal) < 1e-6f)
+          continue;
+        size_t texel = (size_t)y * width_ + x;
+        coverage_[texel] = COVERED;
+        points_[texel] = w0 * p[0] + w1 * p[1] + w2 * p[2];
+        normals_[texel] = glm::normalize(normal);
+      }
+    }
+  }
+}
+
+void Lightmap::Bake(const VoxelVolume& volume, const OcclusionBaker& baker) {
+  int tiles_x = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+  int tiles_y = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+  ParallelFor(tiles_x * tiles_y, [&](int tile) {
+    int x0 = tile % tiles_x * TILE_SIZE;
+    int y0 = tile / tiles_x * TILE_SIZE;
+    for (int y = y0; y < std::min(y0 + TILE_SIZE, height_); ++y) {
+      for (int x = x0; x < std::min(x0 + TILE_SIZE, width_); ++x) {
+        size_t texel = (size_t)y * width_ + x;
+        if (coverage_[texel] == COVERED)
+          occlusion_[texel] = baker.ComputeOcclusion(volume, points_[texel],
+                                                     normals_[texel]);
+      }
+    }
+  });
+}
+
+void Lightmap::Dilate(int padding) {
+  for (int i = 0; i < padding; ++i) {
+    // Each pass averages the filled neighbours of the previous one
+    auto coverage = coverage_;
+    auto occlusion = occlusion_;
+    ParallelFor(height_, [&](int y) {
+      for (int x = 0; x < width_; ++x) {
+        size_t texel = (size_t)y * width_ + x;
+        if (coverage[texel] != EMPTY)
+          continue;
+        float sum = 0;
+        int n = 0;
+        for (int dy = std::max(y - 1, 0); dy <= std::min(y + 1, height_ - 1);
+             ++dy) {
+          for (int dx = std::max(x - 1, 0);
+               dx <= std::min(x + 1, width_ - 1); ++dx) {
+            size_t neighbour = (size_t)dy * width_ + dx;
+            if (coverage[neighbour] != EMPTY) {
+              sum += occlusion[neighbour];
+              n++;
+            }
+          }
+        }
+        if (n > 0) {
+          occlusion_[texel] = sum / n;
+          coverage_[texel] = PADDED;
+        }
+      }
+    });
+  }
+}
+
+void Lightmap::SavePng(const std::string& path) const {
+  std::vector<unsigned char> image((size_t)width_ * height_);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      float value = 1 - occlusion_[(size_t)y * width_ + x];
+      value = std::min(std::max(value, 0.0f), 1.0f);
+      image[(size_t)(height_ - 1 - y) * width_ + x] =
+          (unsigned char)std::lround(value * 255);
+    }
+  }
+  unsigned error = lodepng::encode(path, image, width_, height_, LCT_GREY);
+  if (error)
+    throw std::runtime_error("Couldn't write the lightmap " + path + ": " +
+                             lodepng_error_text(error));
+}
+
+std::vector<unsigned char> Lightmap::LoadPng(const std::string& path,
+                                             int *width, int *height) {
+  std::vector<unsigned char> image;
+  unsigned w, h;
+  unsigned error = lodepng::decode(image, w, h, path, LCT_GREY);
+  if (error)
+    throw std::runtime_error("Couldn't read the lightmap " + path + ": " +
+                             lodepng_error_text(error));
+  std::vector<unsigned char> texels(image.size());
+  for (unsigned y = 0; y < h; ++y)
+    std::copy(image.begin() + (size_t)(h - 1 - y) * w,
+              image.begin() + (size_t)(h - y) * w,
+              texels.begin() + (size_t)y * w);
+  *width = w;
+  *height = h;
+  return texels;
+}
+
+int Lightmap::CountCoveredTexels() const {
+  return std::count(coverage_.begin(), coverage_.end(), COVERED);
+}
+
+int Lightmap::GetWidth() const { return width_; }
+
+int Lightmap::GetHeight() const { return height_; }
@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class OcclusionBaker;
+class VoxelVolume;
+
+/**
+ * Ambient occlusion baked in the texture space of a mesh
+ * The triangles are rasterized in their texture coordinates into a map from
+ * the texels to the surface (the point and the normal at the texel centre,
+ * in the voxel units of the volume). The occlusion of the covered texels is
+ * computed in tiles, which the cpu cores take from a shared queue, and it is
+ * dilated into the empty texels around the charts, so the filtering doesn't
+ * blend the empty texels in. The texel (x, y) has the texture coordinates
+ * ((x + 0.5) / width, (y + 0.5) / height).
+ */
+class Lightmap {
+public:
+  /**
+   * Default constructor
+   */
+  Lightmap();
+
+  /**
+   * Allocates an empty lightmap with width * height texels
+   */
+  void Init(int width, int height);
+
+  /**
+   * Rasterizes a mesh (x, y, z sequences of positions and normals, u, v
+   * sequences of texture coordinates and triangles indices); voxel_from_object
+   * maps the positions to the voxel units of the volume
+   */
+  void Rasterize(const std::vector<float>& positions,
+                 const std::vector<float>& normals,
+                 const std::vector<float>& texcoords,
+                 const std::vector<unsigned int>& indices,
+                 const glm::mat4& voxel_from_object);
+
+  /**
+   * Computes the occlusion of the covered texels, using all the cpu cores
+   */
+  void Bake(const VoxelVolume& volume, const OcclusionBaker& baker);
+
+  /**
+   * Extends the occlusion of the covered texels padding texels around them
+   */
+  void Dilate(int padding);
+
+  /**
+   * Writes the lightmap as a gray PNG, the value is 1 - occlusion and the
+   * first row is the top of the texture space (v = 1)
+   * Throws std::runtime_error if the file can't be written
+   */
+  void SavePng(const std::string& path) const;
+
+  /**
+   * Reads a lightmap written by SavePng, the first row of the texels is the
+   * bottom of the texture space (as the textures expect them)
+   * Throws std::runtime_error if the file can't be read
+   */
+  static std::vector<unsigned char> LoadPng(const std::string& path,
+                                            int *width, int *height);
+
+  /**
+   * Counts the texels covered by the triangles
+   */
+  int CountCoveredTexels() const;
+
+  /**
+   * Obtains the number of texels in each axis
+   */
+  int GetWidth() const;
+  int GetHeight() const;
+
+private:
+  /**
+   * State of a texel
+   */
+  enum Coverage { EMPTY, COVERED, PADDED };
+
+  int width_;
+  int height_;
+  std::vector<unsigned char> coverage_;
+  std::vector<glm::vec3> points_;
+  std::vector<glm::vec3> normals_;
+  std::vector<float> occlusion_;
+};
+
+#endif
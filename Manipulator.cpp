@@ -97,6 +97,10 @@ void Manipulator::MouseMotion(int x, int y) {
     y_ = y;
 }
 
+bool Manipulator::IsIdle() const {
+    return operation_ == Operation::kNone;
+}
+
 template<int k_button, Manipulator::Operation k_operation>
 void Manipulator::SetOperation(int button, int pressed, int x, int y) {
     if (button == k_button) {
@@ -65,6 +65,11 @@ public:
      */
     void MouseMotion(int x, int y);
 
+    /**
+     * Indicates whether no operation (rotation or zoom) is in progress
+     */
+    bool IsIdle() const;
+
 private:
     enum class Operation {
         kRotation,
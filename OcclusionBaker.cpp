@@ -0,0 +1,116 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "OcclusionBaker.h"
+#include "Parallel.h"
+#include "VoxelVolume.h"
+
+// Rays closer to the tangent plane are skipped (cosine of the angle with the
+// normal), they would start too far from the point
+const float MIN_ANGLE = 0.1f;
+
+// Points per task of the parallel loop
+const int BATCH_SIZE = 64;
+
+// Creates an orthonormal basis around the unit vector n (Duff et al.,
+// Building an Orthonormal Basis, Revisited)
+static void CreateBasis(const glm::vec3& n, glm::vec3 *t, glm::vec3 *b) {
+  float sign = std::copysign(1.0f, n.z);
+  float a = -1.0f / (sign + n.z);
+  float c = n.x * n.y * a;
+  *t = glm::vec3(1 + sign * n.x * n.x * a, sign * c, -sign * n.x);
+  *b = glm::vec3(c, sign + n.y * n.y * a, -n.y);
+}
+
+OcclusionBaker::OcclusionBaker() : cosine_(false), ray_length_(1) {}
+
+void OcclusionBaker::SetRays(const std::vector<glm::vec3>& rays,
+                             bool cosine) {
+  if ((int)rays.size() > MAX_RAYS)
+    throw std::runtime_error("Too many rays to bake the occlusion");
+  rays_ = rays;
+  cosine_ = cosine;
+}
+
+void OcclusionBaker::SetRayLength(float length) { ray_length_ = length; }
+
+float OcclusionBaker::ComputeOcclusion(const VoxelVolume& volume,
+                                       const glm::vec3& point,
+                                       const glm::vec3& normal) const {
+  glm::vec3 origins[MAX_RAYS], dirs[MAX_RAYS];
+  float max_distances[MAX_RAYS], starts[MAX_RAYS], weights[MAX_RAYS];
+  VoxelHit hits[MAX_RAYS];
+
+  glm::vec3 tangent, bitangent;
+  CreateBasis(normal, &tangent, &bitangent);
+  float size = (float)volume.GetResolution();
+  int n = 0;
+  for (auto& dir : rays_) {
+    auto ray = tangent * dir.x + bitangent * dir.y + normal * dir.z;
+    float angle = glm::dot(ray, normal);
+    if (angle < MIN_ANGLE)
+      continue;
+    // The rays that start outside of the volume don't hit anything, but
+    // they are still used
+    float d0 = std::sqrt(3.0f) / angle;
+    auto start = point + ray * d0;
+    bool inside = glm::all(glm::greaterThanEqual(start, glm::vec3(0))) &&
+                  glm::all(glm::lessThanEqual(start, glm::vec3(size)));
+    origins[n] = start;
+    dirs[n] = ray;
+    starts[n] = d0;
+    max_distances[n] = inside ? ray_length_ - d0 : 0;
+    weights[n] = cosine_ ? 0.5f : angle;
+    n++;
+  }
+  if (n == 0)
+    return 0;
+
+  volume.RaycastN(n, origins, dirs, max_distances, hits);
+  float acc_factor = 0;
+  for (int i = 0; i < n; ++i) {
+    if (hits[i].hit)
+      acc_factor += (1 - (starts[i] + hits[i].distance) / ray_length_) *
+                    weights[i];
+  }
+  return acc_factor / n;
+}
+
+void OcclusionBaker::Bake(const VoxelVolume& volume,
+                          const std::vector<glm::vec3>& points,
+                          const std::vector<glm::vec3>& normals,
+                          std::vector<float> *occlusion) const {
+  int n_points = (int)points.size();
+  occlusion->resize(n_points);
+  ParallelFor((n_points + BATCH_SIZE - 1) / BATCH_SIZE, [&](int batch) {
+    int end = std::min(n_points, (batch + 1) * BATCH_SIZE);
+    for (int i = batch * BATCH_SIZE; i < end; ++i)
+      (*occlusion)[i] = ComputeOcclusion(volume, points[i], normals[i]);
+  });
+}
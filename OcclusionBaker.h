@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef OCCLUSIONBAKER_H
+#define OCCLUSIONBAKER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class VoxelVolume;
+
+/**
+ * Computes the ambient occlusion of surface points on the cpu, with the
+ * semantics of march_ray (occlusion.glsl): each ray of the hemisphere of the
+ * normal starts sqrt(3) / cos voxels away from the point, the rays almost
+ * parallel to the surface are skipped, and a hit at the distance d weighs
+ * (1 - d / length) times the cosine (or 0.5 for a cosine distributed set).
+ * The occlusion is the average over the rays used. The points, the normals
+ * and the distances are in the voxel units of the volume.
+ */
+class OcclusionBaker {
+public:
+  /**
+   * Maximum number of rays of the set
+   */
+  static const int MAX_RAYS = 256;
+
+  /**
+   * Default constructor
+   */
+  OcclusionBaker();
+
+  /**
+   * Sets the hemisphere ray set (z is the normal) and whether it is cosine
+   * distributed
+   * Throws std::runtime_error if there are more than MAX_RAYS rays
+   */
+  void SetRays(const std::vector<glm::vec3>& rays, bool cosine);
+
+  /**
+   * Sets the length of the rays, in voxels
+   */
+  void SetRayLength(float length);
+
+  /**
+   * Computes the occlusion of a point; its rays are cast in packets of 4
+   * with VoxelVolume::RaycastN
+   */
+  float ComputeOcclusion(const VoxelVolume& volume, const glm::vec3& point,
+                         const glm::vec3& normal) const;
+
+  /**
+   * Computes the occlusion of every point, using all the cpu cores
+   */
+  void Bake(const VoxelVolume& volume, const std::vector<glm::vec3>& points,
+            const std::vector<glm::vec3>& normals,
+            std::vector<float> *occlusion) const;
+
+private:
+  std::vector<glm::vec3> rays_;
+  bool cosine_;
+  float ray_length_;
+};
+
+#endif
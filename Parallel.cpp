@@ -0,0 +1,56 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Parallel.h"
+
+// Limit of the worker threads, 0 if there is none
+static int max_threads = 0;
+
+int GetNumberOfThreads() {
+  if (max_threads > 0)
+    return max_threads;
+  return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void SetNumberOfThreads(int n) { max_threads = n; }
+
+void ParallelFor(int n, const std::function<void(int)>& task) {
+  std::atomic<int> next(0);
+  auto worker = [&]() {
+    for (int i = next++; i < n; i = next++)
+      task(i);
+  };
+  int n_threads = std::min(GetNumberOfThreads(), n);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < n_threads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+}
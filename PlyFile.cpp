@@ -0,0 +1,152 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+
+#include "PlyFile.h"
+
+// Appends the bytes of a value to the buffer
+template <typename T>
+static void Append(std::vector<unsigned char> *buffer, T value) {
+  auto bytes = reinterpret_cast<const unsigned char *>(&value);
+  buffer->insert(buffer->end(), bytes, bytes + sizeof(value));
+}
+
+// Size of a property type, 0 if it is unknown
+static int GetTypeSize(const std::string& type) {
+  for (auto name : {"char", "uchar", "int8", "uint8"})
+    if (type == name) return 1;
+  for (auto name : {"short", "ushort", "int16", "uint16"})
+    if (type == name) return 2;
+  for (auto name : {"int", "uint", "float", "int32", "uint32", "float32"})
+    if (type == name) return 4;
+  for (auto name : {"double", "float64"})
+    if (type == name) return 8;
+  return 0;
+}
+
+void SaveOcclusionPly(const std::string& path,
+                      const std::vector<float>& positions,
+                      const std::vector<float>& normals,
+                      const std::vector<unsigned int>& indices,
+                      const std::vector<float>& occlusion, float strength) {
+  auto file = fopen(path.c_str(), "wb");
+  if (!file)
+    throw std::runtime_error("Couldn't create the PLY file: " + path);
+  size_t n_vertices = occlusion.size();
+  fprintf(file, "ply\nformat binary_little_endian 1.0\n"
+                "comment baked ambient occlusion\n"
+                "element vertex %zu\n"
+                "property float x\nproperty float y\nproperty float z\n"
+                "property float nx\nproperty float ny\nproperty float nz\n"
+                "property uchar red\nproperty uchar green\n"
+                "property uchar blue\nproperty float occlusion\n"
+                "element face %zu\n"
+                "property list uchar uint vertex_indices\nend_header\n",
+          n_vertices, indices.size() / 3);
+
+  std::vector<unsigned char> buffer;
+  for (size_t i = 0; i < n_vertices; ++i) {
+    for (int j = 0; j < 3; ++j)
+      Append(&buffer, positions[3 * i + j]);
+    for (int j = 0; j < 3; ++j)
+      Append(&buffer, normals[3 * i + j]);
+    float light = std::min(std::max(1 - strength * occlusion[i], 0.0f), 1.0f);
+    auto gray = (unsigned char)std::lround(light * 255);
+    for (int j = 0; j < 3; ++j)
+      Append(&buffer, gray);
+    Append(&buffer, occlusion[i]);
+  }
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    Append(&buffer, (unsigned char)3);
+    for (int j = 0; j < 3; ++j)
+      Append(&buffer, (uint32_t)indices[i + j]);
+  }
+  fwrite(buffer.data(), 1, buffer.size(), file);
+  bool failed = ferror(file);
+  fclose(file);
+  if (failed)
+    throw std::runtime_error("Couldn't write the PLY file: " + path);
+}
+
+std::vector<float> LoadOcclusionPly(const std::string& path) {
+  auto file = fopen(path.c_str(), "rb");
+  if (!file)
+    throw std::runtime_error("Couldn't open the PLY file: " + path);
+  auto fail = [&](const std::string& message) {
+    fclose(file);
+    throw std::runtime_error(message + ": " + path);
+  };
+
+  // The vertices must be the first element, so only their properties are
+  // needed to find the occlusion
+  char line[256];
+  if (!fgets(line, sizeof(line), file) || strcmp(line, "ply\n") != 0)
+    fail("Invalid PLY file");
+  size_t n_vertices = 0;
+  int stride = 0, offset = -1;
+  bool little_endian = false, vertex_element = false, first = true;
+  while (fgets(line, sizeof(line), file) && strcmp(line, "end_header\n")) {
+    char a[64], b[64], c[64];
+    unsigned long count;
+    if (sscanf(line, "format %63s", a) == 1) {
+      little_endian = strcmp(a, "binary_little_endian") == 0;
+    } else if (sscanf(line, "element %63s %lu", a, &count) == 2) {
+      vertex_element = first && strcmp(a, "vertex") == 0;
+      if (vertex_element)
+        n_vertices = count;
+      first = false;
+    } else if (vertex_element && sscanf(line, "property %63s", a) == 1) {
+      if (strcmp(a, "list") == 0)
+        fail("PLY vertices with lists aren't supported");
+      if (sscanf(line, "property %63s %63s %63s", a, b, c) != 2 ||
+          GetTypeSize(a) == 0)
+        fail("Invalid PLY property");
+      if (strcmp(b, "occlusion") == 0 && GetTypeSize(a) == 4 &&
+          strstr(a, "float"))
+        offset = stride;
+      stride += GetTypeSize(a);
+    }
+  }
+  if (!little_endian)
+    fail("The PLY file must be binary little endian");
+  if (n_vertices == 0 || offset < 0)
+    fail("The PLY vertices have no float occlusion");
+
+  std::vector<unsigned char> vertices(n_vertices * stride);
+  if (fread(vertices.data(), stride, n_vertices, file) != n_vertices)
+    fail("Truncated PLY file");
+  fclose(file);
+  std::vector<float> occlusion(n_vertices);
+  for (size_t i = 0; i < n_vertices; ++i)
+    memcpy(&occlusion[i], &vertices[i * stride + offset], sizeof(float));
+  return occlusion;
+}
@@ -0,0 +1,58 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PLYFILE_H
+#define PLYFILE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * Meshes with baked ambient occlusion in the binary little endian PLY format
+ * The vertices have the float properties x, y, z, nx, ny, nz and occlusion
+ * (the occlusion factor, as computed by the occlusion pass) and the uchar
+ * colors red, green and blue, which show the shaded occlusion in the mesh
+ * viewers. The faces are triangles. They throw std::runtime_error if the
+ * file can't be written or read.
+ */
+
+/**
+ * Writes a mesh (x, y, z sequences of positions and normals, and triangles
+ * indices) with the occlusion of its vertices; the colors are the ambient
+ * light of the lightpass, 1 - strength * occlusion
+ */
+void SaveOcclusionPly(const std::string& path,
+                      const std::vector<float>& positions,
+                      const std::vector<float>& normals,
+                      const std::vector<unsigned int>& indices,
+                      const std::vector<float>& occlusion, float strength);
+
+/**
+ * Reads the occlusion property of the vertices of a binary little endian
+ * PLY file, the other properties and elements are skipped
+ */
+std::vector<float> LoadOcclusionPly(const std::string& path);
+
+#endif
@@ -31,13 +31,17 @@
 
 #include "ShaderProgram.h"
 
-ShaderProgram::ShaderProgram() : program_(0), vs_(0), fs_(0) {}
+ShaderProgram::ShaderProgram() : program_(0), vs_(0), gs_(0), fs_(0), cs_(0) {}
 
 ShaderProgram::~ShaderProgram() {
   if (vs_)
     glDeleteShader(vs_);
+  if (gs_)
+    glDeleteShader(gs_);
   if (fs_)
     glDeleteShader(fs_);
+  if (cs_)
+    glDeleteShader(cs_);
   if (program_)
     glDeleteProgram(program_);
 }
@@ -46,22 +50,40 @@ void ShaderProgram::LoadVertexShader(const std::string& path) {
   CompileShader(&vs_, GL_VERTEX_SHADER, path);
 }
 
+void ShaderProgram::LoadGeometryShader(const std::string& path) {
+  CompileShader(&gs_, GL_GEOMETRY_SHADER, path);
+}
+
 void ShaderProgram::LoadFragmentShader(const std::string& path) {
   CompileShader(&fs_, GL_FRAGMENT_SHADER, path);
 }
 
+void ShaderProgram::LoadComputeShader(const std::string& path) {
+  CompileShader(&cs_, GL_COMPUTE_SHADER, path);
+}
+
 void ShaderProgram::LinkShader() {
-  if (!vs_ || !fs_)
-    throw new std::runtime_error("Vertex or fragment not loaded");
+  if (!cs_ && (!vs_ || !fs_))
+    throw std::runtime_error("Vertex or fragment not loaded");
 
   program_ = glCreateProgram();
-  glAttachShader(program_, vs_);
-  glAttachShader(program_, fs_);
+  if (cs_) {
+    glAttachShader(program_, cs_);
+  } else {
+    glAttachShader(program_, vs_);
+    if (gs_)
+      glAttachShader(program_, gs_);
+    glAttachShader(program_, fs_);
+  }
   glLinkProgram(program_);
   glDeleteShader(vs_);
   vs_ = 0;
+  glDeleteShader(gs_);
+  gs_ = 0;
   glDeleteShader(fs_);
   fs_ = 0;
+  glDeleteShader(cs_);
+  cs_ = 0;
 
   int success = 0;
   glGetProgramiv(program_, GL_LINK_STATUS, &success);
@@ -97,6 +119,12 @@ void ShaderProgram::SetUniform(const std::string& name, float value) {
   glUniform1f(location, value);
 }
 
+void ShaderProgram::SetUniform(const std::string& name,
+                               const glm::ivec2& value) {
+  GLuint location = glGetUniformLocation(program_, name.c_str());
+  glUniform2iv(location, 1, glm::value_ptr(value));
+}
+
 void ShaderProgram::SetUniform(const std::string& name,
                                const glm::vec3& value) {
   GLuint location = glGetUniformLocation(program_, name.c_str());
@@ -129,6 +157,19 @@ void ShaderProgram::SetTexture2D(const std::string& name, int sampler_id,
   SetUniform(name, sampler_id);
 }
 
+void ShaderProgram::SetTexture3D(const std::string& name, int sampler_id,
+                                 int texture_id) {
+  glActiveTexture(GL_TEXTURE0 + sampler_id);
+  glBindTexture(GL_TEXTURE_3D, texture_id);
+  SetUniform(name, sampler_id);
+}
+
+void ShaderProgram::SetImage(const std::string& name, int unit, int texture_id,
+                             int access, int format, bool layered) {
+  glBindImageTexture(unit, texture_id, 0, layered, 0, access, format);
+  SetUniform(name, unit);
+}
+
 void ShaderProgram::SetUniformBuffer(const std::string& name, int binding_point,
                                      unsigned int buffer_id) {
   auto block_index = glGetUniformBlockIndex(program_, name.c_str());
@@ -136,6 +177,18 @@ void ShaderProgram::SetUniformBuffer(const std::string& name, int binding_point,
   glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, buffer_id);
 }
 
+void ShaderProgram::SetStorageBuffer(const std::string& name, int binding_point,
+                                     unsigned int buffer_id) {
+  auto block_index = glGetProgramResourceIndex(
+      program_, GL_SHADER_STORAGE_BLOCK, name.c_str());
+  glShaderStorageBlockBinding(program_, block_index, binding_point);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_point, buffer_id);
+}
+
+void ShaderProgram::Dispatch(int n_x, int n_y, int n_z) {
+  glDispatchCompute(n_x, n_y, n_z);
+}
+
 unsigned int ShaderProgram::GetHandle() { return program_; }
 
 std::string ShaderProgram::ReadFile(const std::string& path) {
@@ -146,6 +199,18 @@ std::string ShaderProgram::ReadFile(const std::string& path) {
   while (!input.eof()) {
     char line[1024];
     input.getline(line, 1024);
+    // The included files are relative to the directory of the shader
+    std::string text = line;
+    const std::string directive = "#include \"";
+    if (text.compare(0, directive.size(), directive) == 0) {
+      auto end = text.find('"', directive.size());
+      if (end == std::string::npos)
+        throw std::runtime_error("Invalid include in file: " + path);
+      auto directory = path.substr(0, path.find_last_of('/') + 1);
+      auto name = text.substr(directive.size(), end - directive.size());
+      output = output + ReadFile(directory + name);
+      continue;
+    }
     output = output + line + "\n";
   }
   return output;
@@ -49,11 +49,22 @@ public:
    */
   void LoadVertexShader(const std::string& path);
 
+  /**
+   * Loads and compiles the geometry program (optional)
+   */
+  void LoadGeometryShader(const std::string& path);
+
   /**
    * Loads and compiles the fragment program
    */
   void LoadFragmentShader(const std::string& path);
 
+  /**
+   * Loads and compiles the compute program
+   * A program with a compute shader can't have other stages
+   */
+  void LoadComputeShader(const std::string& path);
+
   /**
    * Links the shader program
    */
@@ -76,6 +87,7 @@ public:
   void SetUniform(const std::string& name, bool value);
   void SetUniform(const std::string& name, int value);
   void SetUniform(const std::string& name, float value);
+  void SetUniform(const std::string& name, const glm::ivec2& value);
   void SetUniform(const std::string& name, const glm::vec3& value);
   void SetUniform(const std::string& name, const glm::vec4& value);
   void SetUniform(const std::string& name, const glm::mat4& value);
@@ -85,6 +97,14 @@ public:
    */
   void SetTexture1D(const std::string& name, int sampler_id, int texture_id);
   void SetTexture2D(const std::string& name, int sampler_id, int texture_id);
+  void SetTexture3D(const std::string& name, int sampler_id, int texture_id);
+
+  /**
+   * Binds a texture to an image unit
+   * Layered textures (3D and arrays) are bound with all their layers
+   */
+  void SetImage(const std::string& name, int unit, int texture_id, int access,
+                int format, bool layered = false);
 
   /**
    * Binds an uniform buffer
@@ -92,6 +112,17 @@ public:
   void SetUniformBuffer(const std::string& name, int binding_point,
                         unsigned int buffer_id);
 
+  /**
+   * Binds a shader storage buffer
+   */
+  void SetStorageBuffer(const std::string& name, int binding_point,
+                        unsigned int buffer_id);
+
+  /**
+   * Runs the compute program with n_x * n_y * n_z work groups
+   */
+  void Dispatch(int n_x, int n_y = 1, int n_z = 1);
+
   /**
    * Obtains the shader program handle
    */
@@ -100,6 +131,7 @@ public:
 private:
   /**
    * Reads the whole file and returns it as a string
+   * The lines #include "file" are replaced by the file (shader libraries)
    */
   std::string ReadFile(const std::string& path);
 
@@ -111,7 +143,9 @@ private:
 
   unsigned int program_;
   unsigned int vs_;
+  unsigned int gs_;
   unsigned int fs_;
+  unsigned int cs_;
 };
 
 #endif
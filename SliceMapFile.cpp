@@ -0,0 +1,222 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <GL/glew.h>
+#include <fcntl.h>
+#include <lodepng.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Parallel.h"
+#include "SliceMapFile.h"
+#include "VoxelVolume.h"
+
+// File identification
+const char MAGIC[8] = {'S', 'L', 'I', 'C', 'E', 'M', 'A', 'P'};
+const uint32_t VERSION = 1;
+
+// The volume starts at a page boundary, so it can be used from the mapping
+const uint64_t PAGE_SIZE = 4096;
+
+// Rows of a texture compressed together
+const uint32_t CHUNK_ROWS = 64;
+
+// Words stored in each slice map texel
+const int WORDS_PER_TEXEL = 4;
+
+// Rounds up to the next page boundary
+static uint64_t AlignToPage(uint64_t offset) {
+  return (offset + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+SliceMapFile::SliceMapFile() : data_(nullptr), size_(0) {}
+
+SliceMapFile::~SliceMapFile() { Close(); }
+
+void SliceMapFile::Save(const std::string& path, const VoxelVolume& volume,
+                        const glm::mat4& projection,
+                        Compression compression) {
+  uint32_t resolution = volume.GetResolution();
+  size_t chunk_size = (size_t)resolution * CHUNK_ROWS * WORDS_PER_TEXEL *
+                      sizeof(uint32_t);
+
+  Header header;
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.resolution = resolution;
+  header.n_textures = resolution / 128;
+  header.compression = compression;
+  header.chunk_rows = CHUNK_ROWS;
+  header.n_chunks = 0;
+  memcpy(header.projection, &projection[0][0], sizeof(header.projection));
+  header.data_offset = AlignToPage(sizeof(Header));
+
+  auto bytes = reinterpret_cast<const unsigned char *>(volume.GetData());
+  std::vector<std::vector<unsigned char>> compressed;
+  std::vector<Chunk> chunks;
+  if (compression == COMPRESSION_ZLIB) {
+    header.n_chunks = volume.GetSize() / chunk_size;
+    compressed.resize(header.n_chunks);
+    ParallelFor(header.n_chunks, [&](int i) {
+      lodepng::compress(compressed[i], bytes + i * chunk_size, chunk_size);
+    });
+    uint64_t offset = AlignToPage(sizeof(Header) +
+                                  header.n_chunks * sizeof(Chunk));
+    header.data_offset = offset;
+    for (auto& data : compressed) {
+      chunks.push_back({offset, data.size()});
+      offset += data.size();
+    }
+  }
+  auto file = fopen(path.c_str(), "wb");
+  if (!file)
+    throw std::runtime_error("Couldn't create the slice map file: " + path);
+  std::vector<unsigned char> padding(header.data_offset, 0);
+  memcpy(padding.data(), &header, sizeof(Header));
+  if (!chunks.empty())
+    memcpy(padding.data() + sizeof(Header), chunks.data(),
+           chunks.size() * sizeof(Chunk));
+  bool ok = fwrite(padding.data(), 1, padding.size(), file) == padding.size();
+  if (compression == COMPRESSION_ZLIB) {
+    for (auto& data : compressed)
+      ok = ok && fwrite(data.data(), 1, data.size(), file) == data.size();
+  } else {
+    ok = ok && fwrite(bytes, 1, volume.GetSize(), file) == volume.GetSize();
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok)
+    throw std::runtime_error("Couldn't write the slice map file: " + path);
+}
+
+void SliceMapFile::Open(const std::string& path) {
+  Close();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Couldn't open the slice map file: " + path);
+  struct stat status;
+  if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(Header)) {
+    close(fd);
+    throw std::runtime_error("Invalid slice map file: " + path);
+  }
+  size_ = status.st_size;
+  void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    size_ = 0;
+    throw std::runtime_error("Couldn't map the slice map file: " + path);
+  }
+  data_ = static_cast<const unsigned char *>(data);
+  madvise(data, size_, MADV_SEQUENTIAL);
+
+  auto& header = GetHeader();
+  size_t volume_size = (size_t)header.resolution * header.resolution *
+                       header.resolution / 8;
+  size_t table_end = sizeof(Header) + header.n_chunks * sizeof(Chunk);
+  bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+               header.version == VERSION && header.resolution % 128 == 0 &&
+               header.n_textures == header.resolution / 128 &&
+               header.data_offset <= size_;
+  if (valid && header.compression == COMPRESSION_NONE)
+    valid = header.data_offset + volume_size <= size_;
+  else if (valid && header.compression == COMPRESSION_ZLIB)
+    valid = table_end <= size_ && header.n_chunks * header.chunk_rows ==
+                                      header.n_textures * header.resolution;
+  else
+    valid = false;
+  if (!valid) {
+    Close();
+    throw std::runtime_error("Invalid slice map file: " + path);
+  }
+}
+
+void SliceMapFile::Close() {
+  if (data_)
+    munmap(const_cast<unsigned char *>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void SliceMapFile::WriteToTextures(const std::vector<unsigned int>& textures) {
+  auto& header = GetHeader();
+  int resolution = header.resolution;
+  size_t texture_size = (size_t)resolution * resolution * WORDS_PER_TEXEL *
+                        sizeof(uint32_t);
+  std::vector<unsigned char> buffer;
+  if (header.compression == COMPRESSION_ZLIB)
+    buffer.resize(texture_size);
+  auto chunks = reinterpret_cast<const Chunk *>(data_ + sizeof(Header));
+  int chunks_per_texture = resolution / header.chunk_rows;
+  size_t chunk_size = texture_size / chunks_per_texture;
+
+  for (size_t i = 0; i < textures.size(); ++i) {
+    const unsigned char *pixels = data_ + header.data_offset +
+                                  i * texture_size;
+    if (header.compression == COMPRESSION_ZLIB) {
+      std::atomic<bool> failed(false);
+      ParallelFor(chunks_per_texture, [&](int j) {
+        auto& chunk = chunks[i * chunks_per_texture + j];
+        std::vector<unsigned char> out;
+        if (chunk.offset + chunk.size > size_ ||
+            lodepng::decompress(out, data_ + chunk.offset, chunk.size) ||
+            out.size() != chunk_size) {
+          failed = true;
+          return;
+        }
+        memcpy(buffer.data() + j * chunk_size, out.data(), chunk_size);
+      });
+      if (failed)
+        throw std::runtime_error("Corrupted slice map chunk");
+      pixels = buffer.data();
+    }
+    glBindTexture(GL_TEXTURE_2D, textures[i]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, resolution, resolution,
+                    GL_RGBA_INTEGER, GL_UNSIGNED_INT, pixels);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+int SliceMapFile::GetResolution() const { return GetHeader().resolution; }
+
+glm::mat4 SliceMapFile::GetProjection() const {
+  glm::mat4 projection;
+  memcpy(&projection[0][0], GetHeader().projection, sizeof(float) * 16);
+  return projection;
+}
+
+SliceMapFile::Compression SliceMapFile::GetCompression() const {
+  return (Compression)GetHeader().compression;
+}
+
+size_t SliceMapFile::GetFileSize() const { return size_; }
+
+const SliceMapFile::Header& SliceMapFile::GetHeader() const {
+  return *reinterpret_cast<const Header *>(data_);
+}
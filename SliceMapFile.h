@@ -0,0 +1,142 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SLICEMAPFILE_H
+#define SLICEMAPFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class VoxelVolume;
+
+/**
+ * Slice map file (.slicemap)
+ * A fixed header with the resolution and the voxelization projection is
+ * followed by the volume, in the word order of VoxelVolume (which is the
+ * order of the slice map textures). The volume starts at a page boundary,
+ * so uncompressed files are memory mapped and sent to the textures without
+ * any parsing. Compressed files split each texture in chunks of rows,
+ * compressed with zlib and listed in a table after the header; the chunks
+ * are decompressed in parallel. Values are stored in the machine byte order.
+ */
+class SliceMapFile {
+public:
+  /**
+   * Compression of the volume chunks
+   */
+  enum Compression { COMPRESSION_NONE, COMPRESSION_ZLIB };
+
+  /**
+   * Default constructor
+   */
+  SliceMapFile();
+
+  /**
+   * Destructor, unmaps the file
+   */
+  ~SliceMapFile();
+
+  /**
+   * Writes a volume and the projection used to voxelize it
+   * Throws std::runtime_error if the file can't be written
+   */
+  static void Save(const std::string& path, const VoxelVolume& volume,
+                   const glm::mat4& projection, Compression compression);
+
+  /**
+   * Maps a file in memory and verifies its header
+   * Throws std::runtime_error if the file is invalid
+   */
+  void Open(const std::string& path);
+
+  /**
+   * Unmaps the file
+   */
+  void Close();
+
+  /**
+   * Copies the volume to the slice map textures, which must have the file
+   * resolution
+   */
+  void WriteToTextures(const std::vector<unsigned int>& textures);
+
+  /**
+   * Obtains the number of voxels in each axis
+   */
+  int GetResolution() const;
+
+  /**
+   * Obtains the projection used to voxelize the volume
+   */
+  glm::mat4 GetProjection() const;
+
+  /**
+   * Obtains the compression of the chunks
+   */
+  Compression GetCompression() const;
+
+  /**
+   * Obtains the size of the file in bytes
+   */
+  size_t GetFileSize() const;
+
+private:
+  /**
+   * File header, the volume (or the chunk table) comes after it
+   */
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t resolution;
+    uint32_t n_textures;
+    uint32_t compression;
+    uint32_t chunk_rows;
+    uint32_t n_chunks;
+    float projection[16];
+    uint64_t data_offset;
+  };
+
+  /**
+   * Position of a compressed chunk in the file
+   */
+  struct Chunk {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  /**
+   * Obtains the header of the mapped file
+   */
+  const Header& GetHeader() const;
+
+  const unsigned char *data_;
+  size_t size_;
+};
+
+#endif
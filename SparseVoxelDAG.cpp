@@ -0,0 +1,367 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "Parallel.h"
+#include "SparseVoxelDAG.h"
+#include "VoxelVolume.h"
+
+// Entries of the uniform children
+const uint32_t EMPTY = 0;
+const uint32_t FULL = 1;
+
+// Voxels in each axis of a brick
+const int BRICK_SIZE = 4;
+
+// Subtrees decoded by each task, large enough to write whole words
+const int DECODE_TASK_SIZE = 256;
+
+// File identification
+const char MAGIC[8] = {'S', 'V', 'D', 'A', 'G', 0, 0, 0};
+const uint32_t VERSION = 1;
+
+// Start of a .svdag file, followed by the DAG array
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t resolution;
+  uint32_t root;
+  uint32_t padding;
+  uint64_t n_tree_nodes;
+  uint64_t n_tree_bricks;
+  uint64_t n_nodes;
+  uint64_t n_bricks;
+  uint64_t n_words;
+  float projection[16];
+};
+
+// Children of an internal node
+typedef std::array<uint32_t, 8> Children;
+
+// FNV-1a hash of the children entries
+struct ChildrenHash {
+  size_t operator()(const Children& children) const {
+    uint64_t hash = 14695981039346656037ull;
+    for (auto child : children)
+      hash = (hash ^ child) * 1099511628211ull;
+    return hash;
+  }
+};
+
+SparseVoxelDAG::SparseVoxelDAG()
+    : resolution_(0),
+      root_(EMPTY),
+      n_tree_nodes_(0),
+      n_tree_bricks_(0),
+      n_nodes_(0),
+      n_bricks_(0) {}
+
+void SparseVoxelDAG::Build(const VoxelVolume& volume) {
+  resolution_ = volume.GetResolution();
+  const int n = resolution_ / BRICK_SIZE;
+  const int n_words = resolution_ / 32;
+  const int bricks_per_word = 32 / BRICK_SIZE;
+
+  // Gathers the bricks; each task handles a row of bricks
+  std::vector<uint64_t> bricks((size_t)n * n * n, 0);
+  ParallelFor(n, [&](int brick_y) {
+    for (int vy = brick_y * BRICK_SIZE; vy < (brick_y + 1) * BRICK_SIZE;
+         ++vy) {
+      for (int vx = 0; vx < resolution_; ++vx) {
+        int column_idx = vx % BRICK_SIZE + BRICK_SIZE * (vy % BRICK_SIZE);
+        int shift = BRICK_SIZE * column_idx;
+        size_t row = ((size_t)brick_y * n) + vx / BRICK_SIZE;
+        for (int word = 0; word < n_words; ++word) {
+          uint32_t bits = volume.GetWord(vx, vy, word);
+          for (int i = 0; bits != 0; ++i, bits >>= BRICK_SIZE) {
+            uint64_t column = bits & 0xF;
+            if (!column) continue;
+            size_t brick_z = word * bricks_per_word + i;
+            bricks[row + brick_z * n * n] |= column << shift;
+          }
+        }
+      }
+    }
+  });
+
+  // The first words are never referenced, so offsets don't clash with the
+  // uniform entries
+  nodes_.assign(2, 0);
+  n_tree_nodes_ = 0;
+  n_tree_bricks_ = 0;
+  n_nodes_ = 0;
+  n_bricks_ = 0;
+
+  // Stores each distinct mixed brick once
+  std::unordered_map<uint64_t, uint32_t> unique_bricks;
+  std::vector<uint32_t> entries(bricks.size());
+  for (size_t i = 0; i < bricks.size(); ++i) {
+    if (bricks[i] == 0) {
+      entries[i] = EMPTY;
+    } else if (bricks[i] == ~0ull) {
+      entries[i] = FULL;
+    } else {
+      n_tree_bricks_++;
+      auto inserted = unique_bricks.emplace(bricks[i], nodes_.size());
+      if (inserted.second) {
+        nodes_.push_back(bricks[i] & 0xFFFFFFFF);
+        nodes_.push_back(bricks[i] >> 32);
+        n_bricks_++;
+      }
+      entries[i] = inserted.first->second;
+    }
+  }
+  bricks.clear();
+  bricks.shrink_to_fit();
+
+  for (int size = n; size > 1; size /= 2)
+    entries = ReduceLevel(entries, size);
+  root_ = entries[0];
+  nodes_.shrink_to_fit();
+}
+
+void SparseVoxelDAG::Decode(VoxelVolume *volume) const {
+  volume->Init(resolution_);
+
+  // Expands the top of the DAG into independent subtrees
+  struct Task {
+    uint32_t entry;
+    int x, y, z;
+  };
+  int task_size = std::min(resolution_, DECODE_TASK_SIZE);
+  std::vector<Task> tasks(1, Task{root_, 0, 0, 0});
+  for (int size = resolution_; size > task_size; size /= 2) {
+    std::vector<Task> children;
+    for (const auto& task : tasks) {
+      if (task.entry == EMPTY) continue;
+      for (int i = 0; i < 8; ++i) {
+        uint32_t child = task.entry == FULL ? FULL : nodes_[task.entry + i];
+        children.push_back(Task{child, task.x + (i & 1) * size / 2,
+                                task.y + ((i >> 1) & 1) * size / 2,
+                                task.z + (i >> 2) * size / 2});
+      }
+    }
+    tasks.swap(children);
+  }
+
+  ParallelFor(tasks.size(), [&](int i) {
+    DecodeEntry(tasks[i].entry, tasks[i].x, tasks[i].y, tasks[i].z,
+                task_size, volume);
+  });
+}
+
+void SparseVoxelDAG::Save(const std::string& path,
+                          const glm::mat4& projection) const {
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.resolution = resolution_;
+  header.root = root_;
+  header.n_tree_nodes = n_tree_nodes_;
+  header.n_tree_bricks = n_tree_bricks_;
+  header.n_nodes = n_nodes_;
+  header.n_bricks = n_bricks_;
+  header.n_words = nodes_.size();
+  memcpy(header.projection, &projection[0][0], sizeof(header.projection));
+
+  auto file = fopen(path.c_str(), "wb");
+  if (!file)
+    throw std::runtime_error("Couldn't create the DAG file: " + path);
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && fwrite(nodes_.data(), sizeof(uint32_t), nodes_.size(), file) ==
+                 nodes_.size();
+  ok = fclose(file) == 0 && ok;
+  if (!ok)
+    throw std::runtime_error("Couldn't write the DAG file: " + path);
+}
+
+glm::mat4 SparseVoxelDAG::Load(const std::string& path) {
+  auto file = fopen(path.c_str(), "rb");
+  if (!file)
+    throw std::runtime_error("Couldn't open the DAG file: " + path);
+  Header header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+            header.version == VERSION && header.resolution >= 32 &&
+            (header.resolution & (header.resolution - 1)) == 0 &&
+            header.n_words >= 2 &&
+            (header.root <= FULL || header.root < header.n_words);
+  if (ok) {
+    nodes_.resize(header.n_words);
+    ok = fread(nodes_.data(), sizeof(uint32_t), nodes_.size(), file) ==
+         nodes_.size();
+  }
+  fclose(file);
+  if (ok) {
+    // The child entries are followed by Decode, so a truncated or corrupt
+    // array must not point outside of it
+    std::vector<uint32_t> checked(nodes_.size(), 0);
+    ok = IsValidEntry(header.root, header.resolution, &checked);
+  }
+  if (!ok) {
+    nodes_.clear();
+    throw std::runtime_error("Invalid DAG file: " + path);
+  }
+
+  resolution_ = header.resolution;
+  root_ = header.root;
+  n_tree_nodes_ = header.n_tree_nodes;
+  n_tree_bricks_ = header.n_tree_bricks;
+  n_nodes_ = header.n_nodes;
+  n_bricks_ = header.n_bricks;
+  glm::mat4 projection;
+  memcpy(&projection[0][0], header.projection, sizeof(header.projection));
+  return projection;
+}
+
+const std::vector<uint32_t>& SparseVoxelDAG::GetNodes() const {
+  return nodes_;
+}
+
+uint32_t SparseVoxelDAG::GetRoot() const { return root_; }
+
+int SparseVoxelDAG::GetResolution() const { return resolution_; }
+
+size_t SparseVoxelDAG::GetNumberOfNodes() const { return n_nodes_; }
+
+size_t SparseVoxelDAG::GetNumberOfBricks() const { return n_bricks_; }
+
+size_t SparseVoxelDAG::GetNumberOfTreeNodes() const { return n_tree_nodes_; }
+
+size_t SparseVoxelDAG::GetNumberOfTreeBricks() const {
+  return n_tree_bricks_;
+}
+
+size_t SparseVoxelDAG::GetSize() const {
+  return nodes_.size() * sizeof(uint32_t);
+}
+
+std::vector<uint32_t> SparseVoxelDAG::ReduceLevel(
+    const std::vector<uint32_t>& entries, int n) {
+  int half = n / 2;
+  std::vector<uint32_t> parents((size_t)half * half * half);
+  std::unordered_map<Children, uint32_t, ChildrenHash> unique_nodes;
+  for (int z = 0; z < half; ++z) {
+    for (int y = 0; y < half; ++y) {
+      for (int x = 0; x < half; ++x) {
+        Children children;
+        bool all_empty = true;
+        bool all_full = true;
+        for (int i = 0; i < 8; ++i) {
+          int cx = 2 * x + (i & 1);
+          int cy = 2 * y + ((i >> 1) & 1);
+          int cz = 2 * z + (i >> 2);
+          children[i] = entries[((size_t)cz * n + cy) * n + cx];
+          all_empty = all_empty && children[i] == EMPTY;
+          all_full = all_full && children[i] == FULL;
+        }
+        uint32_t& parent = parents[((size_t)z * half + y) * half + x];
+        if (all_empty) {
+          parent = EMPTY;
+        } else if (all_full) {
+          parent = FULL;
+        } else {
+          n_tree_nodes_++;
+          auto inserted = unique_nodes.emplace(children, nodes_.size());
+          if (inserted.second) {
+            nodes_.insert(nodes_.end(), children.begin(), children.end());
+            n_nodes_++;
+          }
+          parent = inserted.first->second;
+        }
+      }
+    }
+  }
+  return parents;
+}
+
+bool SparseVoxelDAG::IsValidEntry(uint32_t entry, int size,
+                                  std::vector<uint32_t> *checked) const {
+  if (entry == EMPTY || entry == FULL)
+    return true;
+  size_t n_words = size == BRICK_SIZE ? 2 : 8;
+  if (entry + n_words > nodes_.size())
+    return false;
+  uint32_t level = 1u << __builtin_ctz(size);
+  if ((*checked)[entry] & level)
+    return true;
+  (*checked)[entry] |= level;
+  if (size == BRICK_SIZE)
+    return true;
+  for (int i = 0; i < 8; ++i) {
+    if (!IsValidEntry(nodes_[entry + i], size / 2, checked))
+      return false;
+  }
+  return true;
+}
+
+void SparseVoxelDAG::DecodeEntry(uint32_t entry, int x, int y, int z,
+                                 int size, VoxelVolume *volume) const {
+  if (entry == EMPTY) return;
+
+  if (entry == FULL) {
+    // Regions smaller than a word only fill some of its bits
+    int first_word = z / 32;
+    int n_words = std::max(size / 32, 1);
+    uint32_t mask = size >= 32 ? ~0u : ((1u << size) - 1) << (z % 32);
+    for (int vy = y; vy < y + size; ++vy) {
+      for (int vx = x; vx < x + size; ++vx) {
+        for (int word = first_word; word < first_word + n_words; ++word)
+          volume->SetWord(vx, vy, word,
+                          volume->GetWord(vx, vy, word) | mask);
+      }
+    }
+    return;
+  }
+
+  if (size == BRICK_SIZE) {
+    uint64_t brick = nodes_[entry] | (uint64_t)nodes_[entry + 1] << 32;
+    int word = z / 32;
+    int shift = z % 32;
+    for (int i = 0; i < BRICK_SIZE * BRICK_SIZE; ++i) {
+      uint32_t column = (brick >> (BRICK_SIZE * i)) & 0xF;
+      if (!column) continue;
+      int vx = x + i % BRICK_SIZE;
+      int vy = y + i / BRICK_SIZE;
+      volume->SetWord(vx, vy, word,
+                      volume->GetWord(vx, vy, word) | column << shift);
+    }
+    return;
+  }
+
+  int half = size / 2;
+  for (int i = 0; i < 8; ++i) {
+    DecodeEntry(nodes_[entry + i], x + (i & 1) * half,
+                y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half,
+                volume);
+  }
+}
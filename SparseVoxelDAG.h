@@ -0,0 +1,139 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SPARSEVOXELDAG_H
+#define SPARSEVOXELDAG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class VoxelVolume;
+
+/**
+ * Sparse voxel DAG, for archiving voxel volumes
+ * Same array layout of SparseVoxelOctree (entries 0 and 1 are uniform
+ * empty and full children, otherwise offsets; nodes have 8 entries and the
+ * 4x4x4 bricks have 2 words), but identical bricks and identical subtrees
+ * are stored once, found with hash tables while the levels are built
+ * bottom-up.
+ */
+class SparseVoxelDAG {
+public:
+  /**
+   * Default constructor
+   */
+  SparseVoxelDAG();
+
+  /**
+   * Builds the DAG of a volume
+   */
+  void Build(const VoxelVolume& volume);
+
+  /**
+   * Expands the DAG into a volume with the DAG resolution
+   */
+  void Decode(VoxelVolume *volume) const;
+
+  /**
+   * Writes the DAG and the projection used to voxelize it (.svdag file)
+   * Throws std::runtime_error if the file can't be written
+   */
+  void Save(const std::string& path, const glm::mat4& projection) const;
+
+  /**
+   * Reads a DAG saved with Save and returns its projection
+   * Throws std::runtime_error if the file is invalid
+   */
+  glm::mat4 Load(const std::string& path);
+
+  /**
+   * Obtains the DAG array
+   */
+  const std::vector<uint32_t>& GetNodes() const;
+
+  /**
+   * Obtains the entry of the root
+   */
+  uint32_t GetRoot() const;
+
+  /**
+   * Obtains the number of voxels in each axis
+   */
+  int GetResolution() const;
+
+  /**
+   * Obtains the number of unique internal nodes and bricks
+   */
+  size_t GetNumberOfNodes() const;
+  size_t GetNumberOfBricks() const;
+
+  /**
+   * Obtains the number of internal nodes and bricks before the
+   * deduplication (the same as a sparse voxel octree)
+   */
+  size_t GetNumberOfTreeNodes() const;
+  size_t GetNumberOfTreeBricks() const;
+
+  /**
+   * Obtains the size of the DAG array in bytes
+   */
+  size_t GetSize() const;
+
+private:
+  /**
+   * Merges each 2x2x2 block of a n^3 entries grid into a parent entry,
+   * reusing the identical nodes
+   */
+  std::vector<uint32_t> ReduceLevel(const std::vector<uint32_t>& entries,
+                                    int n);
+
+  /**
+   * Expands the subtree of an entry, with size^3 voxels, into the volume
+   */
+  void DecodeEntry(uint32_t entry, int x, int y, int z, int size,
+                   VoxelVolume *volume) const;
+
+  /**
+   * Verifies that the subtree of an entry, with size^3 voxels, stays inside
+   * the DAG array; checked has a bit per size for each word, so the shared
+   * subtrees are verified once
+   */
+  bool IsValidEntry(uint32_t entry, int size,
+                    std::vector<uint32_t> *checked) const;
+
+  int resolution_;
+  uint32_t root_;
+  size_t n_tree_nodes_;
+  size_t n_tree_bricks_;
+  size_t n_nodes_;
+  size_t n_bricks_;
+  std::vector<uint32_t> nodes_;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Parallel.h"
+#include "SparseVoxelOctree.h"
+#include "VoxelVolume.h"
+
+// Entries of the uniform children
+const uint32_t EMPTY = 0;
+const uint32_t FULL = 1;
+
+// Voxels in each axis of a brick
+const int BRICK_SIZE = 4;
+
+SparseVoxelOctree::SparseVoxelOctree()
+    : resolution_(0),
+      tile_resolution_(0),
+      depth_(0),
+      root_(EMPTY),
+      n_nodes_(0),
+      n_bricks_(0) {}
+
+void SparseVoxelOctree::Init(int resolution, int tile_resolution) {
+  resolution_ = resolution;
+  tile_resolution_ = tile_resolution;
+  depth_ = 0;
+  for (int size = resolution; size > BRICK_SIZE; size /= 2)
+    depth_++;
+  root_ = EMPTY;
+  n_nodes_ = 0;
+  n_bricks_ = 0;
+  // The first words are never referenced, so offsets don't clash with the
+  // uniform entries
+  nodes_.assign(2, 0);
+  int n_tiles = resolution / tile_resolution;
+  tiles_.assign(n_tiles * n_tiles * n_tiles, EMPTY);
+}
+
+void SparseVoxelOctree::AddTile(const VoxelVolume& volume, int x, int y,
+                                int z) {
+  const int n = tile_resolution_ / BRICK_SIZE;
+  const int n_words = tile_resolution_ / 32;
+  const int bricks_per_word = 32 / BRICK_SIZE;
+
+  // Gathers the bricks; each task handles a row of bricks
+  std::vector<uint64_t> bricks((size_t)n * n * n, 0);
+  ParallelFor(n, [&](int brick_y) {
+    for (int vy = brick_y * BRICK_SIZE; vy < (brick_y + 1) * BRICK_SIZE;
+         ++vy) {
+      for (int vx = 0; vx < tile_resolution_; ++vx) {
+        int column_idx = vx % BRICK_SIZE + BRICK_SIZE * (vy % BRICK_SIZE);
+        int shift = BRICK_SIZE * column_idx;
+        size_t row = ((size_t)brick_y * n) + vx / BRICK_SIZE;
+        for (int word = 0; word < n_words; ++word) {
+          uint32_t bits = volume.GetWord(vx, vy, word);
+          for (int i = 0; bits != 0; ++i, bits >>= BRICK_SIZE) {
+            uint64_t column = bits & 0xF;
+            if (!column) continue;
+            size_t brick_z = word * bricks_per_word + i;
+            bricks[row + brick_z * n * n] |= column << shift;
+          }
+        }
+      }
+    }
+  });
+
+  // Stores the mixed bricks
+  std::vector<uint32_t> entries(bricks.size());
+  for (size_t i = 0; i < bricks.size(); ++i) {
+    if (bricks[i] == 0) {
+      entries[i] = EMPTY;
+    } else if (bricks[i] == ~0ull) {
+      entries[i] = FULL;
+    } else {
+      entries[i] = nodes_.size();
+      nodes_.push_back(bricks[i] & 0xFFFFFFFF);
+      nodes_.push_back(bricks[i] >> 32);
+      n_bricks_++;
+    }
+  }
+  bricks.clear();
+
+  for (int size = n; size > 1; size /= 2)
+    entries = ReduceLevel(entries, size);
+
+  int n_tiles = resolution_ / tile_resolution_;
+  tiles_[(z * n_tiles + y) * n_tiles + x] = entries[0];
+}
+
+void SparseVoxelOctree::Finish() {
+  int n_tiles = resolution_ / tile_resolution_;
+  std::vector<uint32_t> entries = tiles_;
+  for (int size = n_tiles; size > 1; size /= 2)
+    entries = ReduceLevel(entries, size);
+  root_ = entries[0];
+}
+
+const std::vector<uint32_t>& SparseVoxelOctree::GetNodes() const {
+  return nodes_;
+}
+
+uint32_t SparseVoxelOctree::GetRoot() const { return root_; }
+
+int SparseVoxelOctree::GetDepth() const { return depth_; }
+
+int SparseVoxelOctree::GetResolution() const { return resolution_; }
+
+size_t SparseVoxelOctree::GetNumberOfNodes() const { return n_nodes_; }
+
+size_t SparseVoxelOctree::GetNumberOfBricks() const { return n_bricks_; }
+
+size_t SparseVoxelOctree::GetSize() const {
+  return nodes_.size() * sizeof(uint32_t);
+}
+
+std::vector<uint32_t> SparseVoxelOctree::ReduceLevel(
+    const std::vector<uint32_t>& entries, int n) {
+  int half = n / 2;
+  std::vector<uint32_t> parents((size_t)half * half * half);
+  for (int z = 0; z < half; ++z) {
+    for (int y = 0; y < half; ++y) {
+      for (int x = 0; x < half; ++x) {
+        uint32_t children[8];
+        bool all_empty = true;
+        bool all_full = true;
+        for (int i = 0; i < 8; ++i) {
+          int cx = 2 * x + (i & 1);
+          int cy = 2 * y + ((i >> 1) & 1);
+          int cz = 2 * z + (i >> 2);
+          children[i] = entries[((size_t)cz * n + cy) * n + cx];
+          all_empty = all_empty && children[i] == EMPTY;
+          all_full = all_full && children[i] == FULL;
+        }
+        uint32_t& parent = parents[((size_t)z * half + y) * half + x];
+        if (all_empty) {
+          parent = EMPTY;
+        } else if (all_full) {
+          parent = FULL;
+        } else {
+          parent = nodes_.size();
+          nodes_.insert(nodes_.end(), children, children + 8);
+          n_nodes_++;
+        }
+      }
+    }
+  }
+  return parents;
+}
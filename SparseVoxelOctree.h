@@ -0,0 +1,117 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPARSEVOXELOCTREE_H
+#define SPARSEVOXELOCTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class VoxelVolume;
+
+/**
+ * Sparse voxel octree with 4x4x4 voxel bricks as leaves
+ * The octree is stored in a single array of words, ready to be sent to a
+ * shader storage buffer. Every child is referenced by an entry: 0 means an
+ * empty child, 1 a completely full child, otherwise the entry is the offset
+ * of the child in the array. Internal nodes have 8 entries (child x + 2y +
+ * 4z); bricks have 2 words, the voxel (x, y, z) is the bit z + 4 * (x + 4y).
+ *
+ * The octree is built from tiles, each one a slice map read back from the
+ * gpu, so its resolution isn't limited by the slice map size.
+ */
+class SparseVoxelOctree {
+public:
+  /**
+   * Default constructor
+   */
+  SparseVoxelOctree();
+
+  /**
+   * Starts an empty octree with resolution^3 voxels, split in tiles with
+   * tile_resolution^3 voxels; both must be powers of two
+   */
+  void Init(int resolution, int tile_resolution);
+
+  /**
+   * Adds the voxels of the tile (x, y, z); the volume must have the tile
+   * resolution; tiles that aren't added are empty
+   */
+  void AddTile(const VoxelVolume& volume, int x, int y, int z);
+
+  /**
+   * Builds the levels above the tiles
+   */
+  void Finish();
+
+  /**
+   * Obtains the octree array
+   */
+  const std::vector<uint32_t>& GetNodes() const;
+
+  /**
+   * Obtains the entry of the root
+   */
+  uint32_t GetRoot() const;
+
+  /**
+   * Obtains the number of internal levels (the bricks are below them)
+   */
+  int GetDepth() const;
+
+  /**
+   * Obtains the number of voxels in each axis
+   */
+  int GetResolution() const;
+
+  /**
+   * Obtains the number of internal nodes and bricks
+   */
+  size_t GetNumberOfNodes() const;
+  size_t GetNumberOfBricks() const;
+
+  /**
+   * Obtains the size of the octree array in bytes
+   */
+  size_t GetSize() const;
+
+private:
+  /**
+   * Merges each 2x2x2 block of a n^3 entries grid into a parent entry
+   */
+  std::vector<uint32_t> ReduceLevel(const std::vector<uint32_t>& entries,
+                                    int n);
+
+  int resolution_;
+  int tile_resolution_;
+  int depth_;
+  uint32_t root_;
+  size_t n_nodes_;
+  size_t n_bricks_;
+  std::vector<uint32_t> nodes_;
+  std::vector<uint32_t> tiles_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <GL/glew.h>
+
+#include "StorageBuffer.h"
+
+StorageBuffer::StorageBuffer() : ssbo_(0), size_(0) {}
+
+StorageBuffer::~StorageBuffer() {
+  if (ssbo_)
+    glDeleteBuffers(1, &ssbo_);
+}
+
+void StorageBuffer::Init() { glGenBuffers(1, &ssbo_); }
+
+void StorageBuffer::SetData(const void *data, size_t size) {
+  size_ = size;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void StorageBuffer::GetData(void *data, size_t size) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+size_t StorageBuffer::GetSize() { return size_; }
+
+unsigned int StorageBuffer::GetId() { return ssbo_; }
@@ -0,0 +1,75 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef STORAGEBUFFER_H
+#define STORAGEBUFFER_H
+
+#include <cstddef>
+
+/**
+ * Shader storage buffer
+ */
+class StorageBuffer {
+public:
+  /**
+   * Default constructor
+   */
+  StorageBuffer();
+
+  /**
+   * Destructor
+   */
+  ~StorageBuffer();
+
+  /**
+   * Creates the storage buffer
+   */
+  void Init();
+
+  /**
+   * Replaces the buffer content; data may be null to only allocate it
+   */
+  void SetData(const void *data, size_t size);
+
+  /**
+   * Copies the buffer content to the cpu
+   */
+  void GetData(void *data, size_t size);
+
+  /**
+   * Obtains the buffer size in bytes
+   */
+  size_t GetSize();
+
+  /**
+   * Obtains the buffer id
+   */
+  unsigned int GetId();
+
+private:
+  unsigned int ssbo_;
+  size_t size_;
+};
+
+#endif
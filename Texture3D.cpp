@@ -0,0 +1,89 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <GL/glew.h>
+
+#include "Texture3D.h"
+
+Texture3D::Texture3D() : texture_(0), size_(0), height_(0), depth_(0) {}
+
+Texture3D::~Texture3D() {
+  if (texture_) glDeleteTextures(1, &texture_);
+}
+
+void Texture3D::LoadTexture(const void *array, int n, int internal_format,
+                            int base_format, int type) {
+  LoadTexture(array, n, n, n, internal_format, base_format, type);
+}
+
+void Texture3D::LoadTexture(const void *array, int width, int height,
+                            int depth, int internal_format, int base_format,
+                            int type) {
+  if (!texture_) glGenTextures(1, &texture_);
+  size_ = width;
+  height_ = height;
+  depth_ = depth;
+  glBindTexture(GL_TEXTURE_3D, texture_);
+  glTexImage3D(GL_TEXTURE_3D, 0, internal_format, width, height, depth, 0,
+               base_format, type, array);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::UpdateTexture(const void *array, int base_format, int type) {
+  glBindTexture(GL_TEXTURE_3D, texture_);
+  glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size_, height_, depth_,
+                  base_format, type, array);
+  glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::SetFilter(int filter) {
+  glBindTexture(GL_TEXTURE_3D, texture_);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+  glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::GenerateMipmap() {
+  glBindTexture(GL_TEXTURE_3D, texture_);
+  glGenerateMipmap(GL_TEXTURE_3D);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+int Texture3D::GetSize() { return size_; }
+
+int Texture3D::GetWidth() { return size_; }
+
+int Texture3D::GetHeight() { return height_; }
+
+int Texture3D::GetDepth() { return depth_; }
+
+unsigned int Texture3D::GetId() { return texture_; }
@@ -0,0 +1,90 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Opengl 3D texture abstraction
+ */
+class Texture3D {
+public:
+    /**
+     * Default constructor
+     */
+    Texture3D();
+
+    /**
+     * Destructor
+     */
+    ~Texture3D();
+
+    /**
+     * Creates the texture with n * n * n texels
+     * The array may be null, in this case the texture is left uninitialized
+     */
+    void LoadTexture(const void *array, int n, int internal_format,
+                     int base_format, int type);
+
+    /**
+     * Creates the texture with width * height * depth texels
+     */
+    void LoadTexture(const void *array, int width, int height, int depth,
+                     int internal_format, int base_format, int type);
+
+    /**
+     * Replaces the content of the whole texture
+     */
+    void UpdateTexture(const void *array, int base_format, int type);
+
+    /**
+     * Sets the minification and magnification filter
+     */
+    void SetFilter(int filter);
+
+    /**
+     * Computes the mipmaps from the first level and enables trilinear
+     * filtering
+     */
+    void GenerateMipmap();
+
+    /**
+     * Obtains the number of texels in each axis (the width if the texture
+     * isn't a cube)
+     */
+    int GetSize();
+    int GetWidth();
+    int GetHeight();
+    int GetDepth();
+
+    /**
+     * Obtains the texture id
+     */
+    unsigned int GetId();
+
+private:
+    unsigned int texture_;
+    int size_;
+    int height_;
+    int depth_;
+};
@@ -0,0 +1,54 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <GL/glew.h>
+
+#include "TimerQuery.h"
+
+TimerQuery::TimerQuery() : queries_{0, 0}, issued_{false, false}, current_(0) {}
+
+TimerQuery::~TimerQuery() {
+  if (queries_[0])
+    glDeleteQueries(2, queries_);
+}
+
+void TimerQuery::Init() { glGenQueries(2, queries_); }
+
+void TimerQuery::Begin() { glBeginQuery(GL_TIME_ELAPSED, queries_[current_]); }
+
+void TimerQuery::End() {
+  glEndQuery(GL_TIME_ELAPSED);
+  issued_[current_] = true;
+  current_ = 1 - current_;
+}
+
+double TimerQuery::GetElapsedTime() {
+  // The current query is the oldest one; uses the newest if it is the only one
+  int query = issued_[current_] ? current_ : 1 - current_;
+  if (!issued_[query])
+    return 0;
+  GLuint64 elapsed = 0;
+  glGetQueryObjectui64v(queries_[query], GL_QUERY_RESULT, &elapsed);
+  return elapsed / 1e6;
+}
@@ -0,0 +1,67 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TIMERQUERY_H
+#define TIMERQUERY_H
+
+/**
+ * Measures the gpu time spent between Begin and End
+ * Two queries are used alternately, so reading the time of the previous
+ * measurement doesn't stall the pipeline
+ */
+class TimerQuery {
+public:
+  /**
+   * Default constructor
+   */
+  TimerQuery();
+
+  /**
+   * Destructor
+   */
+  ~TimerQuery();
+
+  /**
+   * Creates the queries
+   */
+  void Init();
+
+  /**
+   * Starts and finishes a measurement
+   */
+  void Begin();
+  void End();
+
+  /**
+   * Obtains the time of the last finished measurement in milliseconds
+   */
+  double GetElapsedTime();
+
+private:
+  unsigned int queries_[2];
+  bool issued_[2];
+  int current_;
+};
+
+#endif
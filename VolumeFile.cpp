@@ -0,0 +1,302 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Parallel.h"
+#include "VolumeFile.h"
+#include "VoxelVolume.h"
+
+// Slices packed in each word of the slice map
+const int SLAB_SIZE = 32;
+
+// Offset that centres a scene in the volume; the depth is aligned to words
+static glm::ivec3 GetCenteringOffset(const glm::ivec3& size, int resolution,
+                                     const std::string& path) {
+  if (glm::any(glm::greaterThan(size, glm::ivec3(resolution))))
+    throw std::runtime_error("The volume doesn't fit in the slice map: " +
+                             path);
+  glm::ivec3 offset = (resolution - size) / 2;
+  offset.z = offset.z / SLAB_SIZE * SLAB_SIZE;
+  return offset;
+}
+
+// Sequential reader of the .vox chunks
+struct VoxReader {
+  const std::vector<unsigned char>& data;
+  size_t position;
+
+  bool CanRead(size_t n) const { return position + n <= data.size(); }
+
+  void Check(size_t n) const {
+    if (!CanRead(n))
+      throw std::runtime_error("Truncated vox file");
+  }
+
+  int32_t ReadInt() {
+    Check(4);
+    int32_t value;
+    memcpy(&value, &data[position], 4);
+    position += 4;
+    return value;
+  }
+
+  std::string ReadString() {
+    int32_t length = ReadInt();
+    Check(length);
+    std::string value(data.begin() + position,
+                      data.begin() + position + length);
+    position += length;
+    return value;
+  }
+
+  std::map<std::string, std::string> ReadDict() {
+    std::map<std::string, std::string> dict;
+    int32_t n = ReadInt();
+    for (int32_t i = 0; i < n; ++i) {
+      auto key = ReadString();
+      dict[key] = ReadString();
+    }
+    return dict;
+  }
+};
+
+// Node of the .vox scene graph: transforms have a child, groups have
+// children and shapes have models
+struct VoxNode {
+  glm::ivec3 translation;
+  std::vector<int> children;
+  std::vector<int> models;
+};
+
+// Places the models of a scene graph node and of its children
+static void PlaceVoxNode(const std::map<int, VoxNode>& nodes, int id,
+                         glm::ivec3 translation,
+                         std::vector<std::pair<int, glm::ivec3>> *placements) {
+  auto node = nodes.find(id);
+  if (node == nodes.end())
+    throw std::runtime_error("Invalid vox scene graph");
+  translation += node->second.translation;
+  for (auto model : node->second.models)
+    placements->push_back(std::make_pair(model, translation));
+  for (auto child : node->second.children)
+    PlaceVoxNode(nodes, child, translation, placements);
+}
+
+glm::ivec3 LoadVoxFile(const std::string& path, VoxelVolume *volume,
+                       glm::ivec3 *offset) {
+  auto file = fopen(path.c_str(), "rb");
+  if (!file)
+    throw std::runtime_error("Couldn't open the vox file: " + path);
+  std::vector<unsigned char> data;
+  unsigned char buffer[65536];
+  size_t n_read;
+  while ((n_read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    data.insert(data.end(), buffer, buffer + n_read);
+  fclose(file);
+
+  VoxReader reader = {data, 8};
+  if (data.size() < 8 || memcmp(data.data(), "VOX ", 4) != 0)
+    throw std::runtime_error("Invalid vox file: " + path);
+
+  // Models (size and voxels x, y, z, color) and scene graph nodes; the
+  // chunks are read in sequence, the children of MAIN included
+  std::vector<glm::ivec3> sizes;
+  std::vector<std::vector<uint32_t>> models;
+  std::map<int, VoxNode> nodes;
+  while (reader.CanRead(12)) {
+    std::string id(data.begin() + reader.position,
+                   data.begin() + reader.position + 4);
+    reader.position += 4;
+    int32_t content_size = reader.ReadInt();
+    reader.ReadInt();
+    reader.Check(content_size);
+    size_t end = reader.position + content_size;
+    if (id == "SIZE") {
+      int x = reader.ReadInt();
+      int y = reader.ReadInt();
+      int z = reader.ReadInt();
+      sizes.push_back(glm::ivec3(x, y, z));
+    } else if (id == "XYZI") {
+      int32_t n = reader.ReadInt();
+      reader.Check((size_t)n * 4);
+      std::vector<uint32_t> voxels(n);
+      memcpy(voxels.data(), &data[reader.position], (size_t)n * 4);
+      models.push_back(voxels);
+    } else if (id == "nTRN") {
+      int node_id = reader.ReadInt();
+      reader.ReadDict();
+      VoxNode node = {glm::ivec3(0), {reader.ReadInt()}, {}};
+      reader.ReadInt();
+      reader.ReadInt();
+      int n_frames = reader.ReadInt();
+      for (int i = 0; i < n_frames; ++i) {
+        auto frame = reader.ReadDict();
+        if (i == 0 && frame.count("_t")) {
+          std::istringstream values(frame["_t"]);
+          values >> node.translation.x >> node.translation.y >>
+              node.translation.z;
+        }
+      }
+      nodes[node_id] = node;
+    } else if (id == "nGRP") {
+      int node_id = reader.ReadInt();
+      reader.ReadDict();
+      VoxNode node = {glm::ivec3(0), {}, {}};
+      int n_children = reader.ReadInt();
+      for (int i = 0; i < n_children; ++i)
+        node.children.push_back(reader.ReadInt());
+      nodes[node_id] = node;
+    } else if (id == "nSHP") {
+      int node_id = reader.ReadInt();
+      reader.ReadDict();
+      VoxNode node = {glm::ivec3(0), {}, {}};
+      int n_models = reader.ReadInt();
+      for (int i = 0; i < n_models; ++i) {
+        node.models.push_back(reader.ReadInt());
+        reader.ReadDict();
+      }
+      nodes[node_id] = node;
+    }
+    // MAIN has no content, so its children are read next
+    reader.position = end;
+  }
+  if (sizes.size() != models.size() || models.empty())
+    throw std::runtime_error("Invalid vox file: " + path);
+
+  // Files without a scene graph have their models at the origin; the
+  // translations are the centres of the models
+  std::vector<std::pair<int, glm::ivec3>> placements;
+  if (nodes.empty()) {
+    for (size_t i = 0; i < models.size(); ++i)
+      placements.push_back(std::make_pair(i, glm::ivec3(0)));
+  } else {
+    PlaceVoxNode(nodes, 0, glm::ivec3(0), &placements);
+  }
+  glm::ivec3 first(INT32_MAX);
+  glm::ivec3 last(INT32_MIN);
+  for (auto& placement : placements) {
+    if (placement.first < 0 || placement.first >= (int)models.size())
+      throw std::runtime_error("Invalid vox model: " + path);
+    if (!nodes.empty())
+      placement.second -= sizes[placement.first] / 2;
+    first = glm::min(first, placement.second);
+    last = glm::max(last, placement.second + sizes[placement.first] - 1);
+  }
+
+  // The z axis of the file is up
+  auto size = last - first + 1;
+  size = glm::ivec3(size.x, size.z, size.y);
+  int resolution = volume->GetResolution();
+  *offset = GetCenteringOffset(size, resolution, path);
+
+  // Sorts the voxels by row, so each row is packed by a single task
+  std::vector<std::vector<uint32_t>> rows(resolution);
+  for (auto& placement : placements) {
+    auto origin = placement.second - first;
+    origin = glm::ivec3(origin.x, origin.z, origin.y) + *offset;
+    for (auto voxel : models[placement.first]) {
+      int x = origin.x + (voxel & 0xFF);
+      int y = origin.y + ((voxel >> 16) & 0xFF);
+      int z = origin.z + ((voxel >> 8) & 0xFF);
+      rows[y].push_back((uint32_t)x | (uint32_t)z << 16);
+    }
+  }
+  volume->Init(resolution);
+  ParallelFor(resolution, [&](int y) {
+    for (auto voxel : rows[y]) {
+      int x = voxel & 0xFFFF;
+      int z = voxel >> 16;
+      volume->SetWord(x, y, z / 32,
+                      volume->GetWord(x, y, z / 32) | 1u << (z % 32));
+    }
+  });
+  return size;
+}
+
+glm::ivec3 LoadRawVolume(const std::string& path, const glm::ivec3& size,
+                         int threshold, VoxelVolume *volume,
+                         glm::ivec3 *offset) {
+  if (size.x <= 0 || size.y <= 0 || size.z <= 0)
+    throw std::runtime_error("Invalid raw volume size: " + path);
+  int resolution = volume->GetResolution();
+  *offset = GetCenteringOffset(size, resolution, path);
+  auto file = fopen(path.c_str(), "rb");
+  if (!file)
+    throw std::runtime_error("Couldn't open the raw volume: " + path);
+  volume->Init(resolution);
+
+  // Reads a slab of slices into one of the buffers
+  size_t slice_size = (size_t)size.x * size.y;
+  int n_slabs = (size.z + SLAB_SIZE - 1) / SLAB_SIZE;
+  std::vector<unsigned char> slabs[2];
+  auto read_slab = [&](int slab) {
+    int n_slices = std::min(SLAB_SIZE, size.z - slab * SLAB_SIZE);
+    auto& buffer = slabs[slab % 2];
+    buffer.resize(slice_size * n_slices);
+    return fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+  };
+
+  bool ok = read_slab(0);
+  for (int slab = 0; ok && slab < n_slabs; ++slab) {
+    bool next_ok = true;
+    std::thread reader;
+    if (slab + 1 < n_slabs)
+      reader = std::thread([&]() { next_ok = read_slab(slab + 1); });
+
+    // Each task packs a row of columns, one slice after the other
+    const auto& buffer = slabs[slab % 2];
+    int n_slices = buffer.size() / slice_size;
+    int word = offset->z / SLAB_SIZE + slab;
+    ParallelFor(size.y, [&](int y) {
+      std::vector<uint32_t> words(size.x, 0);
+      for (int s = 0; s < n_slices; ++s) {
+        auto row = &buffer[s * slice_size + (size_t)y * size.x];
+        for (int x = 0; x < size.x; ++x)
+          words[x] |= (uint32_t)(row[x] >= threshold) << s;
+      }
+      for (int x = 0; x < size.x; ++x) {
+        if (words[x])
+          volume->SetWord(x + offset->x, y + offset->y, word, words[x]);
+      }
+    });
+
+    if (reader.joinable())
+      reader.join();
+    ok = next_ok;
+  }
+  fclose(file);
+  if (!ok)
+    throw std::runtime_error("Truncated raw volume: " + path);
+  return size;
+}
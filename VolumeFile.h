@@ -0,0 +1,62 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef VOLUMEFILE_H
+#define VOLUMEFILE_H
+
+#include <string>
+
+#include <glm/glm.hpp>
+
+class VoxelVolume;
+
+/**
+ * Loaders of volumetric scenes, which are packed directly in the slice map
+ * layout of a VoxelVolume instead of being voxelized from triangles
+ * The scene is centred in the volume (the depth offset is rounded to whole
+ * words); the number of voxels it uses in each axis is returned and its
+ * first voxel is stored in offset. They throw std::runtime_error if the file
+ * is invalid or if the scene doesn't fit in the volume.
+ */
+
+/**
+ * Reads a MagicaVoxel file (.vox)
+ * The models are placed with the translations of the scene graph (rotations
+ * are ignored); the z up axis of the file becomes the y axis of the volume
+ */
+glm::ivec3 LoadVoxFile(const std::string& path, VoxelVolume *volume,
+                       glm::ivec3 *offset);
+
+/**
+ * Reads a raw volume of bytes, such as a segmentation (.raw)
+ * The voxels are stored with x varying first, then y and then z; voxels with
+ * values of at least threshold are active. The file is streamed in slabs of
+ * 32 slices, read while the previous slab is packed in parallel
+ */
+glm::ivec3 LoadRawVolume(const std::string& path, const glm::ivec3& size,
+                         int threshold, VoxelVolume *volume,
+                         glm::ivec3 *offset);
+
+#endif
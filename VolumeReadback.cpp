@@ -0,0 +1,89 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include "VolumeReadback.h"
+#include "VoxelVolume.h"
+
+VolumeReadback::VolumeReadback()
+    : buffer_(0), size_(0), resolution_(0), fence_(nullptr) {}
+
+VolumeReadback::~VolumeReadback() {
+  if (fence_)
+    glDeleteSync(fence_);
+  if (buffer_)
+    glDeleteBuffers(1, &buffer_);
+}
+
+void VolumeReadback::Start(const std::vector<unsigned int>& textures,
+                           int resolution) {
+  if (fence_)
+    glDeleteSync(fence_);
+  size_t texture_size = (size_t)resolution * resolution * 4 * sizeof(GLuint);
+  size_t size = texture_size * textures.size();
+  if (!buffer_)
+    glGenBuffers(1, &buffer_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer_);
+  if (size != size_)
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+  size_ = size;
+  resolution_ = resolution;
+
+  // With a pack buffer bound, the pointer is an offset in the buffer
+  for (size_t i = 0; i < textures.size(); ++i) {
+    glBindTexture(GL_TEXTURE_2D, textures[i]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT,
+                  (void *)(i * texture_size));
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool VolumeReadback::IsPending() const { return fence_ != nullptr; }
+
+bool VolumeReadback::Finish(VoxelVolume *volume) {
+  if (!fence_)
+    return false;
+  // Flushes the commands the first time, so the fence is eventually signaled
+  auto status = glClientWaitSync(fence_, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    return false;
+  glDeleteSync(fence_);
+  fence_ = nullptr;
+
+  if (volume->GetResolution() != resolution_)
+    volume->Init(resolution_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer_);
+  auto data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size_,
+                               GL_MAP_READ_BIT);
+  memcpy(volume->GetData(), data, size_);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return true;
+}
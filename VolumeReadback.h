@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef VOLUMEREADBACK_H
+#define VOLUMEREADBACK_H
+
+#include <vector>
+
+class VoxelVolume;
+struct __GLsync;
+
+/**
+ * Asynchronous copy of the slice map textures to a VoxelVolume
+ * The textures are copied to a pixel pack buffer and a fence is inserted
+ * after the copy, so Start returns at once; Finish maps the buffer only
+ * after the gpu signals the fence, without stalling the pipeline.
+ */
+class VolumeReadback {
+public:
+  /**
+   * Default constructor
+   */
+  VolumeReadback();
+
+  /**
+   * Destructor
+   */
+  ~VolumeReadback();
+
+  /**
+   * Starts copying the textures of a slice map with resolution^2 texels;
+   * a copy in progress is discarded
+   */
+  void Start(const std::vector<unsigned int>& textures, int resolution);
+
+  /**
+   * Indicates if a copy is in progress
+   */
+  bool IsPending() const;
+
+  /**
+   * Copies the textures to the volume if the gpu finished the copy, without
+   * waiting; returns true if the volume was updated
+   */
+  bool Finish(VoxelVolume *volume);
+
+private:
+  unsigned int buffer_;
+  size_t size_;
+  int resolution_;
+  __GLsync *fence_;
+};
+
+#endif
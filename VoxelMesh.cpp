@@ -0,0 +1,322 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "Parallel.h"
+#include "VoxelMesh.h"
+#include "VoxelVolume.h"
+
+// Voxels in a block of a plane (bits of a mask)
+const int BLOCK = 64;
+
+// Obtains the 64 voxels of the column (x, y) starting at z = 64 * block; the
+// columns outside the volume are empty. Its two words are in the same texel
+// of the slice map layout, the texture block / 2 of n^2 texels of 4 words
+static uint64_t GetColumn(const uint32_t *words, int n, int x, int y,
+                          int block) {
+  if (x < 0 || y < 0 || x >= n || y >= n || block < 0 || block >= n / BLOCK)
+    return 0;
+  size_t index = (((size_t)(block / 2) * n + y) * n + x) * 4 + block % 2 * 2;
+  uint64_t column;
+  memcpy(&column, words + index, sizeof(column));
+  return column;
+}
+
+// Transposes a 64x64 bit matrix: the bit j of a[i] goes to the bit i of a[j]
+// (Hacker's Delight, 7-3)
+static void Transpose(uint64_t *a) {
+  uint64_t m = 0x00000000FFFFFFFFull;
+  for (int j = 32; j != 0; j >>= 1, m ^= m << j) {
+    for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+      a[k] ^= t << j;
+      a[k | j] ^= t;
+    }
+  }
+}
+
+// Merges the faces of a block of a plane into rectangles: the bit u of
+// rows[v] is the face (u, v). Each run of bits is extended to the next rows
+// while they contain all of it; emit(u, v, width, height) is called for each
+// rectangle. The rows are cleared
+template <typename Emit>
+static void MergeRows(uint64_t *rows, int n, const Emit& emit) {
+  for (int v = 0; v < n; ++v) {
+    while (rows[v]) {
+      int u = __builtin_ctzll(rows[v]);
+      uint64_t run = ~(rows[v] >> u);
+      int width = run ? __builtin_ctzll(run) : BLOCK - u;
+      uint64_t mask = width == BLOCK ? ~0ull : ((1ull << width) - 1) << u;
+      int height = 1;
+      while (v + height < n && (rows[v + height] & mask) == mask) {
+        rows[v + height] &= ~mask;
+        height++;
+      }
+      rows[v] &= ~mask;
+      emit(u, v, width, height);
+    }
+  }
+}
+
+VoxelMesh::VoxelMesh() {}
+
+void VoxelMesh::Build(const VoxelVolume& volume) {
+  std::vector<std::vector<Quad>> quads;
+  for (int axis = 0; axis < 3; ++axis)
+    BuildAxis(volume, axis, &quads);
+
+  // Each task writes its quads after the ones of the previous tasks
+  std::vector<size_t> first_quad(quads.size() + 1, 0);
+  for (size_t i = 0; i < quads.size(); ++i)
+    first_quad[i + 1] = first_quad[i] + quads[i].size();
+  size_t n_quads = first_quad.back();
+  positions_.resize(n_quads * 12);
+  normals_.resize(n_quads * 12);
+  indices_.resize(n_quads * 6);
+  ParallelFor(quads.size(), [&](int task) {
+    for (size_t i = 0; i < quads[task].size(); ++i)
+      SetQuad(first_quad[task] + i, quads[task][i]);
+  });
+}
+
+void VoxelMesh::BuildAxis(const VoxelVolume& volume, int axis,
+                          std::vector<std::vector<Quad>> *quads) const {
+  int n = volume.GetResolution();
+  int n_blocks = n / BLOCK;
+  auto words = volume.GetData();
+
+  if (axis == 1) {
+    // y faces: the rows of a plane are the 64-voxel blocks of its columns
+    // (along z), extended along x. Each task handles a block of a plane
+    size_t first_task = quads->size();
+    quads->resize(first_task + (size_t)n * n_blocks * 2);
+    ParallelFor(n * n_blocks, [&](int task) {
+      int y = task % n;
+      int block = task / n;
+      std::vector<uint64_t> rows[2] = {std::vector<uint64_t>(n),
+                                       std::vector<uint64_t>(n)};
+      for (int x = 0; x < n; ++x) {
+        uint64_t column = GetColumn(words, n, x, y, block);
+        rows[0][x] = column & ~GetColumn(words, n, x, y - 1, block);
+        rows[1][x] = column & ~GetColumn(words, n, x, y + 1, block);
+      }
+      for (int side = 0; side < 2; ++side) {
+        auto& task_quads = (*quads)[first_task + task * 2 + side];
+        MergeRows(rows[side].data(), n,
+                  [&](int u, int v, int width, int height) {
+          Quad quad;
+          quad.face = 2 + side;
+          quad.origin = glm::ivec3(v, y + side, block * BLOCK + u);
+          quad.size = glm::ivec3(height, 0, width);
+          task_quads.push_back(quad);
+        });
+      }
+    });
+    return;
+  }
+
+  if (axis == 0) {
+    // x faces: the rows of a plane are the 64-voxel blocks of its columns
+    // (along z), extended along y. Each task handles a block of 64 planes,
+    // read along x so the columns are contiguous
+    size_t first_task = quads->size();
+    quads->resize(first_task + (size_t)n_blocks * n_blocks * 2);
+    ParallelFor(n_blocks * n_blocks, [&](int task) {
+      int x_block = task / n_blocks;
+      int block = task % n_blocks;
+      std::vector<uint64_t> rows[2] = {std::vector<uint64_t>(BLOCK * n),
+                                       std::vector<uint64_t>(BLOCK * n)};
+      for (int y = 0; y < n; ++y) {
+        int x = x_block * BLOCK;
+        uint64_t back = GetColumn(words, n, x - 1, y, block);
+        uint64_t column = GetColumn(words, n, x, y, block);
+        for (int i = 0; i < BLOCK; ++i) {
+          uint64_t front = GetColumn(words, n, x + i + 1, y, block);
+          rows[0][(size_t)i * n + y] = column & ~back;
+          rows[1][(size_t)i * n + y] = column & ~front;
+          back = column;
+          column = front;
+        }
+      }
+      for (int side = 0; side < 2; ++side) {
+        auto& task_quads = (*quads)[first_task + task * 2 + side];
+        for (int i = 0; i < BLOCK; ++i) {
+          auto plane_rows = rows[side].data() + (size_t)i * n;
+          MergeRows(plane_rows, n, [&](int u, int v, int width, int height) {
+            Quad quad;
+            quad.face = side;
+            quad.origin = glm::ivec3(x_block * BLOCK + i + side, v,
+                                     block * BLOCK + u);
+            quad.size = glm::ivec3(0, height, width);
+            task_quads.push_back(quad);
+          });
+        }
+      }
+    });
+    return;
+  }
+
+  // z faces: the faces of each column are found with shifts (carrying the
+  // neighbour voxels of the previous and of the next blocks), and the blocks
+  // of 64 columns along x are transposed, so the rows of each z plane are
+  // masks along x extended along y. Each task handles 64 planes of a block of
+  // 64 columns
+  size_t first_task = quads->size();
+  quads->resize(first_task + (size_t)n_blocks * n_blocks * 2);
+  ParallelFor(n_blocks * n_blocks, [&](int task) {
+    int x_block = task / n_blocks;
+    int block = task % n_blocks;
+    std::vector<uint64_t> rows[2] = {std::vector<uint64_t>(BLOCK * n),
+                                     std::vector<uint64_t>(BLOCK * n)};
+    uint64_t faces[2][BLOCK];
+    for (int y = 0; y < n; ++y) {
+      uint64_t any_face[2] = {0, 0};
+      for (int i = 0; i < BLOCK; ++i) {
+        int x = x_block * BLOCK + i;
+        uint64_t column = GetColumn(words, n, x, y, block);
+        uint64_t back = column << 1 |
+                        GetColumn(words, n, x, y, block - 1) >> (BLOCK - 1);
+        uint64_t front = column >> 1 |
+                         GetColumn(words, n, x, y, block + 1) << (BLOCK - 1);
+        faces[0][i] = column & ~back;
+        faces[1][i] = column & ~front;
+        any_face[0] |= faces[0][i];
+        any_face[1] |= faces[1][i];
+      }
+      // The rows start empty, most of the blocks have no faces
+      for (int side = 0; side < 2; ++side) {
+        if (!any_face[side])
+          continue;
+        Transpose(faces[side]);
+        for (int k = 0; k < BLOCK; ++k)
+          rows[side][(size_t)k * n + y] = faces[side][k];
+      }
+    }
+    for (int side = 0; side < 2; ++side) {
+      auto& task_quads = (*quads)[first_task + task * 2 + side];
+      for (int k = 0; k < BLOCK; ++k) {
+        auto plane_rows = rows[side].data() + (size_t)k * n;
+        MergeRows(plane_rows, n, [&](int u, int v, int width, int height) {
+          Quad quad;
+          quad.face = 4 + side;
+          quad.origin = glm::ivec3(x_block * BLOCK + u, v,
+                                   block * BLOCK + k + side);
+          quad.size = glm::ivec3(width, height, 0);
+          task_quads.push_back(quad);
+        });
+      }
+    }
+  });
+}
+
+void VoxelMesh::SetQuad(size_t index, const Quad& quad) {
+  // The in-plane axes u and v make a right-handed basis with the normal
+  // axis, so (0, u, u + v, v) is counter-clockwise seen from the positive
+  // side
+  int axis = quad.face / 2;
+  int u_axis = (axis + 1) % 3;
+  int v_axis = (axis + 2) % 3;
+  glm::vec3 u(0), v(0), normal(0);
+  u[u_axis] = quad.size[u_axis];
+  v[v_axis] = quad.size[v_axis];
+  normal[axis] = quad.face % 2 ? 1 : -1;
+  glm::vec3 origin(quad.origin);
+  glm::vec3 corners[] = {origin, origin + u, origin + u + v, origin + v};
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      positions_[index * 12 + i * 3 + j] = corners[i][j];
+      normals_[index * 12 + i * 3 + j] = normal[j];
+    }
+  }
+  unsigned int first = index * 4;
+  unsigned int order[2][6] = {{0, 2, 1, 0, 3, 2}, {0, 1, 2, 0, 2, 3}};
+  for (int i = 0; i < 6; ++i)
+    indices_[index * 6 + i] = first + order[quad.face % 2][i];
+}
+
+void VoxelMesh::Transform(const glm::mat4& matrix) {
+  auto normal_matrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+  ParallelFor(positions_.size() / 3, [&](int i) {
+    auto p = matrix * glm::vec4(positions_[3 * i], positions_[3 * i + 1],
+                                positions_[3 * i + 2], 1);
+    auto normal = glm::normalize(normal_matrix *
+                                 glm::vec3(normals_[3 * i],
+                                           normals_[3 * i + 1],
+                                           normals_[3 * i + 2]));
+    for (int j = 0; j < 3; ++j) {
+      positions_[3 * i + j] = p[j] / p.w;
+      normals_[3 * i + j] = normal[j];
+    }
+  });
+  if (glm::determinant(glm::mat3(matrix)) < 0) {
+    for (size_t i = 0; i < indices_.size(); i += 3)
+      std::swap(indices_[i + 1], indices_[i + 2]);
+  }
+}
+
+void VoxelMesh::SaveObj(const std::string& path) const {
+  auto file = fopen(path.c_str(), "w");
+  if (!file)
+    throw std::runtime_error("Couldn't create the OBJ file: " + path);
+  fprintf(file, "# greedy meshed voxel surface: %zu quads\n",
+          GetNumberOfQuads());
+  for (size_t i = 0; i < positions_.size(); i += 3) {
+    fprintf(file, "v %g %g %g\n", positions_[i], positions_[i + 1],
+            positions_[i + 2]);
+  }
+  for (size_t i = 0; i < normals_.size(); i += 3) {
+    fprintf(file, "vn %g %g %g\n", normals_[i], normals_[i + 1],
+            normals_[i + 2]);
+  }
+  // The vertices of a quad share its normal; the indices start at 1
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    fprintf(file, "f %u//%u %u//%u %u//%u\n", indices_[i] + 1,
+            indices_[i] + 1, indices_[i + 1] + 1, indices_[i + 1] + 1,
+            indices_[i + 2] + 1, indices_[i + 2] + 1);
+  }
+  bool failed = ferror(file);
+  fclose(file);
+  if (failed)
+    throw std::runtime_error("Couldn't write the OBJ file: " + path);
+}
+
+const std::vector<float>& VoxelMesh::GetPositions() const {
+  return positions_;
+}
+
+const std::vector<float>& VoxelMesh::GetNormals() const { return normals_; }
+
+const std::vector<unsigned int>& VoxelMesh::GetIndices() const {
+  return indices_;
+}
+
+size_t VoxelMesh::GetNumberOfQuads() const { return indices_.size() / 6; }
+
+size_t VoxelMesh::GetNumberOfTriangles() const { return indices_.size() / 3; }
@@ -0,0 +1,116 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef VOXELMESH_H
+#define VOXELMESH_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class VoxelVolume;
+
+/**
+ * Surface of a voxel volume extracted with a greedy mesher
+ * Each face between an active and an empty voxel is covered by exactly one
+ * quad, and the coplanar faces are merged into rectangles: the faces of a
+ * plane are bit masks of 64 voxels, so the runs are found with bit scans and
+ * extended while the next rows contain them. The quads don't cross the
+ * 64-voxel blocks of the plane. Each quad has its own 4 vertices (flat
+ * normals) and 2 triangles.
+ */
+class VoxelMesh {
+public:
+  /**
+   * Default constructor
+   */
+  VoxelMesh();
+
+  /**
+   * Extracts the surface of the volume using all the cpu cores
+   * The positions are in voxels, the volume is [0, resolution]^3
+   */
+  void Build(const VoxelVolume& volume);
+
+  /**
+   * Transforms the positions and the normals (from the voxels to the object
+   * space, for instance); the winding is flipped if the matrix mirrors, so
+   * the triangles stay counter-clockwise seen from outside
+   */
+  void Transform(const glm::mat4& matrix);
+
+  /**
+   * Saves the mesh as a Wavefront OBJ file
+   * Throws std::runtime_error if the file can't be written
+   */
+  void SaveObj(const std::string& path) const;
+
+  /**
+   * Obtains the vertices positions and normals (x, y, z sequences)
+   */
+  const std::vector<float>& GetPositions() const;
+  const std::vector<float>& GetNormals() const;
+
+  /**
+   * Obtains the triangles indices
+   */
+  const std::vector<unsigned int>& GetIndices() const;
+
+  /**
+   * Obtains the number of quads and of triangles
+   */
+  size_t GetNumberOfQuads() const;
+  size_t GetNumberOfTriangles() const;
+
+private:
+  /**
+   * Rectangle of faces: the face is the axis of the normal times 2, plus 1
+   * if it points to the positive side; the size along that axis is 0
+   */
+  struct Quad {
+    int face;
+    glm::ivec3 origin;
+    glm::ivec3 size;
+  };
+
+  /**
+   * Finds the quads of the faces perpendicular to an axis, on both sides;
+   * each task adds a vector of quads for each side
+   */
+  void BuildAxis(const VoxelVolume& volume, int axis,
+                 std::vector<std::vector<Quad>> *quads) const;
+
+  /**
+   * Writes the vertices and the triangles of a quad
+   */
+  void SetQuad(size_t index, const Quad& quad);
+
+  std::vector<float> positions_;
+  std::vector<float> normals_;
+  std::vector<unsigned int> indices_;
+};
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <bitset>
+
+#include <GL/glew.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "VoxelVolume.h"
+
+// Words stored in each slice map texel
+const int WORDS_PER_TEXEL = 4;
+
+// Ray direction components smaller than this are replaced by it, so their
+// inverses stay finite
+const float MIN_DIRECTION = 1e-6f;
+
+// Mask with the bits [lo, hi] of a word set
+static uint32_t BitRange(int lo, int hi) {
+  return (0xFFFFFFFFu >> (31 - hi)) & (0xFFFFFFFFu << lo);
+}
+
+// Replaces the direction components close to 0
+static glm::vec3 FixDirection(glm::vec3 dir) {
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(dir[i]) < MIN_DIRECTION)
+      dir[i] = dir[i] < 0 ? -MIN_DIRECTION : MIN_DIRECTION;
+  }
+  return dir;
+}
+
+VoxelVolume::VoxelVolume() : resolution_(0) {}
+
+void VoxelVolume::Init(int resolution) {
+  resolution_ = resolution;
+  words_.assign((size_t)resolution * resolution * resolution / 32, 0);
+}
+
+void VoxelVolume::ReadFromTextures(const std::vector<unsigned int>& textures) {
+  size_t texture_words = (size_t)resolution_ * resolution_ * WORDS_PER_TEXEL;
+  for (size_t i = 0; i < textures.size(); ++i) {
+    glBindTexture(GL_TEXTURE_2D, textures[i]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT,
+                  words_.data() + i * texture_words);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VoxelVolume::WriteToTextures(const std::vector<unsigned int>& textures) {
+  size_t texture_words = (size_t)resolution_ * resolution_ * WORDS_PER_TEXEL;
+  for (size_t i = 0; i < textures.size(); ++i) {
+    glBindTexture(GL_TEXTURE_2D, textures[i]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, resolution_, resolution_,
+                    GL_RGBA_INTEGER, GL_UNSIGNED_INT,
+                    words_.data() + i * texture_words);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+int VoxelVolume::GetResolution() const { return resolution_; }
+
+uint32_t VoxelVolume::GetWord(int x, int y, int word) const {
+  return words_[WordIndex(x, y, word)];
+}
+
+void VoxelVolume::SetWord(int x, int y, int word, uint32_t value) {
+  words_[WordIndex(x, y, word)] = value;
+}
+
+bool VoxelVolume::Get(int x, int y, int z) const {
+  return (GetWord(x, y, z / 32) >> (z % 32)) & 1;
+}
+
+bool VoxelVolume::Occupied(const glm::vec3& p) const {
+  auto voxel = glm::ivec3(glm::floor(p));
+  if (glm::any(glm::lessThan(voxel, glm::ivec3(0))) ||
+      glm::any(glm::greaterThanEqual(voxel, glm::ivec3(resolution_))))
+    return false;
+  return Get(voxel.x, voxel.y, voxel.z);
+}
+
+bool VoxelVolume::Raycast(const glm::vec3& origin, const glm::vec3& dir,
+                          float max_distance, VoxelHit *hit) const {
+  hit->hit = false;
+  hit->distance = max_distance;
+  hit->voxel = glm::ivec3(-1);
+  auto d = FixDirection(dir);
+  auto inv_dir = 1.0f / d;
+
+  // Clips the ray against the volume
+  auto t0 = -origin * inv_dir;
+  auto t1 = (glm::vec3(resolution_) - origin) * inv_dir;
+  auto t_near = glm::min(t0, t1);
+  auto t_far = glm::max(t0, t1);
+  float t = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+  float t_end = std::min(std::min(t_far.x, t_far.y),
+                         std::min(t_far.z, max_distance));
+  if (t >= t_end)
+    return false;
+
+  // Amanatides-Woo over the (x, y) columns, the z range crossed inside each
+  // column is tested with bit masks
+  auto p = origin + d * t;
+  auto cell = glm::clamp(glm::ivec2(glm::floor(glm::vec2(p))), 0,
+                         resolution_ - 1);
+  auto cell_step = glm::ivec2(d.x > 0 ? 1 : -1, d.y > 0 ? 1 : -1);
+  auto t_delta = glm::abs(glm::vec2(inv_dir));
+  auto t_next = (glm::vec2(cell) + glm::vec2(d.x > 0, d.y > 0) -
+                 glm::vec2(origin)) * glm::vec2(inv_dir);
+  auto voxel_z = [&](float t) {
+    int z = (int)std::floor(origin.z + d.z * t);
+    return std::min(std::max(z, 0), resolution_ - 1);
+  };
+  while (t < t_end) {
+    float t_leave = std::min(std::min(t_next.x, t_next.y), t_end);
+    int z0 = voxel_z(t);
+    int z = FindInColumn(cell.x, cell.y, z0, voxel_z(t_leave));
+    if (z >= 0) {
+      hit->hit = true;
+      hit->distance = GetColumnHitDistance(origin.z, d.z, t, z0, z);
+      hit->voxel = glm::ivec3(cell, z);
+      return true;
+    }
+    t = t_leave;
+    if (t_next.x < t_next.y) {
+      cell.x += cell_step.x;
+      t_next.x += t_delta.x;
+    } else {
+      cell.y += cell_step.y;
+      t_next.y += t_delta.y;
+    }
+    if (cell.x < 0 || cell.y < 0 || cell.x >= resolution_ ||
+        cell.y >= resolution_)
+      break;
+  }
+  return false;
+}
+
+void VoxelVolume::RaycastN(int n, const glm::vec3 *origins,
+                           const glm::vec3 *dirs, const float *max_distances,
+                           VoxelHit *hits) const {
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+    RaycastPacket(origins + i, dirs + i, max_distances + i, hits + i);
+  for (; i < n; ++i)
+    Raycast(origins[i], dirs[i], max_distances[i], hits + i);
+}
+
+size_t VoxelVolume::CountActive() const {
+  size_t n_active = 0;
+  for (auto word : words_)
+    n_active += std::bitset<32>(word).count();
+  return n_active;
+}
+
+uint32_t *VoxelVolume::GetData() { return words_.data(); }
+
+const uint32_t *VoxelVolume::GetData() const { return words_.data(); }
+
+size_t VoxelVolume::GetSize() const { return words_.size() * sizeof(uint32_t); }
+
+size_t VoxelVolume::WordIndex(int x, int y, int word) const {
+  int texture = word / WORDS_PER_TEXEL;
+  size_t texel = ((size_t)texture * resolution_ + y) * resolution_ + x;
+  return texel * WORDS_PER_TEXEL + word % WORDS_PER_TEXEL;
+}
+
+int VoxelVolume::FindInColumn(int x, int y, int z0, int z1) const {
+  int lo = std::min(z0, z1);
+  int hi = std::max(z0, z1);
+  if (z1 >= z0) {
+    for (int word = lo / 32; word <= hi / 32; ++word) {
+      int base = word * 32;
+      uint32_t bits = words_[WordIndex(x, y, word)] &
+                      BitRange(std::max(lo - base, 0), std::min(hi - base, 31));
+      if (bits)
+        return base + __builtin_ctz(bits);
+    }
+  } else {
+    for (int word = hi / 32; word >= lo / 32; --word) {
+      int base = word * 32;
+      uint32_t bits = words_[WordIndex(x, y, word)] &
+                      BitRange(std::max(lo - base, 0), std::min(hi - base, 31));
+      if (bits)
+        return base + 31 - __builtin_clz(bits);
+    }
+  }
+  return -1;
+}
+
+float VoxelVolume::GetColumnHitDistance(float origin_z, float dir_z, float t,
+                                        int z0, int z) {
+  // The ray enters the column inside the voxel z0, or it reaches the voxel z
+  // through its bottom (or top) face
+  if (z == z0)
+    return t;
+  float face = dir_z > 0 ? z : z + 1;
+  return std::max((face - origin_z) / dir_z, t);
+}
+
+#ifdef __SSE2__
+void VoxelVolume::RaycastPacket(const glm::vec3 *origins,
+                                const glm::vec3 *dirs,
+                                const float *max_distances,
+                                VoxelHit *hits) const {
+  // Structure of arrays of the packet: the clipping and the column stepping
+  // run in the 4 lanes at once, the bits of each column are tested per lane
+  alignas(16) float origin[3][4], dir[3][4];
+  for (int lane = 0; lane < 4; ++lane) {
+    auto d = FixDirection(dirs[lane]);
+    for (int axis = 0; axis < 3; ++axis) {
+      origin[axis][lane] = origins[lane][axis];
+      dir[axis][lane] = d[axis];
+    }
+    hits[lane].hit = false;
+    hits[lane].distance = max_distances[lane];
+    hits[lane].voxel = glm::ivec3(-1);
+  }
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 res = _mm_set1_ps(resolution_);
+  const __m128 last = _mm_set1_ps(resolution_ - 1);
+  __m128 o[3], d[3], inv_dir[3];
+  __m128 t = zero;
+  __m128 t_end = _mm_loadu_ps(max_distances);
+  for (int axis = 0; axis < 3; ++axis) {
+    o[axis] = _mm_load_ps(origin[axis]);
+    d[axis] = _mm_load_ps(dir[axis]);
+    inv_dir[axis] = _mm_div_ps(one, d[axis]);
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(zero, o[axis]), inv_dir[axis]);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(res, o[axis]), inv_dir[axis]);
+    t = _mm_max_ps(t, _mm_min_ps(t0, t1));
+    t_end = _mm_min_ps(t_end, _mm_max_ps(t0, t1));
+  }
+  __m128 active = _mm_cmplt_ps(t, t_end);
+
+  // Column of the entry point, its steps and the distances to its sides
+  auto voxel = [&](int axis, __m128 t) {
+    __m128 p = _mm_add_ps(o[axis], _mm_mul_ps(d[axis], t));
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(p, zero), last));
+  };
+  __m128i cell[2], cell_step[2];
+  __m128 t_delta[2], t_next[2];
+  for (int axis = 0; axis < 2; ++axis) {
+    cell[axis] = voxel(axis, t);
+    __m128 positive = _mm_cmpgt_ps(d[axis], zero);
+    __m128i ones = _mm_set1_epi32(1);
+    cell_step[axis] = _mm_sub_epi32(
+        _mm_and_si128(_mm_castps_si128(positive), _mm_add_epi32(ones, ones)),
+        ones);
+    t_delta[axis] = _mm_andnot_ps(_mm_set1_ps(-0.0f), inv_dir[axis]);
+    __m128 side = _mm_add_ps(_mm_cvtepi32_ps(cell[axis]),
+                             _mm_and_ps(positive, one));
+    t_next[axis] = _mm_mul_ps(_mm_sub_ps(side, o[axis]), inv_dir[axis]);
+  }
+
+  alignas(16) int cell_x[4], cell_y[4], z0[4], z1[4];
+  alignas(16) float t_lane[4];
+  while (int mask = _mm_movemask_ps(active)) {
+    __m128 t_leave = _mm_min_ps(_mm_min_ps(t_next[0], t_next[1]), t_end);
+    _mm_store_si128((__m128i *)cell_x, cell[0]);
+    _mm_store_si128((__m128i *)cell_y, cell[1]);
+    _mm_store_si128((__m128i *)z0, voxel(2, t));
+    _mm_store_si128((__m128i *)z1, voxel(2, t_leave));
+    _mm_store_ps(t_lane, t);
+    alignas(16) int found[4] = {0, 0, 0, 0};
+    for (int lane = 0; lane < 4; ++lane) {
+      if (!(mask & (1 << lane)))
+        continue;
+      int z = FindInColumn(cell_x[lane], cell_y[lane], z0[lane], z1[lane]);
+      if (z < 0)
+        continue;
+      hits[lane].hit = true;
+      hits[lane].distance = GetColumnHitDistance(
+          origin[2][lane], dir[2][lane], t_lane[lane], z0[lane], z);
+      hits[lane].voxel = glm::ivec3(cell_x[lane], cell_y[lane], z);
+      found[lane] = -1;
+    }
+
+    // Steps to the next column along x or y
+    __m128 step_x = _mm_cmplt_ps(t_next[0], t_next[1]);
+    __m128i step_xi = _mm_castps_si128(step_x);
+    cell[0] = _mm_add_epi32(cell[0], _mm_and_si128(step_xi, cell_step[0]));
+    cell[1] = _mm_add_epi32(cell[1], _mm_andnot_si128(step_xi, cell_step[1]));
+    t_next[0] = _mm_add_ps(t_next[0], _mm_and_ps(step_x, t_delta[0]));
+    t_next[1] = _mm_add_ps(t_next[1], _mm_andnot_ps(step_x, t_delta[1]));
+    t = t_leave;
+
+    __m128i outside = _mm_setzero_si128();
+    __m128i n = _mm_set1_epi32(resolution_);
+    for (int axis = 0; axis < 2; ++axis) {
+      outside = _mm_or_si128(outside, _mm_cmplt_epi32(cell[axis],
+                                                      _mm_setzero_si128()));
+      outside = _mm_or_si128(outside, _mm_cmplt_epi32(
+          _mm_sub_epi32(n, _mm_set1_epi32(1)), cell[axis]));
+    }
+    __m128i done = _mm_or_si128(outside,
+                                _mm_load_si128((const __m128i *)found));
+    active = _mm_and_ps(_mm_andnot_ps(_mm_castsi128_ps(done), active),
+                        _mm_cmplt_ps(t, t_end));
+  }
+}
+#else
+void VoxelVolume::RaycastPacket(const glm::vec3 *origins,
+                                const glm::vec3 *dirs,
+                                const float *max_distances,
+                                VoxelHit *hits) const {
+  for (int lane = 0; lane < 4; ++lane)
+    Raycast(origins[lane], dirs[lane], max_distances[lane], hits + lane);
+}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VOXELVOLUME_H
+#define VOXELVOLUME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Result of a ray query, the first active voxel along the ray
+ */
+struct VoxelHit {
+  bool hit;
+  float distance;
+  glm::ivec3 voxel;
+};
+
+/**
+ * Cpu copy of the bit-packed slice map
+ * The voxel (x, y, z) is the bit z % 32 of the word z / 32 of the column
+ * (x, y). The words are kept in the order of the slice map textures: each
+ * RGBA32UI texture holds 4 words (128 voxels) of every column, and it is a
+ * contiguous block of the volume.
+ * The queries work in voxel units, the volume is [0, resolution]^3 and the
+ * voxel (x, y, z) covers [x, x + 1] x [y, y + 1] x [z, z + 1].
+ */
+class VoxelVolume {
+public:
+  /**
+   * Default constructor
+   */
+  VoxelVolume();
+
+  /**
+   * Allocates an empty volume with resolution^3 voxels
+   * The resolution must be a multiple of 128
+   */
+  void Init(int resolution);
+
+  /**
+   * Copies the slice map textures from the gpu
+   */
+  void ReadFromTextures(const std::vector<unsigned int>& textures);
+
+  /**
+   * Copies the volume to the slice map textures
+   */
+  void WriteToTextures(const std::vector<unsigned int>& textures);
+
+  /**
+   * Obtains the number of voxels in each axis
+   */
+  int GetResolution() const;
+
+  /**
+   * Obtains the 32 voxels of the column (x, y) starting at z = 32 * word
+   */
+  uint32_t GetWord(int x, int y, int word) const;
+
+  /**
+   * Replaces the 32 voxels of the column (x, y) starting at z = 32 * word
+   */
+  void SetWord(int x, int y, int word, uint32_t value);
+
+  /**
+   * Obtains the value of a voxel
+   */
+  bool Get(int x, int y, int z) const;
+
+  /**
+   * Indicates if the voxel that contains the point is active (false outside
+   * the volume)
+   */
+  bool Occupied(const glm::vec3& p) const;
+
+  /**
+   * Finds the first active voxel along the ray origin + dir * t, for t in
+   * [0, max_distance] (max_distance is in voxels if dir is normalized)
+   * The columns crossed by the ray are visited in order and the voxels of
+   * each column are tested 32 at a time with bit masks. Returns hit->hit.
+   */
+  bool Raycast(const glm::vec3& origin, const glm::vec3& dir,
+               float max_distance, VoxelHit *hit) const;
+
+  /**
+   * Casts n rays; they are traversed in packets of 4 with SSE, each lane
+   * walking its own columns
+   */
+  void RaycastN(int n, const glm::vec3 *origins, const glm::vec3 *dirs,
+                const float *max_distances, VoxelHit *hits) const;
+
+  /**
+   * Counts the active voxels
+   */
+  size_t CountActive() const;
+
+  /**
+   * Obtains the raw words
+   */
+  uint32_t *GetData();
+  const uint32_t *GetData() const;
+
+  /**
+   * Obtains the size of the volume in bytes
+   */
+  size_t GetSize() const;
+
+private:
+  /**
+   * Index of a word in the words_ vector
+   */
+  size_t WordIndex(int x, int y, int word) const;
+
+  /**
+   * Finds the first active voxel of the column (x, y) walking from the voxel
+   * z0 to z1 (inclusive, in any order); returns -1 if there is none
+   */
+  int FindInColumn(int x, int y, int z0, int z1) const;
+
+  /**
+   * Distance where a ray that crosses the column between t and t_leave
+   * enters the voxel z found by FindInColumn, starting at z0
+   */
+  static float GetColumnHitDistance(float origin_z, float dir_z, float t,
+                                    int z0, int z);
+
+  /**
+   * Casts a packet of 4 rays
+   */
+  void RaycastPacket(const glm::vec3 *origins, const glm::vec3 *dirs,
+                     const float *max_distances, VoxelHit *hits) const;
+
+  int resolution_;
+  std::vector<uint32_t> words_;
+};
+
+#endif
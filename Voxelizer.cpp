@@ -0,0 +1,180 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "Parallel.h"
+#include "Voxelizer.h"
+#include "VoxelVolume.h"
+
+// Rows of columns rasterized by each task
+const int BAND_ROWS = 8;
+
+// Depth of the fragments clamped to the far plane, as in the slice map
+// voxelization
+const float MAX_DEPTH = 0.999999f;
+
+// Triangle in the window space of the volume: x and y in columns, z is the
+// depth in [0, 1]
+struct Triangle {
+  glm::vec3 v[3];
+};
+
+// Indicates if the pixel centres on an edge a -> b belong to the triangle;
+// the two triangles that share an edge see it in opposite directions, so
+// exactly one of them covers its centres
+static bool IncludesEdge(const glm::vec3& a, const glm::vec3& b) {
+  return b.y > a.y || (b.y == a.y && b.x < a.x);
+}
+
+// Edge function of the edge a -> b at p, positive on its left
+static float EdgeFunction(const glm::vec3& a, const glm::vec3& b, float x,
+                          float y) {
+  return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+// Toggles the bit of each column covered by the triangle, in the rows
+// [row_begin, row_end), at the last voxel in front of the triangle
+static void RasterizeTriangle(Triangle triangle, int row_begin,
+                              int row_end, VoxelVolume *volume) {
+  int n = volume->GetResolution();
+  auto v = triangle.v;
+  float area = EdgeFunction(v[0], v[1], v[2].x, v[2].y);
+  if (area == 0)
+    return;
+  if (area < 0) {
+    std::swap(v[1], v[2]);
+    area = -area;
+  }
+  auto lo = glm::min(v[0], glm::min(v[1], v[2]));
+  auto hi = glm::max(v[0], glm::max(v[1], v[2]));
+  int x0 = std::max((int)std::ceil(lo.x - 0.5f), 0);
+  int x1 = std::min((int)std::floor(hi.x - 0.5f), n - 1);
+  int y0 = std::max((int)std::ceil(lo.y - 0.5f), row_begin);
+  int y1 = std::min((int)std::floor(hi.y - 0.5f), row_end - 1);
+  bool include[3];
+  for (int i = 0; i < 3; ++i)
+    include[i] = IncludesEdge(v[(i + 1) % 3], v[(i + 2) % 3]);
+
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      // w[i] is the weight of the vertex i, opposite to the edge i
+      float w[3];
+      bool inside = true;
+      for (int i = 0; i < 3; ++i) {
+        w[i] = EdgeFunction(v[(i + 1) % 3], v[(i + 2) % 3], x + 0.5f,
+                            y + 0.5f);
+        inside = inside && (w[i] > 0 || (w[i] == 0 && include[i]));
+      }
+      if (!inside)
+        continue;
+      float depth = (w[0] * v[0].z + w[1] * v[1].z + w[2] * v[2].z) / area;
+      int count = (int)(std::min(std::max(depth, 0.0f), MAX_DEPTH) * n);
+      if (count == 0)
+        continue;
+      int z = count - 1;
+      volume->SetWord(x, y, z / 32,
+                      volume->GetWord(x, y, z / 32) ^ (1u << (z % 32)));
+    }
+  }
+}
+
+Voxelizer::Voxelizer() {}
+
+void Voxelizer::AddMesh(const std::vector<float>& positions,
+                        const std::vector<unsigned int>& indices) {
+  meshes_.push_back(Mesh{positions, indices});
+}
+
+void Voxelizer::Voxelize(const glm::mat4& mvp,
+                         const std::vector<glm::mat4>& models,
+                         VoxelVolume *volume) const {
+  int n = volume->GetResolution();
+  volume->Init(n);
+
+  // Transforms the triangles to the window space and sorts them into bands
+  // of rows, so each task owns its columns
+  std::vector<Triangle> triangles;
+  int n_bands = n / BAND_ROWS;
+  std::vector<std::vector<int>> bands(n_bands);
+  for (auto& model : models) {
+    auto matrix = mvp * model;
+    for (auto& mesh : meshes_) {
+      std::vector<glm::vec3> window(mesh.positions.size() / 3);
+      for (size_t i = 0; i < window.size(); ++i) {
+        auto clip = matrix * glm::vec4(mesh.positions[3 * i],
+                                       mesh.positions[3 * i + 1],
+                                       mesh.positions[3 * i + 2], 1);
+        auto ndc = glm::vec3(clip) / clip.w;
+        window[i] = (ndc * 0.5f + 0.5f) * glm::vec3(n, n, 1);
+      }
+      for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        Triangle triangle;
+        for (int j = 0; j < 3; ++j)
+          triangle.v[j] = window[mesh.indices[i + j]];
+        float lo = std::min(triangle.v[0].y,
+                            std::min(triangle.v[1].y, triangle.v[2].y));
+        float hi = std::max(triangle.v[0].y,
+                            std::max(triangle.v[1].y, triangle.v[2].y));
+        int row0 = std::max((int)std::ceil(lo - 0.5f), 0);
+        int row1 = std::min((int)std::floor(hi - 0.5f), n - 1);
+        if (row0 > row1)
+          continue;
+        for (int band = row0 / BAND_ROWS; band <= row1 / BAND_ROWS; ++band)
+          bands[band].push_back(triangles.size());
+        triangles.push_back(triangle);
+      }
+    }
+  }
+
+  ParallelFor(n_bands, [&](int band) {
+    int row_begin = band * BAND_ROWS;
+    for (int triangle : bands[band]) {
+      RasterizeTriangle(triangles[triangle], row_begin,
+                        row_begin + BAND_ROWS, volume);
+    }
+    // Each voxel is the parity of the toggles behind it (at its depth or
+    // further): a suffix parity inside each word, and the parity of the
+    // words behind flips the whole word
+    int n_words = n / 32;
+    for (int y = row_begin; y < row_begin + BAND_ROWS; ++y) {
+      for (int x = 0; x < n; ++x) {
+        uint32_t behind = 0;
+        for (int word = n_words - 1; word >= 0; --word) {
+          uint32_t bits = volume->GetWord(x, y, word);
+          bits ^= bits >> 1;
+          bits ^= bits >> 2;
+          bits ^= bits >> 4;
+          bits ^= bits >> 8;
+          bits ^= bits >> 16;
+          bits ^= behind;
+          behind = bits & 1 ? 0xFFFFFFFFu : 0;
+          volume->SetWord(x, y, word, bits);
+        }
+      }
+    }
+  });
+}
@@ -0,0 +1,73 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef VOXELIZER_H
+#define VOXELIZER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class VoxelVolume;
+
+/**
+ * Solid voxelization of triangle meshes on the cpu, with the rule of the
+ * slice map voxelization: the triangle that covers the centre of a column
+ * toggles the voxels of the column in front of it, so the voxels inside a
+ * closed mesh are toggled an odd number of times. The toggles are recorded
+ * as one bit per triangle and the voxels are obtained with a suffix parity
+ * of the bits of each column, 32 voxels at a time.
+ */
+class Voxelizer {
+public:
+  /**
+   * Default constructor
+   */
+  Voxelizer();
+
+  /**
+   * Adds a mesh, x, y, z positions in object space and triangles indices
+   */
+  void AddMesh(const std::vector<float>& positions,
+               const std::vector<unsigned int>& indices);
+
+  /**
+   * Voxelizes an instance of the meshes for each model matrix into the
+   * volume, using all the cpu cores; mvp maps the object space to the clip
+   * space of the volume (an orthographic projection)
+   */
+  void Voxelize(const glm::mat4& mvp, const std::vector<glm::mat4>& models,
+                VoxelVolume *volume) const;
+
+private:
+  struct Mesh {
+    std::vector<float> positions;
+    std::vector<unsigned int> indices;
+  };
+
+  std::vector<Mesh> meshes_;
+};
+
+#endif
@@ -22,9 +22,10 @@
  * SOFTWARE.
  */
 
+#include <climits>
 #include <cmath>
-#include <ctime>
 #include <cstdio>
+#include <cstring>
 #include <vector>
 #include <iostream>
 
@@ -36,12 +37,32 @@
 #include <lodepng.h>
 #include <tiny_obj_loader.h>
 
+#include "BlueNoise.h"
+#include "Bounds.h"
+#include "BrickVolume.h"
+#include "DistanceField.h"
 #include "FrameBuffer.h"
+#include "Lightmap.h"
 #include "Manipulator.h"
+#include "OcclusionBaker.h"
+#include "Parallel.h"
+#include "PlyFile.h"
 #include "ShaderProgram.h"
+#include "SliceMapFile.h"
+#include "SparseVoxelDAG.h"
+#include "SparseVoxelOctree.h"
+#include "StorageBuffer.h"
+#include "TimerQuery.h"
 #include "UniformBuffer.h"
 #include "VertexArray.h"
+#include "VolumeFile.h"
+#include "VolumeReadback.h"
+#include "Voxelizer.h"
+#include "VoxelMesh.h"
+#include "VoxelVolume.h"
 #include "Texture1D.h"
+#include "Texture2D.h"
+#include "Texture3D.h"
 
 // Materials
 enum MaterialID { OBJECT_MATERIAL };
@@ -50,12 +71,15 @@ enum MaterialID { OBJECT_MATERIAL };
 const float NEAR = 0.1;
 const float FAR = 5.0;
 
-// The main Object path
-const char *OBJECT_PATH = "data/sdragon.obj";
+// The main Object path (--object=<file.obj>)
+const char *object_path = "data/sdragon.obj";
 
 // Rotation speed
 const float ROTATION_SPEED = 70.0f;
 
+// Frames measured by each benchmark configuration
+const int BENCHMARK_FRAMES = 100;
+
 // Description of the program controls
 const char *HELP_TEXT =
 "Controls:\n"
@@ -63,7 +87,30 @@ const char *HELP_TEXT =
 "  a: ambient occlusion debug\n"
 "  s: voxelization debug (renders a slice perpendicular to the projection plane)\n"
 "  l: rotates the light\n"
-"  o: rotates the object\n";
+"  o: rotates the object\n"
+"  h: ray traversal steps heatmap\n"
+"  f: distance field (off, gpu jump flooding, cpu exact edt)\n"
+"  v: sparse voxel octree (built from the slice map on first use)\n"
+"  c: ambient occlusion method (ray marching, cone tracing)\n"
+"  k: clipmap cascades centred at the camera (ray marching)\n"
+"  b: voxel volume fit (bounding sphere, oriented bounding box)\n"
+"  p: bricked slice map (page table and brick pool)\n"
+"  t: amortized voxelization (part of the slice map each frame)\n"
+"  m: moves the dynamic instances\n"
+"  i: object volumes (composites the static layer and the moving instances)\n"
+"  g: greedy meshed proxy of the slice map in the geometry pass\n"
+"  y: cpu occupancy queries (probes the view ray on each slice map copy)\n"
+"  x: voxelization mode (parity, surface)\n"
+"  r: ambient occlusion resolution (full, half, quarter)\n"
+"  e: temporal accumulation of the ambient occlusion\n"
+"  u: blue noise rotation of the ambient occlusion rays per pixel\n"
+"  j: interleaved sampling of the ambient occlusion (4x4 sub-images)\n"
+"  d: denoiser iterations of the ambient occlusion (0 to 5)\n"
+"  n: adaptive sampling of the ambient occlusion\n"
+"  w: rays traced per pixel heatmap\n"
+"  z: progressive refinement of the ambient occlusion of still frames\n"
+"  1: world space ambient occlusion cache\n"
+"  2: detail rays of the ambient occlusion cache\n";
 
 // Window size
 int window_w = 1280;
@@ -75,18 +122,128 @@ ShaderProgram geompass_shader;
 // Second deferred shading pass, renders the fragment
 ShaderProgram lightpass_shader;
 
+// Ambient occlusion pass and its upsampling guided by the geometry pass
+ShaderProgram occlusion_shader;
+ShaderProgram occlusion_upsample_shader;
+
+// Deinterleaving of the geometry and reinterleaving of the occlusion of the
+// interleaved sampling
+ShaderProgram occlusion_deinterleave_shader;
+ShaderProgram occlusion_interleave_shader;
+
+// Iteration of the edge-avoiding denoiser of the ambient occlusion
+ShaderProgram occlusion_denoise_shader;
+
 // Voxelization shader
 ShaderProgram voxelization_shader;
 
 // Renders an slice of the slice map
 ShaderProgram slice_shader;
 
+// Distance field jump flooding shaders (seeds, flooding and distances)
+ShaderProgram distance_seed_shader;
+ShaderProgram distance_jfa_shader;
+ShaderProgram distance_final_shader;
+
+// Clipmap voxelization shaders (toggles the voxels of a slab and clears it)
+ShaderProgram clipmap_voxelization_shader;
+ShaderProgram clipmap_mask_shader;
+
+// Builds the first level of the density mip chain from the slice map
+ShaderProgram density_shader;
+
+// Finds the cells of the occlusion cache whose density changed, and traces
+// the occlusion of the cells around them
+ShaderProgram occlusion_cache_diff_shader;
+ShaderProgram occlusion_cache_shader;
+
+// Composites the static layer and the dynamic instances into the slice map
+ShaderProgram composite_shader;
+
+// Surface voxelization shaders (sets the voxels crossed by the triangles and
+// packs them into the slice map buffers)
+ShaderProgram surface_voxelization_shader;
+ShaderProgram surface_pack_shader;
+
+// Geometry pass of the volumetric scenes, casts the view rays in the slice map
+ShaderProgram volume_geompass_shader;
+
 // Geometry framebuffer used in deferred shading
 FrameBuffer geom_framebuffer;
 
+// Ambient occlusion (occlusion factor and traversal steps), traced at
+// 1 / occlusion_scale of the resolution in each axis (--ao-scale) and
+// upsampled to the resolution of the geometry pass if it is reduced
+int occlusion_scale = 2;
+FrameBuffer occlusion_framebuffer;
+FrameBuffer upsampled_occlusion_framebuffer;
+
+// Temporal accumulation of the ambient occlusion (e, --temporal-rays=<n>):
+// each frame traces temporal_rays of the rays, rotating through the set, and
+// blends them with the history of the previous frames (up to max_history
+// samples), reprojected with the previous view and projection. The history
+// is the occlusion target of the previous frame
+bool temporal_occlusion = false;
+int temporal_rays = 8;
+const int max_history = 16;
+bool occlusion_history_valid = false;
+int occlusion_frame = 0;
+FrameBuffer occlusion_history_framebuffer;
+glm::mat4 history_view;
+glm::mat4 history_projection;
+
+// Progressive refinement of the ambient occlusion (z,
+// --progressive=<batches>): while the camera, the object and the lights are
+// static, each frame traces every ray again, rotated by a new offset, and
+// accumulates it in the occlusion target, up to progressive_batches batches.
+// Then the occlusion is converged: it isn't traced anymore, and the main
+// loop waits for the events instead of rendering the same frame
+bool progressive_occlusion = false;
+int progressive_batches = 32;
+int progressive_batch = 0;
+bool refining_occlusion = false;
+
+// Indicates if a key changed what the frame shows, so a converged frame is
+// rendered again (keeping its occlusion)
+bool frame_outdated = false;
+
+// Interleaved sampling of the ambient occlusion (j, --interleaved): the
+// geometry of the traced pixels is deinterleaved in interleave_size x
+// interleave_size sub-images, each one traces a disjoint subset of
+// n_rays / interleave_size^2 rays, and the occlusion is reinterleaved with a
+// geometry-aware blur. The temporal accumulation is off in this mode
+const int interleave_size = 4;
+bool interleaved_occlusion = false;
+FrameBuffer deinterleaved_framebuffer;
+FrameBuffer interleaved_occlusion_framebuffer;
+
+// Adaptive sampling of the ambient occlusion (n, --adaptive-error=<e>): the
+// rays are traced in batches of adaptive_batch, and each pixel stops once
+// the estimated standard error of its occlusion is below adaptive_error, so
+// the open areas trace a batch and the creases every ray. w shows the rays
+// traced per pixel
+bool adaptive_occlusion = false;
+const int adaptive_batch = 8;
+float adaptive_error = 0.02f;
+
+// Edge-avoiding a-trous denoiser of the traced occlusion (d,
+// --denoise=<iterations>): each iteration filters the occlusion with the
+// taps 2^iteration pixels apart, weighted by the normals and the positions
+// of the geometry pass, ping-ponging between the denoise targets. The
+// history of the temporal accumulation keeps the noisy occlusion
+int denoise_iterations = 0;
+const int max_denoise_iterations = 5;
+FrameBuffer denoise_framebuffers[2];
+
 // Volume framebuffer used for ambient occlusion
 FrameBuffer voxel_framebuffer;
 
+// Slice map rebuilt over several frames by the amortized voxelization
+FrameBuffer voxel_back_framebuffer;
+
+// Clipmap cascades, stacked along y, each one a slice map of 256^3 voxels
+FrameBuffer clipmap_framebuffer;
+
 // Materials information
 UniformBuffer materials;
 
@@ -99,9 +256,42 @@ UniformBuffer object_matrices;
 // Uniformely distributed vectors arround a sphere
 UniformBuffer rays;
 
+// Cpu copy of the rays, used by the occlusion baker
+std::vector<glm::vec3> ray_directions;
+
 // The main object meshes
 std::vector<VertexArray> object_meshes;
 
+// Bounding volumes of the main object meshes, of all the instances and
+// without the instance transformations
+Bounds scene_bounds;
+Bounds object_bounds;
+
+// Number of triangles of the scene (all the instances)
+size_t n_scene_triangles = 0;
+
+// Greedy meshed surface of the slice map, in object space; it replaces the
+// scene in the geometry pass while it is enabled, and it is extracted again
+// when the slice map changes
+VoxelMesh proxy_mesh;
+VertexArray proxy_vao;
+bool use_proxy_mesh = false;
+bool proxy_mesh_outdated = true;
+
+// Cpu copy of the slice map for the occupancy queries (ray and point queries
+// of the gameplay code), the voxelization matrix of the copy and the frame
+// its readback was started. With --cpu-voxelizer the object meshes are
+// voxelized on the cpu instead of read back from the slice map
+VoxelVolume query_volume;
+VolumeReadback query_readback;
+glm::mat4 query_volume_mvp(0);
+glm::mat4 pending_query_mvp(0);
+int query_readback_frame = 0;
+bool occupancy_queries = false;
+bool query_volume_outdated = true;
+bool use_cpu_voxelizer = false;
+Voxelizer cpu_voxelizer;
+
 // Quad that convers the screen
 VertexArray screen_quad;
 
@@ -111,15 +301,107 @@ Manipulator manipulator;
 // Voxel depth LUT
 Texture1D voxel_depth_lut;
 
+// Low resolution distance field used to skip the empty space
+Texture3D distance_field;
+
+// Jump flooding ping-pong textures, nearest seed of each cell
+Texture3D distance_seeds[2];
+
+// Fraction of active voxels, with mipmaps, used by the cone tracing
+Texture3D density;
+
+// World space ambient occlusion cache (1, --occlusion-cache): a grid over
+// the volume with the occlusion of the cells next to the surface, traced
+// from their center after the slice map changes, but only within the reach
+// of the rays around the cells whose density changed (cache_density keeps
+// the density of the last update). The pixels sample it instead of tracing,
+// optionally plus detail_rays short rays, detail_cells long, for the contact
+// occlusion (2, --detail-rays), whose maximum with the cache is kept. It
+// uses the ray marching of the slice map
+bool use_occlusion_cache = false;
+const int occlusion_cache_resolution = 128;
+bool occlusion_cache_outdated = true;
+const int detail_rays = 4;
+const float detail_cells = 2;
+bool use_detail_rays = false;
+Texture3D occlusion_cache;
+Texture3D occlusion_cache_density;
+StorageBuffer occlusion_cache_dirty;
+
+// Ambient occlusion of the object vertices, baked on the cpu into a PLY file
+// (--bake-ao=<file.ply>, which exits after writing it) with the ray set and
+// the ray length of the occlusion pass. When a baked file is loaded
+// (--baked-ao=<file.ply>), the geometry pass keeps the occlusion of the
+// vertices in the G-buffer and the occlusion pass is skipped, except for
+// the proxy mesh
+bool use_baked_occlusion = false;
+const char *baked_occlusion_path = nullptr;
+
+// Ambient occlusion baked in the texture space of the object into a gray PNG
+// (--bake-lightmap=<file.png>, which exits after writing it), with
+// lightmap_size^2 texels (--lightmap-size=<n>). A loaded lightmap
+// (--lightmap=<file.png>) is sampled by the geometry pass, which keeps it in
+// the G-buffer as the baked occlusion of the vertices
+const char *lightmap_path = nullptr;
+int lightmap_size = 1024;
+const int lightmap_padding = 4;
+Texture2D lightmap;
+
+// Ambient occlusion strength, used by the lightpass and for the colors of
+// the baked vertices
+const float occlusion_factor = 2.0f;
+
+// Cpu copy of the slice map and its distance field (cpu fallback)
+VoxelVolume cpu_volume;
+DistanceField cpu_distance_field;
+
+// Bricked copy of the slice map, its page table and its brick pool
+BrickVolume bricks;
+Texture3D brick_table;
+Texture2D brick_pool;
+
+// Sparse voxel octree built from the slice map and its gpu copy
+SparseVoxelOctree svo;
+StorageBuffer svo_buffer;
+
+// Lightpass statistics (total traversal steps and pixels)
+StorageBuffer lightpass_statistics;
+
+// Gpu time of each pass
+TimerQuery voxelization_timer;
+TimerQuery distance_field_timer;
+TimerQuery density_timer;
+TimerQuery clipmap_timer;
+TimerQuery occlusion_timer;
+TimerQuery lighting_timer;
+
 // Global matrices
 glm::mat4 view;
 glm::mat4 ortho_projection;
 glm::mat4 perspective_projection;
 
+// Ortho projection of the volume fitted to the oriented bounding box, in
+// object space
+glm::mat4 volume_projection;
+
+// Ortho projection of the sparse voxel octree, in object space
+glm::mat4 svo_projection;
+
 // Model matrices
 glm::mat4 light_model;
 glm::mat4 object_model;
 
+// Object instances (--instances), in a square grid in the object space; the
+// last ones (--dynamic-instances) spin around their centres while the
+// animation is enabled, the others are static. They are limited by the size
+// of the matrices block
+const int max_instances = 100;
+int n_instances = 1;
+int n_dynamic_instances = 0;
+std::vector<glm::mat4> instance_models(1, glm::mat4(1));
+bool animate_instances = false;
+bool instances_moved = false;
+
 // Mapping matrix, transform from clip to window space
 glm::mat4 mapping_matrix;
 
@@ -140,8 +422,31 @@ float scene_radius = 0;
 const int n_volume_buffers = 8;
 const int volume_resolution = 128 * n_volume_buffers;
 
-// Number of rays used in the Monte Carlo integration
-const int n_rays = 32;
+// Number of rays used in the Monte Carlo integration (--rays=<n>, at most
+// 256)
+int n_rays = 32;
+
+// How the ray set is generated (--ray-set=random|hammersley|sobol), always
+// from ray_seed (--ray-seed=<n>), so every run traces the same rays: uniform
+// random directions, or a cosine weighted Hammersley or Sobol' set, whose
+// points are evenly spread over the hemisphere. The consecutive rays of the
+// Sobol' set are evenly spread too, so it suits the batches of the adaptive
+// sampling and the subsets of the temporal and interleaved sampling
+enum RaySet {
+  RAY_SET_RANDOM,
+  RAY_SET_HAMMERSLEY,
+  RAY_SET_SOBOL,
+  RAY_SET_NUMBER,
+};
+RaySet ray_set = RAY_SET_SOBOL;
+const char *RAY_SET_NAMES[] = {"random", "hammersley", "sobol"};
+unsigned int ray_seed = 1;
+
+// Blue noise rotation of the ray set around the normal of each pixel (u,
+// --no-rotation-noise); the tile is generated from the ray seed
+bool use_rotation_noise = true;
+const int rotation_noise_size = 64;
+Texture2D rotation_noise;
 
 // The max distance traveled by each ray
 //const float step_size = sqrt(3.0f) / (float) volume_resolution;
@@ -149,6 +454,25 @@ const float step_size = 1.0f / (float) volume_resolution;
 const int max_steps = n_volume_buffers * 20;
 const float max_distance = max_steps * step_size;
 
+// Distance field resolution, each cell covers 8^3 voxels
+const int distance_field_resolution = 128;
+
+// Number of cones used by the cone tracing (N_CONES in the lightpass)
+const int n_cones = 6;
+
+// Density mip chain resolution, each texel covers 2^3 voxels
+const int density_resolution = volume_resolution / 2;
+
+// Clipmap cascades; each one covers twice the extent of the previous one and
+// the first one covers the scene radius
+const int clipmap_levels = 4;
+const int clipmap_resolution = 256;
+const int clipmap_buffers = clipmap_resolution / 128;
+
+// Sparse voxel octree resolution (--svo-resolution), it is voxelized in
+// tiles with the slice map resolution
+int svo_resolution = 4096;
+
 // Indicates if the rotation is enabled
 bool light_rotation = false;
 bool object_rotation = false;
@@ -161,10 +485,140 @@ enum Mode {
   MODE_FULL_LIGHTING,
   MODE_DIFFUSE_ONLY,
   MODE_OCCLUSION_DEBUG,
+  MODE_STEPS_DEBUG,
+  MODE_RAYS_DEBUG,
   MODE_NUMBER,
 };
 Mode mode = MODE_FULL_LIGHTING;
 
+// How the distance field is built (or if it isn't used at all)
+enum DistanceFieldMode {
+  DISTANCE_FIELD_OFF,
+  DISTANCE_FIELD_GPU,
+  DISTANCE_FIELD_CPU,
+  DISTANCE_FIELD_MODE_NUMBER,
+};
+DistanceFieldMode distance_field_mode = DISTANCE_FIELD_GPU;
+const char *DISTANCE_FIELD_MODE_NAMES[] = {"off", "gpu jump flooding",
+                                           "cpu exact edt"};
+
+// How the ambient occlusion is computed
+enum AmbientOcclusionMethod {
+  AO_RAY_MARCHING,
+  AO_CONE_TRACING,
+  AO_METHOD_NUMBER,
+};
+AmbientOcclusionMethod ao_method = AO_RAY_MARCHING;
+const char *AO_METHOD_NAMES[] = {"ray marching", "cone tracing"};
+
+// How the voxel volume is fitted to the object
+enum FitMode {
+  FIT_SPHERE,
+  FIT_ORIENTED_BOX,
+  FIT_MODE_NUMBER,
+};
+FitMode fit_mode = FIT_ORIENTED_BOX;
+const char *FIT_MODE_NAMES[] = {"bounding sphere", "oriented bounding box"};
+
+// How the object is voxelized: the parity of the surfaces in front of each
+// voxel fills the inside of watertight meshes, the surface mode sets the
+// voxels crossed by the triangles, so open meshes are voxelized correctly (as
+// a shell) in a single pass. The surface voxels are words of 32 voxels of a
+// column, packed into the slice map buffers afterwards
+enum VoxelizationMode {
+  VOXELIZATION_PARITY,
+  VOXELIZATION_SURFACE,
+  VOXELIZATION_MODE_NUMBER,
+};
+VoxelizationMode voxelization_mode = VOXELIZATION_PARITY;
+const char *VOXELIZATION_MODE_NAMES[] = {"parity", "surface"};
+Texture3D surface_words;
+
+// The voxelization matrix of the current slice map; the slice map and the
+// structures built from it are only updated when it changes
+glm::mat4 slice_map_mvp(0);
+bool distance_field_outdated = true;
+bool density_outdated = true;
+
+// Amortized voxelization: the slice map is rebuilt in a back buffer over
+// amortization_frames frames (--amortization-frames), rendering some of the
+// buffers each frame, and swapped when complete. The lightpass maps through
+// the matrix of the front slice map, so a stale slice map still follows the
+// object; everything is voxelized at once if it is older than max_staleness
+// frames (--max-staleness) or if the volume moved more than max_motion
+// voxels (--max-motion) since it was voxelized
+bool amortized_voxelization = false;
+int amortization_frames = 4;
+int max_staleness = 16;
+float max_motion = 256;
+
+// Voxelization matrix of the back slice map and the next buffer to render
+// (0 if no update is in progress)
+glm::mat4 back_slice_map_mvp(0);
+int back_next_buffer = 0;
+
+// Frames updated by UpdateVolume, the frame whose matrices were used by the
+// front and by the back slice maps, and the number of full voxelizations
+int volume_frame = 0;
+int slice_map_frame = 0;
+int back_slice_map_frame = 0;
+int n_full_voxelizations = 0;
+
+// Object volumes: the object is voxelized once in its own space, and the
+// slice map is the static layer (the static instances voxelized with the
+// slice map projection) composited with the dynamic instances, which sample
+// the object volume. Only the regions covered by the instances that moved are
+// composited again, so the static instances are voxelized once
+struct VoxelRegion {
+  glm::ivec3 begin;
+  glm::ivec3 end;
+};
+const int object_volume_resolution = 256;
+const int max_dynamic_instances = 16;
+bool use_object_volumes = false;
+FrameBuffer object_volume_framebuffer;
+FrameBuffer static_layer_framebuffer;
+glm::mat4 object_volume_projection;
+glm::mat4 static_layer_mvp(0);
+bool object_volume_outdated = true;
+std::vector<VoxelRegion> dynamic_instance_regions;
+long long composited_voxels = 0;
+
+// Indicates if the bricked slice map is used instead of the dense one
+bool use_bricks = false;
+bool bricks_outdated = true;
+
+// Indicates if the clipmap cascades are used instead of the slice map
+bool use_clipmap = false;
+
+// Grid position of the first voxel of each cascade and the object matrix
+// used to voxelize them; the cascades are rebuilt if the object moves
+glm::ivec3 clipmap_origins[clipmap_levels];
+glm::mat4 clipmap_object_model(0);
+
+// Voxels updated by the last clipmap update
+long long clipmap_updated_voxels = 0;
+
+// Indicates if the sparse voxel octree is used instead of the slice map
+bool use_svo = false;
+
+// Indicates if the lightpass statistics are collected
+bool collect_statistics = false;
+
+// Volumetric scene (--load-volume), a .vox file or a raw volume of bytes
+// whose size is given by --volume-size (the voxels of value at least
+// --volume-threshold are active). It is packed straight into the slice map,
+// so it is never voxelized, and its geometry pass casts the view rays in it
+bool volume_scene = false;
+std::string volume_path;
+glm::ivec3 raw_volume_size(0);
+int raw_volume_threshold = 1;
+
+// Indicates if the volumetric scene is a .vox file, otherwise it's raw
+bool IsVoxFile(const std::string& path) {
+  return path.substr(path.find_last_of('.') + 1) == "vox";
+}
+
 // Verifies the condition, if it fails, shows the error message and
 // exits the program
 #define Assert(condition, message) Assertf(condition, message, 0)
@@ -178,32 +632,134 @@ Mode mode = MODE_FULL_LIGHTING;
     }                                                                          \
   }
 
+// Obtains the size of the sub-images of the interleaved sampling, which
+// cover the traced pixels
+glm::ivec2 GetSubImageSize() {
+  int width = (window_w + occlusion_scale - 1) / occlusion_scale;
+  int height = (window_h + occlusion_scale - 1) / occlusion_scale;
+  return glm::ivec2((width + interleave_size - 1) / interleave_size,
+                    (height + interleave_size - 1) / interleave_size);
+}
+
 // Creates the framebuffer used for deferred shading
 void LoadFramebuffer() {
-  // Creates the position, normal and material textures
+  // Creates the position, normal and material textures (the material has
+  // the baked occlusion in the second channel)
   geom_framebuffer.Init(window_w, window_h);
   geom_framebuffer.AddColorTexture(GL_RGB32F, GL_RGB, GL_FLOAT);
   geom_framebuffer.AddColorTexture(GL_RGB32F, GL_RGB, GL_FLOAT);
-  geom_framebuffer.AddColorTexture(GL_R8, GL_RED, GL_UNSIGNED_BYTE);
+  geom_framebuffer.AddColorTexture(GL_RG8, GL_RG, GL_UNSIGNED_BYTE);
   try {
     geom_framebuffer.Verify();
   } catch (std::exception &e) {
     Assertf(false, "%s", e.what());
   }
+  // Creates the occlusion targets (occlusion, steps, samples and rays, the
+  // occlusion again and the surface of the pixel, 20 bytes per pixel); only
+  // the copy of the occlusion blended by the history is a float buffer,
+  // which keeps the precision of the progressive refinement, the half
+  // floats hold the counts and the view depth within the tolerances
+  int scale = occlusion_scale;
+  for (auto framebuffer : {&occlusion_framebuffer,
+                           &occlusion_history_framebuffer}) {
+    framebuffer->Init((window_w + scale - 1) / scale,
+                      (window_h + scale - 1) / scale);
+    framebuffer->AddColorTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    framebuffer->AddColorTexture(GL_R32F, GL_RED, GL_FLOAT);
+    framebuffer->AddColorTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+  }
+  upsampled_occlusion_framebuffer.Init(window_w, window_h);
+  upsampled_occlusion_framebuffer.AddColorTexture(GL_RGBA16F, GL_RGBA,
+                                                  GL_FLOAT);
+  // Creates the targets of the interleaved sampling, with the layout of the
+  // geometry and occlusion targets
+  auto sub_image_size = GetSubImageSize();
+  deinterleaved_framebuffer.Init(sub_image_size.x * interleave_size,
+                                 sub_image_size.y * interleave_size);
+  deinterleaved_framebuffer.AddColorTexture(GL_RGB32F, GL_RGB, GL_FLOAT);
+  deinterleaved_framebuffer.AddColorTexture(GL_RGB32F, GL_RGB, GL_FLOAT);
+  deinterleaved_framebuffer.AddColorTexture(GL_R8, GL_RED, GL_UNSIGNED_BYTE);
+  interleaved_occlusion_framebuffer.Init(sub_image_size.x * interleave_size,
+                                         sub_image_size.y * interleave_size);
+  interleaved_occlusion_framebuffer.AddColorTexture(GL_RGBA16F, GL_RGBA,
+                                                    GL_FLOAT);
+  interleaved_occlusion_framebuffer.AddColorTexture(GL_R32F, GL_RED,
+                                                    GL_FLOAT);
+  interleaved_occlusion_framebuffer.AddColorTexture(GL_RGBA16F, GL_RGBA,
+                                                    GL_FLOAT);
+  for (auto &framebuffer : denoise_framebuffers) {
+    framebuffer.Init((window_w + scale - 1) / scale,
+                     (window_h + scale - 1) / scale);
+    framebuffer.AddColorTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+  }
+  try {
+    occlusion_framebuffer.Verify();
+    occlusion_history_framebuffer.Verify();
+    upsampled_occlusion_framebuffer.Verify();
+    deinterleaved_framebuffer.Verify();
+    interleaved_occlusion_framebuffer.Verify();
+    for (auto &framebuffer : denoise_framebuffers)
+      framebuffer.Verify();
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+}
+
+// Changes the resolution of the ambient occlusion to 1 / scale of the
+// resolution of the geometry pass
+void SetOcclusionScale(int scale) {
+  occlusion_scale = scale;
+  occlusion_framebuffer.Resize((window_w + scale - 1) / scale,
+                               (window_h + scale - 1) / scale);
+  occlusion_history_framebuffer.Resize((window_w + scale - 1) / scale,
+                                       (window_h + scale - 1) / scale);
+  auto sub_image_size = GetSubImageSize();
+  deinterleaved_framebuffer.Resize(sub_image_size.x * interleave_size,
+                                   sub_image_size.y * interleave_size);
+  interleaved_occlusion_framebuffer.Resize(sub_image_size.x * interleave_size,
+                                           sub_image_size.y * interleave_size);
+  for (auto &framebuffer : denoise_framebuffers)
+    framebuffer.Resize((window_w + scale - 1) / scale,
+                       (window_h + scale - 1) / scale);
+  occlusion_history_valid = false;
+}
+
+// Creates a framebuffer with the slice map buffers
+void CreateSliceMapFramebuffer(FrameBuffer& framebuffer) {
+  framebuffer.Init(volume_resolution, volume_resolution);
+  for (int i = 0; i < n_volume_buffers; ++i) {
+    framebuffer.AddColorTexture(GL_RGBA32UI, GL_RGBA_INTEGER,
+                                GL_UNSIGNED_INT);
+  }
+  try {
+    framebuffer.Verify();
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
 }
 
 // Creates the framebuffer used for voxelization
 void LoadSliceMap() {
-  voxel_framebuffer.Init(volume_resolution, volume_resolution);
-  for (int i = 0; i < n_volume_buffers; ++i) {
-    voxel_framebuffer.AddColorTexture(GL_RGBA32UI, GL_RGBA_INTEGER,
-                                      GL_UNSIGNED_INT);
+  CreateSliceMapFramebuffer(voxel_framebuffer);
+  surface_words.LoadTexture(nullptr, volume_resolution, volume_resolution,
+                            volume_resolution / 32, GL_R32UI, GL_RED_INTEGER,
+                            GL_UNSIGNED_INT);
+}
+
+// Creates the framebuffer of the clipmap cascades
+void LoadClipmap() {
+  clipmap_framebuffer.Init(clipmap_resolution,
+                           clipmap_resolution * clipmap_levels);
+  for (int i = 0; i < clipmap_buffers; ++i) {
+    clipmap_framebuffer.AddColorTexture(GL_RGBA32UI, GL_RGBA_INTEGER,
+                                        GL_UNSIGNED_INT);
   }
   try {
-    voxel_framebuffer.Verify();
+    clipmap_framebuffer.Verify();
   } catch (std::exception &e) {
     Assertf(false, "%s", e.what());
   }
+  clipmap_timer.Init();
 }
 
 // Loads all shaders
@@ -215,17 +771,108 @@ void LoadShaders() {
     lightpass_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
     lightpass_shader.LoadFragmentShader("shaders/lightpass_fs.glsl");
     lightpass_shader.LinkShader();
+    occlusion_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
+    occlusion_shader.LoadFragmentShader("shaders/occlusion_fs.glsl");
+    occlusion_shader.LinkShader();
+    occlusion_upsample_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
+    occlusion_upsample_shader.LoadFragmentShader(
+        "shaders/occlusion_upsample_fs.glsl");
+    occlusion_upsample_shader.LinkShader();
+    occlusion_deinterleave_shader.LoadVertexShader(
+        "shaders/lightpass_vs.glsl");
+    occlusion_deinterleave_shader.LoadFragmentShader(
+        "shaders/occlusion_deinterleave_fs.glsl");
+    occlusion_deinterleave_shader.LinkShader();
+    occlusion_interleave_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
+    occlusion_interleave_shader.LoadFragmentShader(
+        "shaders/occlusion_interleave_fs.glsl");
+    occlusion_interleave_shader.LinkShader();
+    occlusion_denoise_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
+    occlusion_denoise_shader.LoadFragmentShader(
+        "shaders/occlusion_denoise_fs.glsl");
+    occlusion_denoise_shader.LinkShader();
     voxelization_shader.LoadVertexShader("shaders/geompass_vs.glsl");
     voxelization_shader.LoadFragmentShader("shaders/voxelization_fs.glsl");
     voxelization_shader.LinkShader();
     slice_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
     slice_shader.LoadFragmentShader("shaders/slice_fs.glsl");
     slice_shader.LinkShader();
+    distance_seed_shader.LoadComputeShader("shaders/distance_seed_cs.glsl");
+    distance_seed_shader.LinkShader();
+    distance_jfa_shader.LoadComputeShader("shaders/distance_jfa_cs.glsl");
+    distance_jfa_shader.LinkShader();
+    distance_final_shader.LoadComputeShader("shaders/distance_final_cs.glsl");
+    distance_final_shader.LinkShader();
+    density_shader.LoadComputeShader("shaders/density_cs.glsl");
+    density_shader.LinkShader();
+    occlusion_cache_diff_shader.LoadComputeShader(
+        "shaders/occlusion_cache_diff_cs.glsl");
+    occlusion_cache_diff_shader.LinkShader();
+    occlusion_cache_shader.LoadComputeShader(
+        "shaders/occlusion_cache_cs.glsl");
+    occlusion_cache_shader.LinkShader();
+    composite_shader.LoadComputeShader("shaders/composite_cs.glsl");
+    composite_shader.LinkShader();
+    surface_voxelization_shader.LoadVertexShader("shaders/geompass_vs.glsl");
+    surface_voxelization_shader.LoadGeometryShader(
+        "shaders/surface_voxelization_gs.glsl");
+    surface_voxelization_shader.LoadFragmentShader(
+        "shaders/surface_voxelization_fs.glsl");
+    surface_voxelization_shader.LinkShader();
+    surface_pack_shader.LoadComputeShader("shaders/surface_pack_cs.glsl");
+    surface_pack_shader.LinkShader();
+    volume_geompass_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
+    volume_geompass_shader.LoadFragmentShader(
+        "shaders/volume_geompass_fs.glsl");
+    volume_geompass_shader.LinkShader();
+    clipmap_voxelization_shader.LoadVertexShader("shaders/geompass_vs.glsl");
+    clipmap_voxelization_shader.LoadFragmentShader(
+        "shaders/clipmap_voxelization_fs.glsl");
+    clipmap_voxelization_shader.LinkShader();
+    clipmap_mask_shader.LoadVertexShader("shaders/lightpass_vs.glsl");
+    clipmap_mask_shader.LoadFragmentShader("shaders/clipmap_mask_fs.glsl");
+    clipmap_mask_shader.LinkShader();
   } catch (std::exception &e) {
     Assertf(false, "%s", e.what());
   }
 }
 
+// Empties the occlusion cache, so the next update traces every cell
+void ResetOcclusionCache() {
+  const float empty[] = {0, 0};
+  const float unknown = -1;
+  glClearTexImage(occlusion_cache.GetId(), 0, GL_RG, GL_FLOAT, empty);
+  glClearTexImage(occlusion_cache_density.GetId(), 0, GL_RED, GL_FLOAT,
+                  &unknown);
+  occlusion_cache_outdated = true;
+}
+
+// Creates the distance field textures and the pass timers
+void LoadDistanceField() {
+  const int N = distance_field_resolution;
+  distance_field.LoadTexture(nullptr, N, GL_R16F, GL_RED, GL_FLOAT);
+  for (auto& seeds : distance_seeds)
+    seeds.LoadTexture(nullptr, N, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+  cpu_distance_field.Init(N);
+  density.LoadTexture(nullptr, density_resolution, GL_R8, GL_RED,
+                      GL_UNSIGNED_BYTE);
+  occlusion_cache.LoadTexture(nullptr, occlusion_cache_resolution, GL_RG16F,
+                              GL_RG, GL_FLOAT);
+  occlusion_cache.SetFilter(GL_LINEAR);
+  occlusion_cache_density.LoadTexture(nullptr, occlusion_cache_resolution,
+                                      GL_R16F, GL_RED, GL_FLOAT);
+  occlusion_cache_dirty.Init();
+  ResetOcclusionCache();
+  svo_buffer.Init();
+  lightpass_statistics.Init();
+  lightpass_statistics.SetData(nullptr, 2 * sizeof(uint32_t));
+  voxelization_timer.Init();
+  distance_field_timer.Init();
+  density_timer.Init();
+  occlusion_timer.Init();
+  lighting_timer.Init();
+}
+
 // Creates the voxel depth lookup texture
 void CreateVoxelDepthLUT() {
   const int N = 128;
@@ -242,30 +889,97 @@ void CreateVoxelDepthLUT() {
                               GL_UNSIGNED_INT);
 }
 
+// Reverses the bits of a word, its base 2 radical inverse times 2^32
+uint32_t ReverseBits(uint32_t bits) {
+  bits = (bits << 16) | (bits >> 16);
+  bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+  bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+  bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+  bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+  return bits;
+}
+
+// Obtains the second coordinate of the point i of the (0, 2)-sequence of
+// Sobol' times 2^32; the first one is the radical inverse of i
+uint32_t SobolSecond(uint32_t i) {
+  uint32_t bits = 0;
+  for (uint32_t v = 1u << 31; i; i >>= 1, v ^= v >> 1) {
+    if (i & 1)
+      bits ^= v;
+  }
+  return bits;
+}
+
 // Creates the rays uniform buffer
 void CreateRays() {
   // Buffer configuration
   // layout(std140) uniform RaysBlock { vec3 rays[256]; };
 
   // Generates an random float in [0, 1]
-  srand(time(NULL));
+  srand(ray_seed);
   auto RandomFloat = []() {
     return (float)rand() / (float)RAND_MAX;
   };
 
-  rays.Init();
-  for (int i = 0; i < n_rays; ++i) {
-    glm::vec3 random_vec;
-    do {
-      random_vec.x = 2 * RandomFloat() - 1;
-      random_vec.y = 2 * RandomFloat() - 1;
-      random_vec.z = RandomFloat();
-    } while (length(random_vec) > 1);
-    rays.Add(glm::normalize(random_vec));
+  if (!rays.GetId())
+    rays.Init();
+  else
+    rays.Clear();
+  // The disk of radius sqrt(u) lifted to the hemisphere is cosine
+  // distributed
+  ray_directions.clear();
+  auto AddCosineRay = [](float u, float v) {
+    float r = sqrt(u);
+    float phi = 2 * M_PI * v;
+    ray_directions.push_back(glm::vec3(r * cos(phi), r * sin(phi),
+                                       sqrt(1 - u)));
+  };
+  if (ray_set == RAY_SET_HAMMERSLEY) {
+    // The point i is ((i + 0.5) / n, radical inverse of i), scrambled by a
+    // toroidal shift of the first coordinate and a xor of the bits of the
+    // second (both keep the points stratified)
+    float shift = RandomFloat();
+    uint32_t scramble = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    for (int i = 0; i < n_rays; ++i) {
+      float u = fmod((i + 0.5f) / n_rays + shift, 1.0f);
+      float v = (ReverseBits(i) ^ scramble) / 4294967296.0f;
+      AddCosineRay(u, v);
+    }
+  } else if (ray_set == RAY_SET_SOBOL) {
+    // Every aligned block of 2^m consecutive points of the sequence is
+    // stratified in 2^m cells of any shape, also after a xor of the bits of
+    // both coordinates
+    uint32_t scramble_u = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    uint32_t scramble_v = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    for (int i = 0; i < n_rays; ++i) {
+      float u = (ReverseBits(i) ^ scramble_u) / 4294967296.0f;
+      float v = (SobolSecond(i) ^ scramble_v) / 4294967296.0f;
+      AddCosineRay(u, v);
+    }
+  } else {
+    for (int i = 0; i < n_rays; ++i) {
+      glm::vec3 random_vec;
+      do {
+        random_vec.x = 2 * RandomFloat() - 1;
+        random_vec.y = 2 * RandomFloat() - 1;
+        random_vec.z = RandomFloat();
+      } while (length(random_vec) > 1);
+      ray_directions.push_back(glm::normalize(random_vec));
+    }
   }
+  for (auto& ray : ray_directions)
+    rays.Add(ray);
   rays.SendToDevice();
 }
 
+// Creates the blue noise tile that rotates the rays of each pixel
+void CreateRotationNoise() {
+  BlueNoise noise;
+  noise.Generate(rotation_noise_size, ray_seed);
+  rotation_noise.LoadTexture(noise.GetValues().data(), rotation_noise_size,
+                             rotation_noise_size, GL_R32F, GL_RED, GL_FLOAT);
+}
+
 // Loads the materials
 void CreateMaterialsBuffer() {
   // Buffer configuration
@@ -313,31 +1027,247 @@ void LoadMesh(VertexArray *vao, tinyobj::mesh_t *mesh) {
   vao->AddArray(1, mesh->normals.data(), mesh->normals.size(), 3);
 }
 
-// Updates the scene radius given an mesh
-void UpdateSceneRadius(tinyobj::mesh_t *mesh) {
-  auto& vertices = mesh->positions;
-  for (size_t i = 0; i < vertices.size(); i += 3) {
-    float x = vertices[i];
-    float y = vertices[i + 1];
-    float z = vertices[i + 2];
-    float radius = sqrt(x * x + y * y + z * z);
-    scene_radius = std::max(scene_radius, radius);
+// Obtains the size of the voxels of the volume fitted to the oriented
+// bounding box, and the number of voxels the box spans in each axis
+glm::ivec3 GetFittedResolution(float *voxel_size) {
+  auto extents = 2.0f * scene_bounds.GetOrientedBox().half_extents;
+  float side = std::max(extents.x, std::max(extents.y, extents.z));
+  *voxel_size = side / (volume_resolution - 2);
+  return glm::ivec3(glm::ceil(extents / *voxel_size)) + 2;
+}
+
+// Fits the voxel volume to the oriented bounding box; the volume is still a
+// cube of volume_resolution^3 voxels with the longest side of the box (plus
+// one voxel of margin on each side), so the voxels stay cubic and the
+// shorter axes of the box leave empty voxels
+void CreateVolumeProjection() {
+  auto& box = scene_bounds.GetOrientedBox();
+  float voxel_size;
+  GetFittedResolution(&voxel_size);
+  float side = voxel_size * volume_resolution;
+  auto first = -box.half_extents - voxel_size;
+  auto to_box = glm::mat4(glm::transpose(box.axes)) *
+                glm::translate(-box.center);
+  volume_projection = glm::ortho(first.x, first.x + side,
+                                 first.y, first.y + side,
+                                 first.z, first.z + side) * to_box;
+}
+
+// Computes the scene bounds and the volume fitted to them
+void UpdateSceneBounds() {
+  scene_bounds.Compute();
+  auto& sphere = scene_bounds.GetSphere();
+  scene_center = sphere.center;
+  scene_radius = sphere.radius;
+  CreateVolumeProjection();
+
+  float voxel_size;
+  auto resolution = GetFittedResolution(&voxel_size);
+  auto extents = 2.0f * scene_bounds.GetOrientedBox().half_extents;
+  printf("scene bounds: %zu meshes, sphere radius %.3f, oriented box "
+         "%.3f x %.3f x %.3f (%d x %d x %d voxels)\n",
+         scene_bounds.GetMeshBoxes().size(), scene_radius, extents.x,
+         extents.y, extents.z, resolution.x, resolution.y, resolution.z);
+}
+
+// Places the object instances in a square grid centred at the object; they
+// are scaled down so the grid keeps the size of the object, which the camera
+// and the clipping planes expect
+void CreateInstances() {
+  auto& sphere = object_bounds.GetSphere();
+  int side = (int)ceil(sqrt(n_instances));
+  float spacing = 2.5f * sphere.radius / side;
+  auto scale = glm::translate(sphere.center) *
+               glm::scale(glm::vec3(1.0f / side)) *
+               glm::translate(-sphere.center);
+  instance_models.resize(n_instances);
+  for (int i = 0; i < n_instances; ++i) {
+    auto cell = glm::vec2(i % side, i / side) - (side - 1) / 2.0f;
+    instance_models[i] = glm::translate(glm::vec3(cell.x, 0, cell.y) *
+                                        spacing) * scale;
   }
 }
 
-// Loads the object mesh
-void LoadObjectMesh() {
+// Transforms the vertices positions (x, y, z sequences)
+std::vector<float> TransformPositions(const std::vector<float>& positions,
+                                      const glm::mat4& matrix) {
+  std::vector<float> transformed(positions.size());
+  for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+    auto p = matrix * glm::vec4(positions[i], positions[i + 1],
+                                positions[i + 2], 1);
+    transformed[i] = p.x;
+    transformed[i + 1] = p.y;
+    transformed[i + 2] = p.z;
+  }
+  return transformed;
+}
+
+// Reads the shapes of the object file
+std::vector<tinyobj::shape_t> LoadObjectShapes() {
   std::vector<tinyobj::shape_t> shapes;
   std::vector<tinyobj::material_t> materials;
 
   std::string err;
-  bool ret = tinyobj::LoadObj(shapes, materials, err, OBJECT_PATH, "data/");
+  bool ret = tinyobj::LoadObj(shapes, materials, err, object_path, "data/");
   Assertf(err.empty() && ret, "tinyobj error: %s", err.c_str());
+  return shapes;
+}
+
+// Adds the baked occlusion of the vertices to the object meshes, the file
+// has the vertices of all the shapes in order
+void LoadBakedOcclusion(const std::vector<tinyobj::shape_t>& shapes) {
+  std::vector<float> occlusion;
+  try {
+    occlusion = LoadOcclusionPly(baked_occlusion_path);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  size_t n_vertices = 0;
+  for (auto& shape : shapes)
+    n_vertices += shape.mesh.positions.size() / 3;
+  Assertf(occlusion.size() == n_vertices,
+          "the baked occlusion has %zu vertices, the object has %zu",
+          occlusion.size(), n_vertices);
+  size_t first = 0;
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    int n = shapes[i].mesh.positions.size() / 3;
+    object_meshes[i].AddArray(2, occlusion.data() + first, n, 1);
+    first += n;
+  }
+}
+
+// Loads the lightmap and adds the texture coordinates to the object meshes
+void LoadLightmap(const std::vector<tinyobj::shape_t>& shapes) {
+  int width, height;
+  std::vector<unsigned char> texels;
+  try {
+    texels = Lightmap::LoadPng(lightmap_path, &width, &height);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  lightmap.LoadTexture(texels.data(), width, height, GL_R8, GL_RED,
+                       GL_UNSIGNED_BYTE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  lightmap.SetFilter(GL_LINEAR);
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    auto& mesh = shapes[i].mesh;
+    Assert(mesh.texcoords.size() / 2 == mesh.positions.size() / 3,
+           "the object has no texture coordinates");
+    object_meshes[i].AddArray(3, mesh.texcoords.data(),
+                              mesh.texcoords.size(), 2);
+  }
+}
 
+// Loads the object mesh
+void LoadObjectMesh() {
+  auto shapes = LoadObjectShapes();
   object_meshes.resize(shapes.size());
   for (size_t i = 0; i < shapes.size(); ++i) {
     LoadMesh(&object_meshes[i], &shapes[i].mesh);
-    UpdateSceneRadius(&shapes[i].mesh);
+    object_bounds.AddMesh(shapes[i].mesh.positions);
+    n_scene_triangles += shapes[i].mesh.indices.size() / 3 * n_instances;
+    cpu_voxelizer.AddMesh(shapes[i].mesh.positions, shapes[i].mesh.indices);
+  }
+  if (baked_occlusion_path)
+    LoadBakedOcclusion(shapes);
+  if (lightmap_path)
+    LoadLightmap(shapes);
+  object_bounds.Compute();
+  CreateInstances();
+
+  // The dynamic instances may be anywhere inside their bounding spheres
+  auto& sphere = object_bounds.GetSphere();
+  std::vector<float> sphere_box;
+  for (int i = 0; i < 8; ++i) {
+    auto corner = glm::vec3((i & 1) ? 1 : -1, (i & 2) ? 1 : -1,
+                            (i & 4) ? 1 : -1);
+    auto p = sphere.center + corner * sphere.radius;
+    sphere_box.insert(sphere_box.end(), {p.x, p.y, p.z});
+  }
+  int n_static = n_instances - n_dynamic_instances;
+  for (int i = 0; i < n_instances; ++i) {
+    if (i >= n_static) {
+      scene_bounds.AddMesh(TransformPositions(sphere_box,
+                                              instance_models[i]));
+      continue;
+    }
+    for (auto& shape : shapes) {
+      scene_bounds.AddMesh(TransformPositions(shape.mesh.positions,
+                                              instance_models[i]));
+    }
+  }
+  UpdateSceneBounds();
+}
+
+// Loads the volumetric scene into cpu_volume and uploads it to the slice map;
+// prints the load and the upload times
+void LoadVolume() {
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  glm::ivec3 size, offset;
+  double start = glfwGetTime();
+  try {
+    if (IsVoxFile(volume_path))
+      size = LoadVoxFile(volume_path, &cpu_volume, &offset);
+    else
+      size = LoadRawVolume(volume_path, raw_volume_size, raw_volume_threshold,
+                           &cpu_volume, &offset);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  double load_time = (glfwGetTime() - start) * 1000;
+  glFinish();
+  start = glfwGetTime();
+  cpu_volume.WriteToTextures(voxel_framebuffer.GetTextures());
+  glFinish();
+  double upload_time = (glfwGetTime() - start) * 1000;
+  printf("volume %s: %d x %d x %d voxels, %zu active, loaded in %.2f ms, "
+         "uploaded in %.2f ms\n", volume_path.c_str(), size.x, size.y, size.z,
+         cpu_volume.CountActive(), load_time, upload_time);
+
+  // The object space is the volume scaled so the longest side of the scene
+  // spans [-1, 1]
+  float half_side = (float)volume_resolution /
+                    std::max(size.x, std::max(size.y, size.z));
+  auto projection = glm::ortho(-half_side, half_side, -half_side, half_side,
+                               -half_side, half_side);
+  auto object_from_voxel = glm::inverse(glm::scale(glm::vec3(
+      volume_resolution)) * mapping_matrix * projection);
+  std::vector<float> box;
+  for (int i = 0; i < 8; ++i) {
+    auto corner = glm::vec3(offset) +
+                  glm::vec3(size) * glm::vec3(i & 1, (i >> 1) & 1, i >> 2);
+    auto p = object_from_voxel * glm::vec4(corner, 1);
+    box.insert(box.end(), {p.x, p.y, p.z});
+  }
+  scene_bounds.AddMesh(box);
+  UpdateSceneBounds();
+
+  // The fitted volume is the loaded one
+  fit_mode = FIT_ORIENTED_BOX;
+  volume_projection = projection;
+  slice_map_mvp = volume_projection;
+  back_next_buffer = 0;
+  distance_field_outdated = true;
+  density_outdated = true;
+  bricks_outdated = true;
+  proxy_mesh_outdated = true;
+  query_volume_outdated = true;
+}
+
+// Loads the object mesh or the volumetric scene
+void LoadScene() {
+  if (volume_scene)
+    LoadVolume();
+  else
+    LoadObjectMesh();
+}
+
+// Draws the first instances of the object
+void DrawObjectInstances(int n) {
+  for (auto& mesh : object_meshes) {
+    mesh.DrawInstances(GL_TRIANGLES, n);
   }
 }
 
@@ -393,8 +1323,9 @@ void UpdateLightsBuffer() {
   lights.SendToDevice();
 }
 
-// Updates the objects matrices
-void UpdateObjectMatrices(glm::mat4 projection) {
+// Updates the objects matrices, one set for each instance model
+void UpdateObjectMatrices(glm::mat4 projection,
+                          const std::vector<glm::mat4>& models) {
   // Buffer configuration:
   // struct Matrices {
   //     mat4 mvp;
@@ -411,30 +1342,43 @@ void UpdateObjectMatrices(glm::mat4 projection) {
   else
     object_matrices.Clear();
 
-  auto modelview = view * object_model;
-  auto normalmatrix = glm::transpose(glm::inverse(modelview));
-  auto mvp = projection * modelview;
-  object_matrices.Add(mvp);
-  object_matrices.Add(modelview);
-  object_matrices.Add(normalmatrix);
+  for (auto& model : models) {
+    auto modelview = view * object_model * model;
+    auto normalmatrix = glm::transpose(glm::inverse(modelview));
+    auto mvp = projection * modelview;
+    object_matrices.Add(mvp);
+    object_matrices.Add(modelview);
+    object_matrices.Add(normalmatrix);
+  }
 
   object_matrices.SendToDevice();
 }
 
+// Updates the matrices of the object instances
+void UpdateObjectMatrices(glm::mat4 projection) {
+  UpdateObjectMatrices(projection, instance_models);
+}
+
 // Updates the view matrix
 void UpdateViewMatrix() {
   view = glm::lookAt(eye, center, up) * manipulator.GetMatrix();
 }
 
 // Updates the ortho projection matrix used in the voxelization
+// The fitted volume is fixed in object space, the sphere is view aligned
 void UpdateOrthoMatrix() {
+  auto modelview = view * object_model;
+  if (fit_mode == FIT_ORIENTED_BOX) {
+    ortho_projection = volume_projection * glm::inverse(modelview);
+    return;
+  }
   auto MultMatrix = [](glm::mat4 mat, glm::vec3 vec) -> glm::vec3 {
     auto v = mat * glm::vec4(vec, 1);
     return glm::vec3(v) / v.w;
   };
-  auto c = MultMatrix(view, scene_center);
+  auto c = MultMatrix(modelview, scene_center);
   auto radius =
-      MultMatrix(view, glm::vec3(scene_radius, 0, 0) + scene_center) - c;
+      MultMatrix(modelview, glm::vec3(scene_radius, 0, 0) + scene_center) - c;
   auto r = glm::length(radius);
   ortho_projection = glm::ortho(c.x - r, c.x + r,
                                 c.y - r, c.y + r,
@@ -456,106 +1400,1231 @@ void LoadGlobalConfiguration() {
   glEnable(GL_MULTISAMPLE);
 }
 
-// Renders the slice map (voxelization step)
-void RenderSliceMap() {
-  glPushAttrib(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT);
-  voxel_framebuffer.Bind();
-  glViewport(0, 0, volume_resolution, volume_resolution);
+// Renders the buffers [first, first + count) of a slice map with the surface
+// voxelization: the triangles set their voxels in the surface words, which
+// are then packed into the slice map buffers
+void RenderSurfaceSliceMap(FrameBuffer& framebuffer, int first, int count,
+                           int n_drawn) {
+  int resolution = framebuffer.GetWidth();
+  int first_word = first * 4;
+  int end_word = (first + count) * 4;
+  const GLuint zero = 0;
+  glClearTexSubImage(surface_words.GetId(), 0, 0, 0, first_word, resolution,
+                     resolution, end_word - first_word, GL_RED_INTEGER,
+                     GL_UNSIGNED_INT, &zero);
+  glPushAttrib(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT |
+               GL_ENABLE_BIT);
+  framebuffer.Bind();
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glViewport(0, 0, resolution, resolution);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  surface_voxelization_shader.Enable();
+  surface_voxelization_shader.SetUniformBuffer("MatricesBlock", 0,
+                                               object_matrices.GetId());
+  surface_voxelization_shader.SetUniform("volume_resolution", resolution);
+  surface_voxelization_shader.SetUniform("first_word", first_word);
+  surface_voxelization_shader.SetUniform("end_word", end_word);
+  surface_voxelization_shader.SetImage("surface_words", 0,
+                                       surface_words.GetId(), GL_READ_WRITE,
+                                       GL_R32UI, true);
+  DrawObjectInstances(n_drawn);
+  surface_voxelization_shader.Disable();
+  framebuffer.Unbind();
+  glPopAttrib();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  auto& texts = framebuffer.GetTextures();
+  surface_pack_shader.Enable();
+  surface_pack_shader.SetTexture3D("surface_words", 0, surface_words.GetId());
+  surface_pack_shader.SetUniform("resolution", resolution);
+  for (int i = first; i < first + count; ++i) {
+    surface_pack_shader.SetUniform("buffer_index", i);
+    surface_pack_shader.SetImage("slice_map", 0, texts[i], GL_WRITE_ONLY,
+                                 GL_RGBA32UI);
+    surface_pack_shader.Dispatch((resolution + 7) / 8, (resolution + 7) / 8);
+  }
+  surface_pack_shader.Disable();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT |
+                  GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                  GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+}
+
+// Renders the buffers [first, first + count) of a slice map (voxelization
+// step) with the first n_drawn instances; the other buffers are kept
+void RenderSliceMap(FrameBuffer& framebuffer, int first, int count,
+                    int n_drawn) {
+  if (voxelization_mode == VOXELIZATION_SURFACE) {
+    RenderSurfaceSliceMap(framebuffer, first, count, n_drawn);
+    return;
+  }
+  glPushAttrib(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT |
+               GL_ENABLE_BIT);
+  framebuffer.Bind();
+  int n_buffers = framebuffer.GetTextures().size();
+  std::vector<GLenum> draw_buffers(n_buffers, GL_NONE);
+  const GLuint zero[4] = {0, 0, 0, 0};
+  for (int i = first; i < first + count; ++i) {
+    draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    glClearBufferuiv(GL_COLOR, i, zero);
+  }
+  glDrawBuffers(n_buffers, draw_buffers.data());
+  glViewport(0, 0, framebuffer.GetWidth(), framebuffer.GetHeight());
   glDisable(GL_DEPTH_TEST);
+  // Surfaces behind the volume still flip the parity of the whole column
+  glEnable(GL_DEPTH_CLAMP);
   glEnable(GL_COLOR_LOGIC_OP);
   glLogicOp(GL_XOR);
-  glClear(GL_COLOR_BUFFER_BIT);
   voxelization_shader.Enable();
   voxelization_shader.SetTexture1D("voxel_depth_lut", 0,
                                    voxel_depth_lut.GetId());
   voxelization_shader.SetUniformBuffer("MatricesBlock", 0,
                                        object_matrices.GetId());
-  voxelization_shader.SetUniform("n_volume_buffers", n_volume_buffers);
-  for (auto& mesh : object_meshes) {
-    mesh.DrawElements(GL_TRIANGLES);
-  }
+  voxelization_shader.SetUniform("n_volume_buffers", n_buffers);
+  voxelization_shader.SetUniform("first_buffer", first);
+  DrawObjectInstances(n_drawn);
   voxelization_shader.Disable();
-  voxel_framebuffer.Unbind();
+  framebuffer.Unbind();
   glPopAttrib();
 }
 
-// Renders a slice of the slice map for debugging
-void RenderSliceForDebug() {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  slice_shader.Enable();
+// Renders the slice map (voxelization step)
+void RenderSliceMap() {
+  RenderSliceMap(voxel_framebuffer, 0, n_volume_buffers, n_instances);
+}
+
+// Builds the distance field with jump flooding on the gpu
+void BuildDistanceFieldGPU() {
+  const int N = distance_field_resolution;
+  const int cell_size = volume_resolution / N;
+
+  distance_seed_shader.Enable();
   auto &texts = voxel_framebuffer.GetTextures();
   for (int i = 0; i < n_volume_buffers; ++i) {
     auto name = "slice_map[" + std::to_string(i) + "]";
-    slice_shader.SetTexture2D(name, i, texts[i]);
+    distance_seed_shader.SetTexture2D(name, i, texts[i]);
   }
-  slice_shader.SetUniform("n_volume_buffers", n_volume_buffers);
-  screen_quad.DrawElements(GL_QUADS);
-  slice_shader.Disable();
-}
-
-// Renders the geometry pass
-void RenderGeometry() {
-  geom_framebuffer.Bind();
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  geompass_shader.Enable();
-  UpdateLightsBuffer();
+  distance_seed_shader.SetUniform("cell_size", cell_size);
+  distance_seed_shader.SetImage("seeds", 0, distance_seeds[0].GetId(),
+                                GL_WRITE_ONLY, GL_R32UI, true);
+  distance_seed_shader.Dispatch(N / 8, N / 8, N);
+  distance_seed_shader.Disable();
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
-  geompass_shader.SetUniform("material_id", OBJECT_MATERIAL);
-  geompass_shader.SetUniformBuffer("MatricesBlock", 0, object_matrices.GetId());
-  for (auto& mesh : object_meshes) {
-    mesh.DrawElements(GL_TRIANGLES);
+  int src = 0;
+  distance_jfa_shader.Enable();
+  for (int jump = N / 2; jump >= 1; jump /= 2) {
+    distance_jfa_shader.SetUniform("jump", jump);
+    distance_jfa_shader.SetImage("src_seeds", 0, distance_seeds[src].GetId(),
+                                 GL_READ_ONLY, GL_R32UI, true);
+    distance_jfa_shader.SetImage("dst_seeds", 1,
+                                 distance_seeds[1 - src].GetId(),
+                                 GL_WRITE_ONLY, GL_R32UI, true);
+    distance_jfa_shader.Dispatch(N / 4, N / 4, N / 4);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    src = 1 - src;
   }
+  distance_jfa_shader.Disable();
 
-  geompass_shader.Disable();
-  geom_framebuffer.Unbind();
+  distance_final_shader.Enable();
+  distance_final_shader.SetImage("seeds", 0, distance_seeds[src].GetId(),
+                                 GL_READ_ONLY, GL_R32UI, true);
+  distance_final_shader.SetImage("distance_field", 1, distance_field.GetId(),
+                                 GL_WRITE_ONLY, GL_R16F, true);
+  distance_final_shader.Dispatch(N / 4, N / 4, N / 4);
+  distance_final_shader.Disable();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 }
 
-// Renders the lighting pass
-void RenderLighting() {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  lightpass_shader.Enable();
+// Builds the distance field with the exact euclidean distance transform
+// on the cpu, reading the slice map back
+void BuildDistanceFieldCPU() {
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+  cpu_distance_field.Compute(cpu_volume);
+  distance_field.UpdateTexture(cpu_distance_field.GetData(), GL_RED, GL_FLOAT);
+}
 
-  auto &texts = geom_framebuffer.GetTextures();
-  lightpass_shader.SetTexture2D("position_sampler", 0, texts[0]);
-  lightpass_shader.SetTexture2D("normal_sampler", 1, texts[1]);
-  lightpass_shader.SetTexture2D("material_sampler", 2, texts[2]);
+// Builds the distance field using the selected mode
+void BuildDistanceField() {
+  distance_field_timer.Begin();
+  if (distance_field_mode == DISTANCE_FIELD_GPU)
+    BuildDistanceFieldGPU();
+  else if (distance_field_mode == DISTANCE_FIELD_CPU)
+    BuildDistanceFieldCPU();
+  distance_field_timer.End();
+  distance_field_outdated = false;
+}
 
-  lightpass_shader.SetUniformBuffer("MaterialsBlock", 0, materials.GetId());
-  lightpass_shader.SetUniformBuffer("LightsBlock", 1, lights.GetId());
-  lightpass_shader.SetUniformBuffer("RaysBlock", 2, rays.GetId());
+// Obtains the size of the voxels of a clipmap cascade
+float GetClipmapVoxelSize(int level) {
+  return scene_radius / clipmap_resolution * (1 << level);
+}
 
-  auto &slice_map_texts  = voxel_framebuffer.GetTextures();
-  for (int i = 0; i < 8; ++i) {
-    auto name = "slice_map[" + std::to_string(i) + "]";
-    lightpass_shader.SetTexture2D(name, 3 + i, slice_map_texts[i]);
+// Voxelizes the columns [x0, x1) x [y0, y1) of a clipmap cascade, given in
+// grid coordinates; only the voxels [slab_begin, slab_end) of the cascade
+// depth are toggled. The region is split where it wraps around the toroidal
+// storage, so each piece is rendered with its own viewport
+void VoxelizeClipmapRegion(int level, int x0, int y0, int x1, int y1,
+                           int slab_begin, int slab_end) {
+  const int R = clipmap_resolution;
+  auto Wrap = [R](int v) { return (v % R + R) % R; };
+  auto size = GetClipmapVoxelSize(level);
+  auto origin = clipmap_origins[level];
+  auto world_from_view = glm::inverse(view);
+  clipmap_voxelization_shader.SetUniform("slab_begin", slab_begin);
+  clipmap_voxelization_shader.SetUniform("slab_end", slab_end);
+  for (int x = x0; x < x1;) {
+    int storage_x = Wrap(x);
+    int w = std::min(x1 - x, R - storage_x);
+    for (int y = y0; y < y1;) {
+      int storage_y = Wrap(y);
+      int h = std::min(y1 - y, R - storage_y);
+      // The grid depth axis points to -z, like the ortho projection
+      auto projection = glm::ortho(x * size, (x + w) * size, y * size,
+                                   (y + h) * size, origin.z * size,
+                                   (origin.z + R) * size);
+      UpdateObjectMatrices(projection * world_from_view);
+      clipmap_voxelization_shader.SetUniformBuffer("MatricesBlock", 0,
+                                                   object_matrices.GetId());
+      int viewport_y = level * R + storage_y;
+      glViewport(storage_x, viewport_y, w, h);
+      glScissor(storage_x, viewport_y, w, h);
+      if (slab_begin == 0 && slab_end == R)
+        glClear(GL_COLOR_BUFFER_BIT);
+      DrawObjectInstances(n_instances);
+      clipmap_updated_voxels += (long long)w * h * (slab_end - slab_begin);
+      y += h;
+    }
+    x += w;
   }
+}
 
-  auto slice_map_matrix = mapping_matrix * ortho_projection;
-  lightpass_shader.SetUniform("slice_map_matrix", slice_map_matrix);
-  lightpass_shader.SetUniform("slice_map_matrix_it",
-      glm::transpose(glm::inverse(slice_map_matrix)));
-  lightpass_shader.SetUniform("mode", mode);
-  lightpass_shader.SetUniform("n_rays", n_rays);
-  lightpass_shader.SetUniform("max_distance", max_distance);
-  lightpass_shader.SetUniform("step_size", step_size);
-  lightpass_shader.SetUniform("n_volume_buffers", n_volume_buffers);
-
+// Clears the voxels [slab_begin, slab_end) of the depth of every column of
+// a clipmap cascade
+void ClearClipmapSlab(int level, int slab_begin, int slab_end) {
+  const int R = clipmap_resolution;
+  glLogicOp(GL_AND);
+  glViewport(0, level * R, R, R);
+  glScissor(0, level * R, R, R);
+  clipmap_mask_shader.Enable();
+  clipmap_mask_shader.SetUniform("z_origin",
+                                 (clipmap_origins[level].z % R + R) % R);
+  clipmap_mask_shader.SetUniform("slab_begin", slab_begin);
+  clipmap_mask_shader.SetUniform("slab_end", slab_end);
   screen_quad.DrawElements(GL_QUADS);
+  clipmap_mask_shader.Disable();
+  glLogicOp(GL_XOR);
+}
 
-  lightpass_shader.Disable();
+// Moves a clipmap cascade to a new origin; only the columns and the depth
+// slab that entered the cascade are voxelized, unless it moved further than
+// its size (or full is set)
+void UpdateClipmapLevel(int level, glm::ivec3 origin, bool full) {
+  const int R = clipmap_resolution;
+  auto old = clipmap_origins[level];
+  auto delta = origin - old;
+  clipmap_origins[level] = origin;
+  if (delta == glm::ivec3(0) && !full)
+    return;
+  full = full || std::abs(delta.x) >= R || std::abs(delta.y) >= R ||
+         std::abs(delta.z) >= R;
+
+  clipmap_voxelization_shader.Enable();
+  clipmap_voxelization_shader.SetUniform("z_origin", (origin.z % R + R) % R);
+  int x1 = origin.x + R;
+  int y1 = origin.y + R;
+  if (full) {
+    VoxelizeClipmapRegion(level, origin.x, origin.y, x1, y1, 0, R);
+    clipmap_voxelization_shader.Disable();
+    return;
+  }
+
+  // Depth slab that entered the cascade, in every column; it is cleared
+  // before the toggling
+  if (delta.z != 0) {
+    int slab_begin = delta.z > 0 ? R - delta.z : 0;
+    int slab_end = delta.z > 0 ? R : -delta.z;
+    ClearClipmapSlab(level, slab_begin, slab_end);
+    clipmap_voxelization_shader.Enable();
+    VoxelizeClipmapRegion(level, origin.x, origin.y, x1, y1, slab_begin,
+                          slab_end);
+  }
+
+  // Columns that entered the cascade, cleared and voxelized in the whole
+  // depth
+  if (delta.x > 0)
+    VoxelizeClipmapRegion(level, old.x + R, origin.y, x1, y1, 0, R);
+  else if (delta.x < 0)
+    VoxelizeClipmapRegion(level, origin.x, origin.y, old.x, y1, 0, R);
+  if (delta.y > 0)
+    VoxelizeClipmapRegion(level, origin.x, old.y + R, x1, y1, 0, R);
+  else if (delta.y < 0)
+    VoxelizeClipmapRegion(level, origin.x, origin.y, x1, old.y, 0, R);
+  clipmap_voxelization_shader.Disable();
 }
 
-// Renders the scene
-void Render() {
-  UpdateObjectMatrices(ortho_projection);
-  RenderSliceMap();
-  UpdateObjectMatrices(perspective_projection);
-  if (debug_slice_map) {
-    RenderSliceForDebug();
-  } else {
-    RenderGeometry();
-    RenderLighting();
+// Moves the clipmap cascades with the camera; they are voxelized again from
+// scratch if the object moved
+void UpdateClipmap() {
+  clipmap_timer.Begin();
+  glPushAttrib(GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_ENABLE_BIT |
+               GL_SCISSOR_BIT);
+  clipmap_framebuffer.Bind();
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_DEPTH_CLAMP);
+  glEnable(GL_SCISSOR_TEST);
+  glEnable(GL_COLOR_LOGIC_OP);
+  glLogicOp(GL_XOR);
+
+  bool full = object_model != clipmap_object_model;
+  clipmap_object_model = object_model;
+  clipmap_updated_voxels = 0;
+  // Grid coordinates have the depth axis pointing to -z
+  auto camera = glm::vec3(glm::inverse(view)[3]) * glm::vec3(1, 1, -1);
+  for (int level = 0; level < clipmap_levels; ++level) {
+    auto cell = glm::floor(camera / GetClipmapVoxelSize(level));
+    auto origin = glm::ivec3(cell) - clipmap_resolution / 2;
+    UpdateClipmapLevel(level, origin, full);
   }
+
+  clipmap_framebuffer.Unbind();
+  glPopAttrib();
+  clipmap_timer.End();
+}
+
+// Prints the memory used by the bricked slice map; the dense slice map stays
+// allocated, since it's the target of the voxelization the bricks are built
+// from, so the resident footprint is the sum of both
+void PrintBricksMemory() {
+  auto MB = [](double bytes) { return bytes / (1024 * 1024); };
+  double dense = (double)volume_resolution * volume_resolution *
+                 volume_resolution / 8;
+  double table = bricks.GetTable().size() * sizeof(uint32_t);
+  double pool = (double)brick_pool.GetWidth() * brick_pool.GetHeight() *
+                4 * sizeof(uint32_t);
+  printf("\nbricks: %zu empty, %zu full, %zu mixed\n",
+         bricks.GetNumberOfEmptyBricks(), bricks.GetNumberOfFullBricks(),
+         bricks.GetNumberOfMixedBricks());
+  printf("dense %.1f MB, page table %.1f MB + pool %.1f MB = %.1f MB "
+         "(%.1fx the dense size)\n", MB(dense), MB(table), MB(pool),
+         MB(table + pool), (table + pool) / dense);
+  printf("resident: dense + bricked = %.1f MB\n",
+         MB(dense + table + pool));
+}
+
+// Builds the bricked slice map from a copy of the slice map
+void BuildBricks() {
+  const int POOL_WIDTH = 1024;
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+  bricks.Build(cpu_volume);
+  brick_table.LoadTexture(bricks.GetTable().data(),
+                          bricks.GetTableResolution(), GL_R32UI,
+                          GL_RED_INTEGER, GL_UNSIGNED_INT);
+
+  // The pool is a texture with POOL_WIDTH bricks per row, 4 texels each
+  auto pool = bricks.GetPool();
+  size_t brick_texels = BrickVolume::BRICK_WORDS / 4;
+  size_t row_words = POOL_WIDTH * BrickVolume::BRICK_WORDS;
+  int height = std::max((pool.size() + row_words - 1) / row_words,
+                        (size_t)1);
+  pool.resize(height * row_words, 0);
+  brick_pool.LoadTexture(pool.data(), POOL_WIDTH * brick_texels, height,
+                         GL_RGBA32UI, GL_RGBA_INTEGER, GL_UNSIGNED_INT);
+  bricks_outdated = false;
+}
+
+// Extracts the proxy mesh of cpu_volume, voxelized with the matrix mvp (from
+// the object space); returns the extraction time in milliseconds
+double ExtractProxyMesh(const glm::mat4& mvp) {
+  double start = glfwGetTime();
+  proxy_mesh.Build(cpu_volume);
+  double extraction_time = (glfwGetTime() - start) * 1000;
+  auto voxel_from_object = glm::scale(glm::vec3(volume_resolution)) *
+                           mapping_matrix * mvp;
+  proxy_mesh.Transform(glm::inverse(voxel_from_object));
+  return extraction_time;
+}
+
+// Prints the size of the proxy mesh against the scene
+void PrintProxyMeshReport(double extraction_time = -1) {
+  printf("\nproxy mesh: %zu quads, %zu triangles",
+         proxy_mesh.GetNumberOfQuads(), proxy_mesh.GetNumberOfTriangles());
+  // The volumetric scenes have no triangles
+  if (n_scene_triangles > 0) {
+    printf(" (scene: %zu triangles, %.2fx)", n_scene_triangles,
+           (double)proxy_mesh.GetNumberOfTriangles() / n_scene_triangles);
+  }
+  printf("\n");
+  if (extraction_time >= 0) {
+    printf("extracted in %.2f ms (%d threads)\n", extraction_time,
+           GetNumberOfThreads());
+  }
+}
+
+// Extracts the proxy mesh from a copy of the slice map and uploads it
+void BuildProxyMesh() {
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+  ExtractProxyMesh(slice_map_mvp);
+  auto& indices = proxy_mesh.GetIndices();
+  auto& positions = proxy_mesh.GetPositions();
+  auto& normals = proxy_mesh.GetNormals();
+  proxy_vao.Init();
+  proxy_vao.SetElementArray(indices.data(), indices.size());
+  proxy_vao.AddArray(0, positions.data(), positions.size(), 3);
+  proxy_vao.AddArray(1, normals.data(), normals.size(), 3);
+  proxy_mesh_outdated = false;
+}
+
+// Casts the view ray (from the eye to the centre of the screen) in the copy
+// of the slice map and prints where it hits
+void ProbeQueryVolume() {
+  auto voxel_from_view = glm::scale(glm::vec3(volume_resolution)) *
+                         mapping_matrix * query_volume_mvp *
+                         glm::inverse(view * object_model);
+  auto origin = glm::vec3(voxel_from_view * glm::vec4(0, 0, 0, 1));
+  auto dir = glm::vec3(voxel_from_view * glm::vec4(0, 0, -1, 0));
+  // The distance is in view units, since dir is the unit view direction
+  VoxelHit hit;
+  query_volume.Raycast(origin, dir, FAR, &hit);
+  if (hit.hit) {
+    printf("view ray hits the voxel (%d, %d, %d) at %.3f\n", hit.voxel.x,
+           hit.voxel.y, hit.voxel.z, hit.distance);
+  } else {
+    printf("view ray misses\n");
+  }
+}
+
+// Keeps the cpu copy of the slice map up to date: the readback is started
+// when the slice map changes and the copy is replaced when the gpu finished
+// it, so the queries use a copy a few frames old instead of stalling
+void UpdateQueryVolume() {
+  if (use_cpu_voxelizer && !volume_scene) {
+    if (!query_volume_outdated)
+      return;
+    if (query_volume.GetResolution() != volume_resolution)
+      query_volume.Init(volume_resolution);
+    double start = glfwGetTime();
+    cpu_voxelizer.Voxelize(slice_map_mvp, instance_models, &query_volume);
+    query_volume_mvp = slice_map_mvp;
+    query_volume_outdated = false;
+    printf("\noccupancy queries: voxelized on the cpu in %.2f ms, ",
+           (glfwGetTime() - start) * 1000);
+    ProbeQueryVolume();
+    return;
+  }
+  if (query_volume_outdated && !query_readback.IsPending()) {
+    query_readback.Start(voxel_framebuffer.GetTextures(), volume_resolution);
+    pending_query_mvp = slice_map_mvp;
+    query_readback_frame = volume_frame;
+    query_volume_outdated = false;
+  }
+  if (query_readback.Finish(&query_volume)) {
+    query_volume_mvp = pending_query_mvp;
+    printf("\noccupancy queries: copy ready after %d frames, ",
+           volume_frame - query_readback_frame);
+    ProbeQueryVolume();
+  }
+}
+
+// Builds the density mip chain used by the cone tracing; the first level
+// counts the active voxels of each 2x2x2 block and the others average it
+void BuildDensity() {
+  density_timer.Begin();
+  density_shader.Enable();
+  auto &texts = voxel_framebuffer.GetTextures();
+  for (int i = 0; i < n_volume_buffers; ++i) {
+    auto name = "slice_map[" + std::to_string(i) + "]";
+    density_shader.SetTexture2D(name, i, texts[i]);
+  }
+  density_shader.SetImage("density", 0, density.GetId(), GL_WRITE_ONLY,
+                          GL_R8, true);
+  density_shader.Dispatch(density_resolution / 8, density_resolution / 8,
+                          density_resolution);
+  density_shader.Disable();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+  density.GenerateMipmap();
+  density_timer.End();
+  density_outdated = false;
+}
+
+// Obtains how much the voxelized object moved between two voxelization
+// matrices, as the largest displacement of the volume corners in voxels
+float GetVolumeMotion(const glm::mat4& from, const glm::mat4& to) {
+  auto transform = to * glm::inverse(from);
+  float motion = 0;
+  for (int i = 0; i < 8; ++i) {
+    glm::vec4 corner((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1, 1);
+    auto moved = glm::vec3(transform * corner);
+    motion = std::max(motion, glm::length(moved - glm::vec3(corner)));
+  }
+  return motion * volume_resolution / 2;
+}
+
+// Renders the next buffers of the back slice map, starting a new update with
+// the current matrix if none is in progress, and swaps the slice maps when
+// it is complete; returns true if they were swapped
+bool RenderNextSliceMapBuffers(const glm::mat4& mvp) {
+  if (voxel_back_framebuffer.GetTextures().empty())
+    CreateSliceMapFramebuffer(voxel_back_framebuffer);
+  if (back_next_buffer == 0) {
+    back_slice_map_mvp = mvp;
+    back_slice_map_frame = volume_frame;
+  }
+  // Every buffer uses the matrix of the first frame of the update
+  UpdateObjectMatrices(back_slice_map_mvp *
+                       glm::inverse(view * object_model));
+  int count = n_volume_buffers / amortization_frames;
+  RenderSliceMap(voxel_back_framebuffer, back_next_buffer, count,
+                 n_instances);
+  back_next_buffer += count;
+  if (back_next_buffer < n_volume_buffers)
+    return false;
+  voxel_framebuffer.Swap(voxel_back_framebuffer);
+  slice_map_mvp = back_slice_map_mvp;
+  slice_map_frame = back_slice_map_frame;
+  back_next_buffer = 0;
+  return true;
+}
+
+// Voxelizes the object with the given matrix, all at once or amortized (the
+// amortized updates can't follow the instances that moved); returns true if
+// the slice map changed
+bool UpdateSliceMap(const glm::mat4& mvp, bool instances_moved) {
+  bool valid = slice_map_mvp != glm::mat4(0);
+  if (amortized_voxelization && valid && !instances_moved &&
+      volume_frame - slice_map_frame <= max_staleness &&
+      GetVolumeMotion(slice_map_mvp, mvp) <= max_motion)
+    return RenderNextSliceMapBuffers(mvp);
+  RenderSliceMap();
+  slice_map_mvp = mvp;
+  slice_map_frame = volume_frame;
+  back_next_buffer = 0;
+  n_full_voxelizations++;
+  return true;
+}
+
+// Voxelizes the object in its own space, in the cube around its bounding
+// sphere
+void VoxelizeObjectVolume() {
+  const int R = object_volume_resolution;
+  if (object_volume_framebuffer.GetTextures().empty()) {
+    object_volume_framebuffer.Init(R, R);
+    for (int i = 0; i < R / 128; ++i) {
+      object_volume_framebuffer.AddColorTexture(GL_RGBA32UI, GL_RGBA_INTEGER,
+                                                GL_UNSIGNED_INT);
+    }
+    try {
+      object_volume_framebuffer.Verify();
+    } catch (std::exception &e) {
+      Assertf(false, "%s", e.what());
+    }
+  }
+  auto c = object_bounds.GetSphere().center;
+  auto r = object_bounds.GetSphere().radius;
+  object_volume_projection = glm::ortho(c.x - r, c.x + r, c.y - r, c.y + r,
+                                        -c.z - r, -c.z + r);
+  UpdateObjectMatrices(object_volume_projection *
+                       glm::inverse(view * object_model),
+                       std::vector<glm::mat4>(1, glm::mat4(1)));
+  RenderSliceMap(object_volume_framebuffer, 0, R / 128, 1);
+  object_volume_outdated = false;
+}
+
+// Composites the static layer and the dynamic instances into the slice map.
+// The static layer is voxelized again if the volume changed, and the whole
+// slice map is copied from it if it was replaced; then only the regions
+// covered by the dynamic instances (before and after moving) are composited.
+// Returns true if the slice map changed
+bool CompositeSliceMap(bool instances_moved) {
+  const int R = volume_resolution;
+  const int n_static = n_instances - n_dynamic_instances;
+  if (object_volume_outdated)
+    VoxelizeObjectVolume();
+  bool full = slice_map_mvp != volume_projection;
+  if (static_layer_mvp != volume_projection) {
+    if (static_layer_framebuffer.GetTextures().empty())
+      CreateSliceMapFramebuffer(static_layer_framebuffer);
+    UpdateObjectMatrices(volume_projection *
+                         glm::inverse(view * object_model));
+    RenderSliceMap(static_layer_framebuffer, 0, n_volume_buffers, n_static);
+    static_layer_mvp = volume_projection;
+    full = true;
+  }
+  if (!full && !instances_moved)
+    return false;
+
+  // Object volume voxels of the slice map voxels, and the slice map region
+  // covered by each dynamic instance
+  auto object_volume_from_object =
+      glm::scale(glm::vec3(object_volume_resolution)) * mapping_matrix *
+      object_volume_projection;
+  auto scene_from_object = glm::scale(glm::vec3(R)) * mapping_matrix *
+                           volume_projection;
+  std::vector<glm::mat4> object_from_scene;
+  std::vector<VoxelRegion> instance_regions;
+  for (int i = n_static; i < n_instances; ++i) {
+    auto matrix = object_volume_from_object *
+                  glm::inverse(instance_models[i]) *
+                  glm::inverse(scene_from_object);
+    object_from_scene.push_back(matrix);
+    auto scene_from_instance = glm::inverse(matrix);
+    VoxelRegion region = {glm::ivec3(R), glm::ivec3(0)};
+    for (int j = 0; j < 8; ++j) {
+      auto corner = glm::vec4((j & 1) ? object_volume_resolution : 0,
+                              (j & 2) ? object_volume_resolution : 0,
+                              (j & 4) ? object_volume_resolution : 0, 1);
+      auto p = glm::vec3(scene_from_instance * corner);
+      region.begin = glm::min(region.begin, glm::ivec3(glm::floor(p)));
+      region.end = glm::max(region.end, glm::ivec3(glm::ceil(p)));
+    }
+    region.begin = glm::clamp(region.begin, 0, R);
+    region.end = glm::clamp(region.end, 0, R);
+    instance_regions.push_back(region);
+  }
+
+  auto &static_texts = static_layer_framebuffer.GetTextures();
+  auto &slice_map_texts = voxel_framebuffer.GetTextures();
+  std::vector<VoxelRegion> regions = instance_regions;
+  if (full) {
+    for (int i = 0; i < n_volume_buffers; ++i) {
+      glCopyImageSubData(static_texts[i], GL_TEXTURE_2D, 0, 0, 0, 0,
+                         slice_map_texts[i], GL_TEXTURE_2D, 0, 0, 0, 0, R, R,
+                         1);
+    }
+  } else {
+    for (size_t i = 0; i < regions.size(); ++i) {
+      if (i >= dynamic_instance_regions.size()) continue;
+      auto& previous = dynamic_instance_regions[i];
+      regions[i].begin = glm::min(regions[i].begin, previous.begin);
+      regions[i].end = glm::max(regions[i].end, previous.end);
+    }
+  }
+  dynamic_instance_regions = instance_regions;
+
+  composite_shader.Enable();
+  auto &object_texts = object_volume_framebuffer.GetTextures();
+  for (size_t i = 0; i < object_texts.size(); ++i) {
+    auto name = "object_volume[" + std::to_string(i) + "]";
+    composite_shader.SetTexture2D(name, 1 + i, object_texts[i]);
+  }
+  composite_shader.SetUniform("object_volume_resolution",
+                              object_volume_resolution);
+  composite_shader.SetUniform("n_movers", (int)object_from_scene.size());
+  for (size_t i = 0; i < object_from_scene.size(); ++i) {
+    auto name = "object_from_scene[" + std::to_string(i) + "]";
+    composite_shader.SetUniform(name, object_from_scene[i]);
+  }
+  composited_voxels = 0;
+  for (auto& region : regions) {
+    auto size = region.end - region.begin;
+    if (size.x <= 0 || size.y <= 0 || size.z <= 0)
+      continue;
+    composite_shader.SetUniform("region_x0", region.begin.x);
+    composite_shader.SetUniform("region_y0", region.begin.y);
+    composite_shader.SetUniform("region_x1", region.end.x);
+    composite_shader.SetUniform("region_y1", region.end.y);
+    // Each buffer holds 128 voxels of depth
+    for (int i = region.begin.z / 128; i <= (region.end.z - 1) / 128; ++i) {
+      composite_shader.SetUniform("buffer_index", i);
+      composite_shader.SetTexture2D("static_layer", 0, static_texts[i]);
+      composite_shader.SetImage("slice_map", 0, slice_map_texts[i],
+                                GL_WRITE_ONLY, GL_RGBA32UI);
+      composite_shader.Dispatch((size.x + 7) / 8, (size.y + 7) / 8);
+      composited_voxels += (long long)size.x * size.y * 128;
+    }
+  }
+  composite_shader.Disable();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT |
+                  GL_FRAMEBUFFER_BARRIER_BIT |
+                  GL_TEXTURE_UPDATE_BARRIER_BIT);
+  slice_map_mvp = volume_projection;
+  slice_map_frame = volume_frame;
+  back_next_buffer = 0;
+  return true;
+}
+
+// Updates the slice map and the structures built from it; nothing is
+// recomputed if the voxelized scene didn't move since the last update
+void UpdateVolume() {
+  volume_frame++;
+  if (use_clipmap && ao_method == AO_RAY_MARCHING) {
+    UpdateClipmap();
+    return;
+  }
+  // The fitted volume is fixed in object space, so it doesn't depend on the
+  // view and on the object movement; the volumetric scenes only have it
+  auto mvp = ortho_projection * view * object_model;
+  if (fit_mode == FIT_ORIENTED_BOX || volume_scene)
+    mvp = volume_projection;
+  bool moved = instances_moved;
+  instances_moved = false;
+  // The object volumes need the fitted volume, fixed in object space
+  bool composite = use_object_volumes && fit_mode == FIT_ORIENTED_BOX &&
+                   !volume_scene;
+  // The slice map isn't stale while the object doesn't move
+  if (mvp == slice_map_mvp && !moved)
+    slice_map_frame = volume_frame;
+  if (mvp != slice_map_mvp || back_next_buffer > 0 || moved ||
+      (composite && static_layer_mvp != volume_projection)) {
+    voxelization_timer.Begin();
+    bool changed = composite ? CompositeSliceMap(moved) :
+                               UpdateSliceMap(mvp, moved);
+    voxelization_timer.End();
+    if (changed) {
+      distance_field_outdated = true;
+      density_outdated = true;
+      bricks_outdated = true;
+      proxy_mesh_outdated = true;
+      query_volume_outdated = true;
+      occlusion_cache_outdated = true;
+    }
+  }
+  if (distance_field_outdated && distance_field_mode != DISTANCE_FIELD_OFF)
+    BuildDistanceField();
+  if (density_outdated &&
+      (ao_method == AO_CONE_TRACING || use_occlusion_cache))
+    BuildDensity();
+  if (bricks_outdated && use_bricks) {
+    BuildBricks();
+    PrintBricksMemory();
+  }
+  if (proxy_mesh_outdated && use_proxy_mesh) {
+    BuildProxyMesh();
+    PrintProxyMeshReport();
+  }
+  if (occupancy_queries)
+    UpdateQueryVolume();
+}
+
+// Builds the sparse voxel octree of the object; the object is voxelized in
+// tiles with the slice map resolution and each tile is read back
+void BuildSparseVoxelOctree() {
+  double start = glfwGetTime();
+  int n_tiles = svo_resolution / volume_resolution;
+  svo.Init(svo_resolution, volume_resolution);
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+
+  // Cube around the scene in object space
+  auto c = scene_center;
+  auto r = scene_radius;
+  auto tile_size = 2 * r / n_tiles;
+  svo_projection = glm::ortho(c.x - r, c.x + r, c.y - r, c.y + r,
+                              -c.z - r, -c.z + r);
+  auto object_from_view = glm::inverse(view * object_model);
+
+  unsigned int query;
+  glGenQueries(1, &query);
+  for (int z = 0; z < n_tiles; ++z) {
+    for (int y = 0; y < n_tiles; ++y) {
+      for (int x = 0; x < n_tiles; ++x) {
+        auto left = c.x - r + x * tile_size;
+        auto bottom = c.y - r + y * tile_size;
+        auto front = -c.z - r + z * tile_size;
+        auto tile_projection = glm::ortho(left, left + tile_size, bottom,
+                                          bottom + tile_size, front,
+                                          front + tile_size);
+        UpdateObjectMatrices(tile_projection * object_from_view);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+        RenderSliceMap();
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        // Tiles without fragments are empty
+        unsigned int any_samples = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &any_samples);
+        if (!any_samples)
+          continue;
+        cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+        svo.AddTile(cpu_volume, x, y, z);
+      }
+    }
+  }
+  glDeleteQueries(1, &query);
+  svo.Finish();
+  svo_buffer.SetData(svo.GetNodes().data(), svo.GetSize());
+
+  // The tiles overwrote the slice map
+  UpdateObjectMatrices(ortho_projection);
+  slice_map_mvp = glm::mat4(0);
+
+  auto MB = [](double bytes) { return bytes / (1024 * 1024); };
+  double dense = (double)volume_resolution * volume_resolution *
+                 volume_resolution / 8;
+  double dense_svo = (double)svo_resolution * svo_resolution *
+                     svo_resolution / 8;
+  printf("\nsparse voxel octree %d^3: %zu nodes, %zu bricks, %.1f MB, "
+         "built in %.2fs\n", svo_resolution, svo.GetNumberOfNodes(),
+         svo.GetNumberOfBricks(), MB(svo.GetSize()), glfwGetTime() - start);
+  printf("dense slice map %d^3: %.1f MB (%d^3 would need %.1f MB)\n",
+         volume_resolution, MB(dense), svo_resolution, MB(dense_svo));
+}
+
+// Renders a slice of the slice map for debugging
+void RenderSliceForDebug() {
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  slice_shader.Enable();
+  auto &texts = voxel_framebuffer.GetTextures();
+  for (int i = 0; i < n_volume_buffers; ++i) {
+    auto name = "slice_map[" + std::to_string(i) + "]";
+    slice_shader.SetTexture2D(name, i, texts[i]);
+  }
+  slice_shader.SetUniform("n_volume_buffers", n_volume_buffers);
+  screen_quad.DrawElements(GL_QUADS);
+  slice_shader.Disable();
+}
+
+// Renders the geometry pass of the volumetric scene, casting the view rays
+// in the slice map
+void RenderVolumeGeometry() {
+  volume_geompass_shader.Enable();
+  auto volume_matrix = glm::scale(glm::vec3(volume_resolution)) *
+                       mapping_matrix * volume_projection *
+                       glm::inverse(view * object_model);
+  auto &texts = voxel_framebuffer.GetTextures();
+  for (int i = 0; i < n_volume_buffers; ++i) {
+    auto name = "slice_map[" + std::to_string(i) + "]";
+    volume_geompass_shader.SetTexture2D(name, i, texts[i]);
+  }
+  volume_geompass_shader.SetUniform("volume_resolution", volume_resolution);
+  volume_geompass_shader.SetUniform("volume_matrix", volume_matrix);
+  volume_geompass_shader.SetUniform("volume_matrix_it",
+      glm::transpose(glm::inverse(volume_matrix)));
+  volume_geompass_shader.SetUniform("projection", perspective_projection);
+  volume_geompass_shader.SetUniform("projection_inverse",
+                                    glm::inverse(perspective_projection));
+  volume_geompass_shader.SetUniform("material_id", OBJECT_MATERIAL);
+  screen_quad.DrawElements(GL_QUADS);
+  volume_geompass_shader.Disable();
+}
+
+// Indicates if the frame shows the baked occlusion; the proxy mesh has
+// neither the occlusion of the vertices nor texture coordinates, so the
+// occlusion pass traces it instead
+bool IsOcclusionBaked() {
+  return use_baked_occlusion && !use_proxy_mesh;
+}
+
+// Renders the geometry pass
+void RenderGeometry() {
+  geom_framebuffer.Bind();
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  if (volume_scene && !use_proxy_mesh) {
+    UpdateLightsBuffer();
+    RenderVolumeGeometry();
+    geom_framebuffer.Unbind();
+    return;
+  }
+  geompass_shader.Enable();
+  UpdateLightsBuffer();
+
+  geompass_shader.SetUniform("material_id", OBJECT_MATERIAL);
+  bool use_lightmap = lightmap_path && IsOcclusionBaked();
+  geompass_shader.SetUniform("use_lightmap", use_lightmap);
+  if (use_lightmap)
+    geompass_shader.SetTexture2D("lightmap", 0, lightmap.GetId());
+  if (use_proxy_mesh) {
+    // The proxy mesh covers all the instances in object space
+    UpdateObjectMatrices(perspective_projection,
+                         std::vector<glm::mat4>(1, glm::mat4(1)));
+  }
+  geompass_shader.SetUniformBuffer("MatricesBlock", 0, object_matrices.GetId());
+  if (use_proxy_mesh)
+    proxy_vao.DrawElements(GL_TRIANGLES);
+  else
+    DrawObjectInstances(n_instances);
+
+  geompass_shader.Disable();
+  geom_framebuffer.Unbind();
+}
+
+// Obtains the rays traced by each pixel of the ambient occlusion per frame
+int GetTracedRays() {
+  if (interleaved_occlusion)
+    return n_rays / (interleave_size * interleave_size);
+  if (refining_occlusion)
+    return n_rays;
+  return temporal_occlusion ? temporal_rays : n_rays;
+}
+
+// Sets the volumes and the parameters of the ambient occlusion (the
+// textures use the units from 3 on)
+void SetOcclusionUniforms(ShaderProgram& shader) {
+  shader.SetUniformBuffer("RaysBlock", 2, rays.GetId());
+
+  auto &slice_map_texts  = voxel_framebuffer.GetTextures();
+  for (int i = 0; i < 8; ++i) {
+    auto name = "slice_map[" + std::to_string(i) + "]";
+    shader.SetTexture2D(name, 3 + i, slice_map_texts[i]);
+  }
+
+  // The slice map may have been voxelized in a previous frame, so it is
+  // mapped with its own matrix. The octree has its own projection, in object
+  // space; the cones always use the density of the slice map
+  auto slice_map_matrix = mapping_matrix * slice_map_mvp *
+                          glm::inverse(view * object_model);
+  auto voxel_size = step_size;
+  if (use_svo && ao_method == AO_RAY_MARCHING) {
+    slice_map_matrix = mapping_matrix * svo_projection *
+                       glm::inverse(view * object_model);
+    voxel_size = 1.0f / svo_resolution;
+  }
+  shader.SetUniform("slice_map_matrix", slice_map_matrix);
+  shader.SetUniform("slice_map_matrix_it",
+      glm::transpose(glm::inverse(slice_map_matrix)));
+  bool temporal = temporal_occlusion && !interleaved_occlusion &&
+                  !refining_occlusion;
+  shader.SetUniform("n_rays", GetTracedRays());
+  shader.SetUniform("ray_offset", temporal ?
+                    occlusion_frame * temporal_rays % n_rays : 0);
+  shader.SetUniform("ray_set_size", n_rays);
+  shader.SetUniform("cosine_rays", ray_set != RAY_SET_RANDOM);
+  // The pixels of a sub-image trace the same rays, so they aren't rotated
+  shader.SetUniform("use_rotation_noise",
+                    use_rotation_noise && !interleaved_occlusion);
+  shader.SetTexture2D("rotation_noise", 19, rotation_noise.GetId());
+  // The golden ratio offsets spread the rotations of consecutive frames
+  shader.SetUniform("rotation_offset", temporal || refining_occlusion ?
+                    (float)fmod(occlusion_frame * 0.618034, 1.0) : 0.0f);
+  shader.SetUniform("adaptive", adaptive_occlusion);
+  shader.SetUniform("adaptive_batch", adaptive_batch);
+  shader.SetUniform("adaptive_error", adaptive_error);
+  shader.SetUniform("interleaved", interleaved_occlusion);
+  shader.SetUniform("interleave_size", interleave_size);
+  shader.SetUniform("sub_image_size", GetSubImageSize());
+  shader.SetUniform("max_distance", max_distance);
+  shader.SetUniform("step_size", voxel_size);
+  shader.SetUniform("n_volume_buffers", n_volume_buffers);
+  shader.SetUniform("volume_resolution", volume_resolution);
+
+  shader.SetTexture3D("distance_field", 11, distance_field.GetId());
+  shader.SetUniform("distance_field_resolution",
+                    distance_field_resolution);
+  shader.SetUniform("use_distance_field",
+                    distance_field_mode != DISTANCE_FIELD_OFF);
+  shader.SetUniform("use_svo", use_svo);
+  shader.SetUniform("svo_root", (int)svo.GetRoot());
+  shader.SetUniform("svo_depth", svo.GetDepth());
+  shader.SetUniform("svo_resolution", svo.GetResolution());
+  shader.SetStorageBuffer("OctreeBlock", 1, svo_buffer.GetId());
+  shader.SetUniform("use_bricks", use_bricks);
+  shader.SetTexture3D("brick_table", 15, brick_table.GetId());
+  shader.SetTexture2D("brick_pool", 16, brick_pool.GetId());
+
+  auto &clipmap_texts = clipmap_framebuffer.GetTextures();
+  for (int i = 0; i < clipmap_buffers; ++i) {
+    auto name = "clipmap[" + std::to_string(i) + "]";
+    shader.SetTexture2D(name, 13 + i, clipmap_texts[i]);
+  }
+  auto clipmap_matrix = glm::scale(glm::vec3(1, 1, -1) /
+                         GetClipmapVoxelSize(0)) *
+                        glm::inverse(view);
+  shader.SetUniform("use_clipmap",
+                    use_clipmap && ao_method == AO_RAY_MARCHING);
+  shader.SetUniform("clipmap_levels", clipmap_levels);
+  shader.SetUniform("clipmap_resolution", clipmap_resolution);
+  shader.SetUniform("clipmap_matrix", clipmap_matrix);
+  shader.SetUniform("clipmap_matrix_it",
+      glm::transpose(glm::inverse(clipmap_matrix)));
+  for (int i = 0; i < clipmap_levels; ++i) {
+    auto name = "clipmap_origins[" + std::to_string(i) + "]";
+    shader.SetUniform(name, glm::vec3(clipmap_origins[i]));
+  }
+  // The ray length is the same of the slice map, in scene units
+  auto ray_length = max_distance * 2 * scene_radius;
+  shader.SetUniform("clipmap_max_distance",
+                    ray_length / GetClipmapVoxelSize(0));
+  shader.SetUniform("ao_method", ao_method);
+  shader.SetTexture3D("density", 12, density.GetId());
+  shader.SetUniform("density_resolution", density_resolution);
+  shader.SetTexture3D("occlusion_cache", 20, occlusion_cache.GetId());
+  shader.SetUniform("detail_rays", use_detail_rays ? detail_rays : 0);
+  shader.SetUniform("detail_distance",
+                    detail_cells / occlusion_cache_resolution);
+}
+
+// Updates the occlusion cache: finds the bounds of the cells whose density
+// changed, and traces the cells within the reach of the rays of them
+void UpdateOcclusionCache() {
+  const int32_t empty_bounds[] = {INT_MAX, INT_MAX, INT_MAX, 0,
+                                  INT_MIN, INT_MIN, INT_MIN, 0};
+  occlusion_cache_dirty.SetData(empty_bounds, sizeof(empty_bounds));
+  int level = (int)round(log2((float)density_resolution /
+                              occlusion_cache_resolution));
+  int n_groups = occlusion_cache_resolution / 4;
+
+  occlusion_cache_diff_shader.Enable();
+  occlusion_cache_diff_shader.SetTexture3D("density", 0, density.GetId());
+  occlusion_cache_diff_shader.SetUniform("density_level", level);
+  occlusion_cache_diff_shader.SetImage("cache_density", 0,
+                                       occlusion_cache_density.GetId(),
+                                       GL_READ_WRITE, GL_R16F, true);
+  occlusion_cache_diff_shader.SetStorageBuffer(
+      "DirtyBlock", 3, occlusion_cache_dirty.GetId());
+  occlusion_cache_diff_shader.Dispatch(n_groups, n_groups, n_groups);
+  occlusion_cache_diff_shader.Disable();
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  // The cells trace every ray of the set in the space of the slice map
+  occlusion_cache_shader.Enable();
+  SetOcclusionUniforms(occlusion_cache_shader);
+  occlusion_cache_shader.SetUniform("n_rays", n_rays);
+  occlusion_cache_shader.SetUniform("ray_offset", 0);
+  occlusion_cache_shader.SetUniform("rotation_offset", 0.0f);
+  occlusion_cache_shader.SetUniform("use_rotation_noise", false);
+  occlusion_cache_shader.SetUniform("interleaved", false);
+  occlusion_cache_shader.SetUniform("adaptive", false);
+  occlusion_cache_shader.SetUniform("use_svo", false);
+  occlusion_cache_shader.SetUniform("use_clipmap", false);
+  occlusion_cache_shader.SetUniform("step_size", step_size);
+  occlusion_cache_shader.SetUniform("density_level", level);
+  occlusion_cache_shader.SetUniform("reach", (int)ceil(
+      max_distance * occlusion_cache_resolution) + 1);
+  occlusion_cache_shader.SetImage("cache_cells", 0, occlusion_cache.GetId(),
+                                  GL_WRITE_ONLY, GL_RG16F, true);
+  occlusion_cache_shader.SetStorageBuffer("DirtyBlock", 3,
+                                          occlusion_cache_dirty.GetId());
+  occlusion_cache_shader.Dispatch(n_groups, n_groups, n_groups);
+  occlusion_cache_shader.Disable();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  occlusion_cache_outdated = false;
+}
+
+// Traces the ambient occlusion of the geometry in the target; each pixel of
+// the target traces the center of its block of scale x scale pixels of the
+// geometry
+void TraceOcclusion(FrameBuffer& target,
+                    const std::vector<unsigned int>& geometry, int scale) {
+  target.Bind();
+  glViewport(0, 0, target.GetWidth(), target.GetHeight());
+  occlusion_shader.Enable();
+  occlusion_shader.SetTexture2D("position_sampler", 0, geometry[0]);
+  occlusion_shader.SetTexture2D("normal_sampler", 1, geometry[1]);
+  occlusion_shader.SetTexture2D("material_sampler", 2, geometry[2]);
+  occlusion_shader.SetUniform("occlusion_scale", scale);
+  occlusion_shader.SetUniform("collect_statistics", collect_statistics);
+  occlusion_shader.SetUniform("use_cache", use_occlusion_cache &&
+                              !use_svo && !use_clipmap);
+  occlusion_shader.SetStorageBuffer("StatisticsBlock", 0,
+                                    lightpass_statistics.GetId());
+  SetOcclusionUniforms(occlusion_shader);
+  auto &history_texts = occlusion_history_framebuffer.GetTextures();
+  occlusion_shader.SetUniform("use_history",
+                              (temporal_occlusion || refining_occlusion) &&
+                              !interleaved_occlusion &&
+                              occlusion_history_valid);
+  occlusion_shader.SetTexture2D("history_sampler", 17, history_texts[0]);
+  occlusion_shader.SetTexture2D("history_occlusion_sampler", 18,
+                                history_texts[1]);
+  occlusion_shader.SetTexture2D("history_surface_sampler", 21,
+                                history_texts[2]);
+  occlusion_shader.SetUniform("history_matrix",
+                              history_view * glm::inverse(view));
+  occlusion_shader.SetUniform("history_projection", history_projection);
+  occlusion_shader.SetUniform("world_from_view", glm::inverse(view));
+  occlusion_shader.SetUniform("max_history", refining_occlusion ?
+                              progressive_batches : max_history);
+  screen_quad.DrawElements(GL_QUADS);
+  occlusion_shader.Disable();
+  target.Unbind();
+}
+
+// Traces the ambient occlusion with interleaved sampling: deinterleaves the
+// geometry of the traced pixels in sub-images, traces them (each one with
+// its subset of the rays) and reinterleaves the occlusion in the occlusion
+// target with the geometry-aware blur
+void TraceInterleavedOcclusion() {
+  auto &texts = geom_framebuffer.GetTextures();
+  auto occlusion_size = glm::ivec2(occlusion_framebuffer.GetWidth(),
+                                   occlusion_framebuffer.GetHeight());
+  auto sub_image_size = GetSubImageSize();
+  deinterleaved_framebuffer.Bind();
+  glViewport(0, 0, deinterleaved_framebuffer.GetWidth(),
+             deinterleaved_framebuffer.GetHeight());
+  occlusion_deinterleave_shader.Enable();
+  occlusion_deinterleave_shader.SetTexture2D("position_sampler", 0, texts[0]);
+  occlusion_deinterleave_shader.SetTexture2D("normal_sampler", 1, texts[1]);
+  occlusion_deinterleave_shader.SetTexture2D("material_sampler", 2, texts[2]);
+  occlusion_deinterleave_shader.SetUniform("occlusion_scale",
+                                           occlusion_scale);
+  occlusion_deinterleave_shader.SetUniform("occlusion_size", occlusion_size);
+  occlusion_deinterleave_shader.SetUniform("interleave_size",
+                                           interleave_size);
+  occlusion_deinterleave_shader.SetUniform("sub_image_size", sub_image_size);
+  screen_quad.DrawElements(GL_QUADS);
+  occlusion_deinterleave_shader.Disable();
+  deinterleaved_framebuffer.Unbind();
+
+  auto &deinterleaved_texts = deinterleaved_framebuffer.GetTextures();
+  TraceOcclusion(interleaved_occlusion_framebuffer, deinterleaved_texts, 1);
+
+  occlusion_framebuffer.Bind();
+  glViewport(0, 0, occlusion_size.x, occlusion_size.y);
+  occlusion_interleave_shader.Enable();
+  occlusion_interleave_shader.SetTexture2D("position_sampler", 0,
+                                           deinterleaved_texts[0]);
+  occlusion_interleave_shader.SetTexture2D("normal_sampler", 1,
+                                           deinterleaved_texts[1]);
+  occlusion_interleave_shader.SetTexture2D(
+      "occlusion_sampler", 2,
+      interleaved_occlusion_framebuffer.GetTextures()[0]);
+  occlusion_interleave_shader.SetUniform("interleave_size", interleave_size);
+  occlusion_interleave_shader.SetUniform("sub_image_size", sub_image_size);
+  occlusion_interleave_shader.SetUniform("occlusion_size", occlusion_size);
+  screen_quad.DrawElements(GL_QUADS);
+  occlusion_interleave_shader.Disable();
+  occlusion_framebuffer.Unbind();
+}
+
+// Obtains the occlusion at the traced resolution, after the denoiser
+unsigned int GetTracedOcclusion() {
+  if (denoise_iterations == 0)
+    return occlusion_framebuffer.GetTextures()[0];
+  return denoise_framebuffers[(denoise_iterations - 1) % 2].GetTextures()[0];
+}
+
+// Obtains the occlusion at the resolution of the geometry pass
+unsigned int GetOcclusion() {
+  if (occlusion_scale > 1)
+    return upsampled_occlusion_framebuffer.GetTextures()[0];
+  return GetTracedOcclusion();
+}
+
+// Denoises the traced occlusion with denoise_iterations iterations of the
+// a-trous filter; the iteration i writes the denoise target i % 2
+void DenoiseOcclusion() {
+  auto &texts = geom_framebuffer.GetTextures();
+  auto input = occlusion_framebuffer.GetTextures()[0];
+  occlusion_denoise_shader.Enable();
+  occlusion_denoise_shader.SetTexture2D("position_sampler", 0, texts[0]);
+  occlusion_denoise_shader.SetTexture2D("normal_sampler", 1, texts[1]);
+  occlusion_denoise_shader.SetUniform("occlusion_scale", occlusion_scale);
+  for (int i = 0; i < denoise_iterations; ++i) {
+    auto &target = denoise_framebuffers[i % 2];
+    target.Bind();
+    glViewport(0, 0, target.GetWidth(), target.GetHeight());
+    occlusion_denoise_shader.SetTexture2D("occlusion_sampler", 2, input);
+    occlusion_denoise_shader.SetUniform("step_width", 1 << i);
+    screen_quad.DrawElements(GL_QUADS);
+    target.Unbind();
+    input = target.GetTextures()[0];
+  }
+  occlusion_denoise_shader.Disable();
+}
+
+// Indicates if the frame shows what the last occlusion did: the camera isn't
+// being manipulated, nothing rotates or moves, and the view is the one of the
+// last occlusion
+bool IsViewStatic() {
+  return manipulator.IsIdle() && !light_rotation && !object_rotation &&
+         !(animate_instances && n_dynamic_instances > 0) &&
+         occlusion_history_valid && view == history_view;
+}
+
+// Indicates if the progressive refinement converged and the window didn't
+// change, so the last frame can be kept
+bool IsOcclusionConverged(GLFWwindow *window) {
+  int width, height;
+  glfwGetFramebufferSize(window, &width, &height);
+  return progressive_occlusion && !interleaved_occlusion &&
+         progressive_batch >= progressive_batches && IsViewStatic() &&
+         width == window_w && height == window_h;
+}
+
+// Renders the ambient occlusion pass at 1 / occlusion_scale of the
+// resolution, and upsamples it to the resolution of the geometry pass
+void RenderOcclusion() {
+  // The static frames refine the occlusion, until it converges
+  bool refining = progressive_occlusion && !interleaved_occlusion &&
+                  IsViewStatic();
+  if (refining && progressive_batch >= progressive_batches)
+    return;
+  refining_occlusion = refining;
+  progressive_batch = refining ? progressive_batch + 1 : 1;
+
+  if (occlusion_cache_outdated && use_occlusion_cache)
+    UpdateOcclusionCache();
+  glPushAttrib(GL_VIEWPORT_BIT | GL_ENABLE_BIT);
+  glDisable(GL_DEPTH_TEST);
+  auto &texts = geom_framebuffer.GetTextures();
+  // The target of the previous frame is the history of this one
+  occlusion_framebuffer.Swap(occlusion_history_framebuffer);
+  if (interleaved_occlusion)
+    TraceInterleavedOcclusion();
+  else
+    TraceOcclusion(occlusion_framebuffer, texts, occlusion_scale);
+  history_view = view;
+  history_projection = perspective_projection;
+  occlusion_history_valid = true;
+  occlusion_frame++;
+  DenoiseOcclusion();
+
+  if (occlusion_scale > 1) {
+    upsampled_occlusion_framebuffer.Bind();
+    glViewport(0, 0, window_w, window_h);
+    occlusion_upsample_shader.Enable();
+    occlusion_upsample_shader.SetTexture2D("position_sampler", 0, texts[0]);
+    occlusion_upsample_shader.SetTexture2D("normal_sampler", 1, texts[1]);
+    occlusion_upsample_shader.SetTexture2D("occlusion_sampler", 2,
+                                           GetTracedOcclusion());
+    occlusion_upsample_shader.SetUniform("occlusion_scale", occlusion_scale);
+    screen_quad.DrawElements(GL_QUADS);
+    occlusion_upsample_shader.Disable();
+    upsampled_occlusion_framebuffer.Unbind();
+  }
+  glPopAttrib();
+}
+
+// Renders the lighting pass
+void RenderLighting() {
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  lightpass_shader.Enable();
+
+  auto &texts = geom_framebuffer.GetTextures();
+  lightpass_shader.SetTexture2D("position_sampler", 0, texts[0]);
+  lightpass_shader.SetTexture2D("normal_sampler", 1, texts[1]);
+  lightpass_shader.SetTexture2D("material_sampler", 2, texts[2]);
+  lightpass_shader.SetTexture2D("occlusion_sampler", 3, GetOcclusion());
+
+  lightpass_shader.SetUniformBuffer("MaterialsBlock", 0, materials.GetId());
+  lightpass_shader.SetUniformBuffer("LightsBlock", 1, lights.GetId());
+  lightpass_shader.SetUniform("mode", mode);
+  lightpass_shader.SetUniform("n_rays", GetTracedRays());
+  lightpass_shader.SetUniform("baked_occlusion", IsOcclusionBaked());
+  lightpass_shader.SetUniform("occlusion_factor", occlusion_factor);
+
+  screen_quad.DrawElements(GL_QUADS);
+
+  lightpass_shader.Disable();
+}
+
+// Renders the scene
+void Render() {
+  UpdateObjectMatrices(ortho_projection);
+  UpdateVolume();
+  UpdateObjectMatrices(perspective_projection);
+  if (debug_slice_map) {
+    RenderSliceForDebug();
+  } else {
+    RenderGeometry();
+    occlusion_timer.Begin();
+    if (!IsOcclusionBaked())
+      RenderOcclusion();
+    occlusion_timer.End();
+    lighting_timer.Begin();
+    RenderLighting();
+    lighting_timer.End();
+  }
+}
+
+// Obtains the gpu time of the last frame lighting, with the ambient
+// occlusion
+double GetLightingTime() {
+  return occlusion_timer.GetElapsedTime() + lighting_timer.GetElapsedTime();
 }
 
 // Measures the frames per second (and prints in the terminal)
@@ -564,8 +2633,11 @@ void ComputeFPS() {
   static int frames = 0;
   double curr = glfwGetTime();
   if (curr - last > 1.0) {
-    printf("                    \r");
-    printf("fps: %d\r", frames);
+    printf("%-79s\r", "");
+    printf("fps: %d  voxelization: %.2fms  distance field: %.2fms  "
+           "lighting: %.2fms\r",
+           frames, voxelization_timer.GetElapsedTime(),
+           distance_field_timer.GetElapsedTime(), GetLightingTime());
     fflush(stdout);
     last += 1.0;
     frames = 0;
@@ -584,6 +2656,8 @@ void Resize(GLFWwindow *window) {
   window_h = height;
   glViewport(0, 0, width, height);
   geom_framebuffer.Resize(width, height);
+  upsampled_occlusion_framebuffer.Resize(width, height);
+  SetOcclusionScale(occlusion_scale);
   CreateMatrices();
 }
 
@@ -603,6 +2677,15 @@ void Idle() {
   if (object_rotation) {
     rotate(object_model);
   }
+  if (animate_instances && n_dynamic_instances > 0) {
+    auto c = object_bounds.GetSphere().center;
+    auto spin = glm::translate(c) *
+                glm::rotate(angle, glm::vec3(0, 1, 0)) * glm::translate(-c);
+    for (int i = n_instances - n_dynamic_instances; i < n_instances; ++i)
+      instance_models[i] = instance_models[i] * spin;
+    instances_moved = true;
+    clipmap_object_model = glm::mat4(0);
+  }
 
   last = curr;
 }
@@ -610,6 +2693,9 @@ void Idle() {
 // Keyboard callback
 void Keyboard(GLFWwindow *window, int key, int scancode, int action, int mods) {
   if (action != GLFW_PRESS) return;
+  // The keys that change the occlusion also drop the occlusion accumulated
+  // over the previous frames
+  frame_outdated = true;
 
   switch (key) {
     case GLFW_KEY_Q:
@@ -636,6 +2722,148 @@ void Keyboard(GLFWwindow *window, int key, int scancode, int action, int mods) {
     case GLFW_KEY_S:
       debug_slice_map = !debug_slice_map;
       break;
+    case GLFW_KEY_H:
+      if (mode == MODE_STEPS_DEBUG)
+        mode = MODE_FULL_LIGHTING;
+      else
+        mode = MODE_STEPS_DEBUG;
+      break;
+    case GLFW_KEY_W:
+      if (mode == MODE_RAYS_DEBUG)
+        mode = MODE_FULL_LIGHTING;
+      else
+        mode = MODE_RAYS_DEBUG;
+      break;
+    case GLFW_KEY_F:
+      distance_field_mode = (DistanceFieldMode)((distance_field_mode + 1) %
+                                                DISTANCE_FIELD_MODE_NUMBER);
+      distance_field_outdated = true;
+      printf("\ndistance field: %s\n",
+             DISTANCE_FIELD_MODE_NAMES[distance_field_mode]);
+      break;
+    case GLFW_KEY_V:
+      // The octree and the clipmap voxelize the object meshes
+      if (volume_scene)
+        break;
+      use_svo = !use_svo;
+      occlusion_history_valid = false;
+      if (use_svo && svo.GetResolution() != svo_resolution)
+        BuildSparseVoxelOctree();
+      break;
+    case GLFW_KEY_K:
+      if (volume_scene)
+        break;
+      use_clipmap = !use_clipmap;
+      clipmap_object_model = glm::mat4(0);
+      occlusion_history_valid = false;
+      break;
+    case GLFW_KEY_M:
+      animate_instances = !animate_instances;
+      break;
+    case GLFW_KEY_I:
+      use_object_volumes = !use_object_volumes;
+      // Forces a full update of the slice map
+      slice_map_mvp = glm::mat4(0);
+      occlusion_history_valid = false;
+      printf("\nobject volumes: %s\n", use_object_volumes ? "on" : "off");
+      break;
+    case GLFW_KEY_T:
+      amortized_voxelization = !amortized_voxelization;
+      back_next_buffer = 0;
+      printf("\namortized voxelization: %s\n",
+             amortized_voxelization ? "on" : "off");
+      break;
+    case GLFW_KEY_P:
+      use_bricks = !use_bricks;
+      bricks_outdated = true;
+      break;
+    case GLFW_KEY_Y:
+      occupancy_queries = !occupancy_queries;
+      query_volume_outdated = true;
+      printf("\noccupancy queries: %s\n", occupancy_queries ? "on" : "off");
+      break;
+    case GLFW_KEY_G:
+      use_proxy_mesh = !use_proxy_mesh;
+      occlusion_history_valid = false;
+      printf("\nproxy mesh: %s\n", use_proxy_mesh ? "on" : "off");
+      break;
+    case GLFW_KEY_X:
+      if (volume_scene)
+        break;
+      voxelization_mode = (VoxelizationMode)((voxelization_mode + 1) %
+                                             VOXELIZATION_MODE_NUMBER);
+      // Forces a full update of the slice map and of the object volumes
+      slice_map_mvp = glm::mat4(0);
+      static_layer_mvp = glm::mat4(0);
+      object_volume_outdated = true;
+      back_next_buffer = 0;
+      occlusion_history_valid = false;
+      printf("\nvoxelization: %s\n",
+             VOXELIZATION_MODE_NAMES[voxelization_mode]);
+      break;
+    case GLFW_KEY_R:
+      SetOcclusionScale(occlusion_scale == 4 ? 1 : occlusion_scale * 2);
+      printf("\nambient occlusion resolution: 1/%d\n", occlusion_scale);
+      break;
+    case GLFW_KEY_E:
+      temporal_occlusion = !temporal_occlusion;
+      occlusion_history_valid = false;
+      printf("\ntemporal ambient occlusion: %s\n",
+             temporal_occlusion ? "on" : "off");
+      break;
+    case GLFW_KEY_J:
+      if (n_rays % (interleave_size * interleave_size) != 0) {
+        printf("\ninterleaved sampling needs a multiple of %d rays\n",
+               interleave_size * interleave_size);
+        break;
+      }
+      interleaved_occlusion = !interleaved_occlusion;
+      occlusion_history_valid = false;
+      printf("\ninterleaved sampling: %s\n",
+             interleaved_occlusion ? "on" : "off");
+      break;
+    case GLFW_KEY_1:
+      use_occlusion_cache = !use_occlusion_cache;
+      if (use_occlusion_cache)
+        ResetOcclusionCache();
+      occlusion_history_valid = false;
+      printf("\nocclusion cache: %s\n", use_occlusion_cache ? "on" : "off");
+      break;
+    case GLFW_KEY_2:
+      use_detail_rays = !use_detail_rays;
+      occlusion_history_valid = false;
+      printf("\ndetail rays: %s\n", use_detail_rays ? "on" : "off");
+      break;
+    case GLFW_KEY_Z:
+      progressive_occlusion = !progressive_occlusion;
+      printf("\nprogressive refinement: %s\n",
+             progressive_occlusion ? "on" : "off");
+      break;
+    case GLFW_KEY_N:
+      adaptive_occlusion = !adaptive_occlusion;
+      occlusion_history_valid = false;
+      printf("\nadaptive sampling: %s\n", adaptive_occlusion ? "on" : "off");
+      break;
+    case GLFW_KEY_D:
+      denoise_iterations = (denoise_iterations + 1) %
+                           (max_denoise_iterations + 1);
+      printf("\ndenoiser iterations: %d\n", denoise_iterations);
+      break;
+    case GLFW_KEY_U:
+      use_rotation_noise = !use_rotation_noise;
+      occlusion_history_valid = false;
+      printf("\nrotation noise: %s\n", use_rotation_noise ? "on" : "off");
+      break;
+    case GLFW_KEY_B:
+      fit_mode = (FitMode)((fit_mode + 1) % FIT_MODE_NUMBER);
+      occlusion_history_valid = false;
+      printf("\nvolume fit: %s\n", FIT_MODE_NAMES[fit_mode]);
+      break;
+    case GLFW_KEY_C:
+      ao_method = (AmbientOcclusionMethod)((ao_method + 1) % AO_METHOD_NUMBER);
+      occlusion_history_valid = false;
+      printf("\nambient occlusion: %s\n", AO_METHOD_NAMES[ao_method]);
+      break;
     default:
       break;
   }
@@ -656,6 +2884,17 @@ void Motion(GLFWwindow *window, double x, double y) {
     manipulator.MouseMotion((int)x, (int)y);
 }
 
+// Obtains the value of a command line argument (--name=value)
+// Returns nullptr if the argument wasn't passed
+const char *GetArgument(int argc, char *argv[], const char *name) {
+  size_t length = strlen(name);
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], name, length) == 0)
+      return argv[i] + length;
+  }
+  return nullptr;
+}
+
 // Obtais the monitor if the fullscreen flag is active
 GLFWmonitor *GetGLFWMonitor(int argc, char *argv[]) {
   bool fullscreen = false;
@@ -705,36 +2944,1578 @@ void InitApplication() {
   LoadGlobalConfiguration();
   LoadFramebuffer();
   LoadSliceMap();
+  LoadDistanceField();
+  LoadClipmap();
   LoadShaders();
   CreateVoxelDepthLUT();
   CreateRays();
+  CreateRotationNoise();
   CreateMaterialsBuffer();
   LoadScreenQuad();
-  LoadObjectMesh();
   CreateMatrices();
+  LoadScene();
   puts(HELP_TEXT);
 }
 
+// Updates the scene and renders a frame
+void RenderFrame(GLFWwindow *window) {
+  Idle();
+  Resize(window);
+  UpdateViewMatrix();
+  UpdateOrthoMatrix();
+  Render();
+}
+
 // Application main loop
 void MainLoop(GLFWwindow *window) {
   while (!glfwWindowShouldClose(window)) {
-    Idle();
-    Resize(window);
-    UpdateViewMatrix();
-    UpdateOrthoMatrix();
-    Render();
+    // The frame of a converged occlusion doesn't change until an event does
+    if (IsOcclusionConverged(window) && !frame_outdated) {
+      glfwWaitEvents();
+      continue;
+    }
+    frame_outdated = false;
+    RenderFrame(window);
     ComputeFPS();
     glfwSwapBuffers(window);
     glfwPollEvents();
   };
 }
 
+// Renders the benchmark frames, obtains the average lighting time (ms) and
+// the average ray traversal steps per pixel
+void MeasureLighting(GLFWwindow *window, double *lighting_time,
+                     double *steps_per_pixel) {
+  double total_time = 0;
+  double total_steps = 0;
+  double total_pixels = 0;
+  collect_statistics = true;
+  for (int i = 0; i < BENCHMARK_FRAMES; ++i) {
+    uint32_t statistics[2] = {0, 0};
+    lightpass_statistics.SetData(statistics, sizeof(statistics));
+    RenderFrame(window);
+    glfwSwapBuffers(window);
+    glFinish();
+    lightpass_statistics.GetData(statistics, sizeof(statistics));
+    total_steps += statistics[0];
+    total_pixels += statistics[1];
+    total_time += GetLightingTime();
+  }
+  collect_statistics = false;
+  *lighting_time = total_time / BENCHMARK_FRAMES;
+  *steps_per_pixel = total_steps / std::max(total_pixels, 1.0);
+}
+
+// Compares the ambient occlusion with and without the distance field, and
+// the cost of building it on the gpu and on the cpu
+void BenchmarkDistanceField(GLFWwindow *window) {
+  const int N_BUILDS = 10;
+  printf("%-20s %12s %14s %16s\n", "distance field", "build (ms)",
+         "lighting (ms)", "steps per pixel");
+  for (int i = 0; i < DISTANCE_FIELD_MODE_NUMBER; ++i) {
+    distance_field_mode = (DistanceFieldMode)i;
+    RenderFrame(window);
+    double build_time = 0;
+    if (distance_field_mode != DISTANCE_FIELD_OFF) {
+      glFinish();
+      double start = glfwGetTime();
+      for (int j = 0; j < N_BUILDS; ++j)
+        BuildDistanceField();
+      glFinish();
+      build_time = (glfwGetTime() - start) * 1000 / N_BUILDS;
+    }
+    double lighting_time, steps_per_pixel;
+    MeasureLighting(window, &lighting_time, &steps_per_pixel);
+    printf("%-20s %12.2f %14.2f %16.1f\n", DISTANCE_FIELD_MODE_NAMES[i],
+           build_time, lighting_time, steps_per_pixel);
+  }
+}
+
+// Compares the memory and the traversal cost of the dense slice map and of
+// the sparse voxel octree
+void BenchmarkSparseVoxelOctree(GLFWwindow *window) {
+  RenderFrame(window);
+  BuildSparseVoxelOctree();
+  auto MB = [](double bytes) { return bytes / (1024 * 1024); };
+  double dense_size = (double)volume_resolution * volume_resolution *
+                      volume_resolution / 8;
+  double distance_field_size = pow(distance_field_resolution, 3) *
+                               (sizeof(uint16_t) + 2 * sizeof(uint32_t));
+  struct Configuration {
+    const char *name;
+    bool svo;
+    DistanceFieldMode distance_field;
+    double size;
+  } configurations[] = {
+    {"dense", false, DISTANCE_FIELD_OFF, dense_size},
+    {"dense + distance", false, DISTANCE_FIELD_GPU,
+     dense_size + distance_field_size},
+    {"octree", true, DISTANCE_FIELD_OFF, (double)svo.GetSize()},
+  };
+  printf("%-18s %10s %12s %14s %16s\n", "volume", "resolution",
+         "memory (MB)", "lighting (ms)", "steps per pixel");
+  for (auto& configuration : configurations) {
+    use_svo = configuration.svo;
+    distance_field_mode = configuration.distance_field;
+    distance_field_outdated = true;
+    double lighting_time, steps_per_pixel;
+    MeasureLighting(window, &lighting_time, &steps_per_pixel);
+    printf("%-18s %10d %12.1f %14.2f %16.1f\n", configuration.name,
+           use_svo ? svo_resolution : volume_resolution,
+           MB(configuration.size), lighting_time, steps_per_pixel);
+  }
+}
+
+// Compares the ambient occlusion of the 32 rays march and of the cone
+// tracing, including the cost of building the density mip chain
+void BenchmarkConeTracing(GLFWwindow *window) {
+  const int N_BUILDS = 10;
+  printf("%-20s %6s %12s %14s %16s %9s\n", "ambient occlusion", "rays",
+         "build (ms)", "lighting (ms)", "steps per pixel", "speedup");
+  double ray_marching_time = 0;
+  for (int i = 0; i < AO_METHOD_NUMBER; ++i) {
+    ao_method = (AmbientOcclusionMethod)i;
+    RenderFrame(window);
+    double build_time = 0;
+    if (ao_method == AO_CONE_TRACING) {
+      glFinish();
+      double start = glfwGetTime();
+      for (int j = 0; j < N_BUILDS; ++j)
+        BuildDensity();
+      glFinish();
+      build_time = (glfwGetTime() - start) * 1000 / N_BUILDS;
+    }
+    double lighting_time, steps_per_pixel;
+    MeasureLighting(window, &lighting_time, &steps_per_pixel);
+    if (ao_method == AO_RAY_MARCHING)
+      ray_marching_time = lighting_time;
+    printf("%-20s %6d %12.2f %14.2f %16.1f %8.2fx\n", AO_METHOD_NAMES[i],
+           ao_method == AO_RAY_MARCHING ? n_rays : n_cones, build_time,
+           lighting_time, steps_per_pixel, ray_marching_time / lighting_time);
+  }
+}
+
+// Measures the clipmap update while the camera moves at several speeds,
+// compared with voxelizing every cascade from scratch
+void BenchmarkClipmap(GLFWwindow *window) {
+  const float SPEEDS[] = {0, 1, 4, 16, 64};
+  auto initial_eye = eye;
+  auto initial_center = center;
+  use_clipmap = true;
+  printf("%-22s %12s %18s %14s\n", "camera (voxels/frame)", "update (ms)",
+         "voxels per frame", "lighting (ms)");
+  for (int i = -1; i < (int)(sizeof(SPEEDS) / sizeof(SPEEDS[0])); ++i) {
+    bool full = i < 0;
+    // Moves along every axis, in voxels of the first cascade
+    auto velocity = glm::normalize(glm::vec3(1, 1, 1)) *
+                    (full ? 0 : SPEEDS[i]) * GetClipmapVoxelSize(0);
+    eye = initial_eye;
+    center = initial_center;
+    RenderFrame(window);
+    double update_time = 0;
+    double updated_voxels = 0;
+    double lighting_time = 0;
+    for (int j = 0; j < BENCHMARK_FRAMES; ++j) {
+      eye += velocity;
+      center += velocity;
+      if (full)
+        clipmap_object_model = glm::mat4(0);
+      RenderFrame(window);
+      glfwSwapBuffers(window);
+      glFinish();
+      update_time += clipmap_timer.GetElapsedTime();
+      updated_voxels += clipmap_updated_voxels;
+      lighting_time += GetLightingTime();
+    }
+    auto name = full ? std::string("full rebuild") :
+                std::to_string((int)SPEEDS[i]);
+    printf("%-22s %12.3f %18.0f %14.2f\n", name.c_str(),
+           update_time / BENCHMARK_FRAMES, updated_voxels / BENCHMARK_FRAMES,
+           lighting_time / BENCHMARK_FRAMES);
+  }
+  eye = initial_eye;
+  center = initial_center;
+}
+
+// Measures the voxelization cost per frame while the object rotates inside
+// the bounding sphere volume (voxelized again every frame), all at once and
+// amortized over several frames
+void BenchmarkAmortizedVoxelization(GLFWwindow *window) {
+  const int FRAMES[] = {1, 2, 4, 8};
+  const int WARMUP_FRAMES = 2;
+  fit_mode = FIT_SPHERE;
+  object_rotation = true;
+  printf("%-14s %10s %10s %13s %13s %11s\n", "voxelization", "mean (ms)",
+         "max (ms)", "std dev (ms)", "full updates", "staleness");
+  for (int i = 0; i < (int)(sizeof(FRAMES) / sizeof(FRAMES[0])); ++i) {
+    amortized_voxelization = FRAMES[i] > 1;
+    amortization_frames = FRAMES[i];
+    slice_map_mvp = glm::mat4(0);
+    for (int j = 0; j < WARMUP_FRAMES; ++j)
+      RenderFrame(window);
+    n_full_voxelizations = 0;
+    double sum = 0, sum_squares = 0, max_time = 0, staleness = 0;
+    for (int j = 0; j < BENCHMARK_FRAMES; ++j) {
+      RenderFrame(window);
+      glfwSwapBuffers(window);
+      glFinish();
+      double time = voxelization_timer.GetElapsedTime();
+      sum += time;
+      sum_squares += time * time;
+      max_time = std::max(max_time, time);
+      staleness += volume_frame - slice_map_frame;
+    }
+    double mean = sum / BENCHMARK_FRAMES;
+    double deviation = sqrt(std::max(sum_squares / BENCHMARK_FRAMES -
+                                     mean * mean, 0.0));
+    auto name = FRAMES[i] == 1 ? std::string("every frame") :
+                std::to_string(FRAMES[i]) + " frames";
+    printf("%-14s %10.3f %10.3f %13.3f %13d %11.1f\n", name.c_str(), mean,
+           max_time, deviation, n_full_voxelizations,
+           staleness / BENCHMARK_FRAMES);
+  }
+}
+
+// Compares the slice map update cost per frame while the dynamic instances
+// move, voxelizing every instance again and compositing the object volumes
+void BenchmarkObjectVolumes(GLFWwindow *window) {
+  const int WARMUP_FRAMES = 2;
+  Assert(n_dynamic_instances > 0, "the benchmark needs dynamic instances "
+         "(--instances=<n> --dynamic-instances=<n>)");
+  fit_mode = FIT_ORIENTED_BOX;
+  animate_instances = true;
+  printf("%d instances, %d dynamic\n", n_instances, n_dynamic_instances);
+  printf("%-16s %12s %18s\n", "slice map", "update (ms)", "voxels per frame");
+  for (int i = 0; i < 2; ++i) {
+    use_object_volumes = i == 1;
+    slice_map_mvp = glm::mat4(0);
+    for (int j = 0; j < WARMUP_FRAMES; ++j)
+      RenderFrame(window);
+    double update_time = 0;
+    double updated_voxels = 0;
+    for (int j = 0; j < BENCHMARK_FRAMES; ++j) {
+      RenderFrame(window);
+      glfwSwapBuffers(window);
+      glFinish();
+      update_time += voxelization_timer.GetElapsedTime();
+      updated_voxels += use_object_volumes ? composited_voxels :
+                        pow(volume_resolution, 3);
+    }
+    printf("%-16s %12.3f %18.0f\n",
+           use_object_volumes ? "object volumes" : "voxelization",
+           update_time / BENCHMARK_FRAMES, updated_voxels / BENCHMARK_FRAMES);
+  }
+}
+
+// Voxelizes the object in the fitted volume and reads it back to cpu_volume
+void ReadFittedVolume() {
+  fit_mode = FIT_ORIENTED_BOX;
+  // The volumetric scenes are already in the slice map
+  if (!volume_scene) {
+    UpdateObjectMatrices(volume_projection *
+                         glm::inverse(view * object_model));
+    RenderSliceMap();
+  }
+  slice_map_mvp = volume_projection;
+  back_next_buffer = 0;
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+}
+
+// Voxelizes the object in the fitted volume into cpu_volume, on the gpu or
+// on the cpu (--cpu-voxelizer), for the bakers; returns the time in ms
+double VoxelizeBakedObject() {
+  Assert(!volume_scene && n_instances == 1,
+         "the occlusion is baked for a single object instance");
+  double start = glfwGetTime();
+  if (use_cpu_voxelizer) {
+    if (cpu_volume.GetResolution() != volume_resolution)
+      cpu_volume.Init(volume_resolution);
+    cpu_voxelizer.Voxelize(volume_projection, instance_models, &cpu_volume);
+  } else {
+    ReadFittedVolume();
+  }
+  return (glfwGetTime() - start) * 1000;
+}
+
+// Merges the shapes of the object file, in order (the texture coordinates
+// are only merged if every shape has them)
+void MergeObjectShapes(std::vector<float> *positions,
+                       std::vector<float> *normals,
+                       std::vector<float> *texcoords,
+                       std::vector<unsigned int> *indices) {
+  bool has_texcoords = true;
+  for (auto& shape : LoadObjectShapes()) {
+    auto& mesh = shape.mesh;
+    Assert(mesh.normals.size() == mesh.positions.size(),
+           "the object has no vertex normals");
+    unsigned int first = positions->size() / 3;
+    for (auto index : mesh.indices)
+      indices->push_back(first + index);
+    positions->insert(positions->end(), mesh.positions.begin(),
+                      mesh.positions.end());
+    normals->insert(normals->end(), mesh.normals.begin(), mesh.normals.end());
+    has_texcoords = has_texcoords &&
+                    mesh.texcoords.size() / 2 == mesh.positions.size() / 3;
+    texcoords->insert(texcoords->end(), mesh.texcoords.begin(),
+                      mesh.texcoords.end());
+  }
+  if (!has_texcoords)
+    texcoords->clear();
+}
+
+// Maps the object space to the voxel units of the fitted volume
+glm::mat4 GetVoxelFromObject() {
+  return glm::scale(glm::vec3(volume_resolution)) * mapping_matrix *
+         volume_projection;
+}
+
+// Sets the ray set and the ray length of the occlusion pass to the baker
+void InitOcclusionBaker(OcclusionBaker *baker) {
+  try {
+    baker->SetRays(ray_directions, ray_set != RAY_SET_RANDOM);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  baker->SetRayLength(max_distance * volume_resolution);
+}
+
+// Bakes the ambient occlusion of the object vertices into a PLY file: the
+// object is voxelized in the fitted volume and the rays of the vertices are
+// marched on the cpu
+void BakeVertexOcclusion(const std::string& path) {
+  double voxelization_time = VoxelizeBakedObject();
+  std::vector<float> positions, normals, texcoords;
+  std::vector<unsigned int> indices;
+  MergeObjectShapes(&positions, &normals, &texcoords, &indices);
+
+  // The vertices in the voxel units of the volume
+  auto voxel_from_object = GetVoxelFromObject();
+  auto normal_matrix = glm::transpose(glm::inverse(
+      glm::mat3(voxel_from_object)));
+  size_t n_vertices = positions.size() / 3;
+  std::vector<glm::vec3> points(n_vertices), directions(n_vertices);
+  for (size_t i = 0; i < n_vertices; ++i) {
+    auto p = glm::vec4(positions[3 * i], positions[3 * i + 1],
+                       positions[3 * i + 2], 1);
+    auto n = glm::vec3(normals[3 * i], normals[3 * i + 1],
+                       normals[3 * i + 2]);
+    points[i] = glm::vec3(voxel_from_object * p);
+    directions[i] = glm::normalize(normal_matrix * n);
+  }
+
+  OcclusionBaker baker;
+  InitOcclusionBaker(&baker);
+  std::vector<float> occlusion;
+  double start = glfwGetTime();
+  baker.Bake(cpu_volume, points, directions, &occlusion);
+  double bake_time = glfwGetTime() - start;
+  try {
+    SaveOcclusionPly(path, positions, normals, indices, occlusion,
+                     occlusion_factor);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  printf("baked occlusion: %zu vertices, %d rays, %s voxelization "
+         "%.2f ms, bake %.2f ms (%.0f vertices/s, %d threads)\n",
+         n_vertices, n_rays, use_cpu_voxelizer ? "cpu" : "gpu",
+         voxelization_time, bake_time * 1000, n_vertices / bake_time,
+         GetNumberOfThreads());
+}
+
+// Rasterizes the texture coordinates of the object into the lightmap, in
+// the fitted volume voxelized by VoxelizeBakedObject
+void RasterizeLightmap(Lightmap *target) {
+  std::vector<float> positions, normals, texcoords;
+  std::vector<unsigned int> indices;
+  MergeObjectShapes(&positions, &normals, &texcoords, &indices);
+  Assert(!texcoords.empty(), "the object has no texture coordinates");
+  target->Init(lightmap_size, lightmap_size);
+  target->Rasterize(positions, normals, texcoords, indices,
+                    GetVoxelFromObject());
+}
+
+// Bakes the ambient occlusion of the object in its texture space into a PNG
+// file: the texels covered by the triangles are marched on the cpu and
+// dilated lightmap_padding texels around the charts
+void BakeLightmap(const std::string& path) {
+  double voxelization_time = VoxelizeBakedObject();
+  Lightmap target;
+  RasterizeLightmap(&target);
+  OcclusionBaker baker;
+  InitOcclusionBaker(&baker);
+  double start = glfwGetTime();
+  target.Bake(cpu_volume, baker);
+  double bake_time = glfwGetTime() - start;
+  start = glfwGetTime();
+  target.Dilate(lightmap_padding);
+  double dilation_time = (glfwGetTime() - start) * 1000;
+  try {
+    target.SavePng(path);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  int n_texels = target.CountCoveredTexels();
+  printf("baked lightmap: %dx%d, %d texels (%.1f%%), %d rays, %s "
+         "voxelization %.2f ms, bake %.2f ms (%.0f texels/s, %d threads), "
+         "dilation %.2f ms\n",
+         lightmap_size, lightmap_size, n_texels,
+         100.0 * n_texels / (lightmap_size * lightmap_size), n_rays,
+         use_cpu_voxelizer ? "cpu" : "gpu", voxelization_time,
+         bake_time * 1000, n_texels / bake_time, GetNumberOfThreads(),
+         dilation_time);
+}
+
+// Voxelizes the object in the fitted volume and saves the slice map
+void SaveSliceMap(const std::string& path,
+                  SliceMapFile::Compression compression) {
+  ReadFittedVolume();
+  try {
+    SliceMapFile::Save(path, cpu_volume, volume_projection, compression);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+}
+
+// Loads a saved slice map, which replaces the voxelization while the fitted
+// volume is used
+void LoadSliceMapFile(const std::string& path) {
+  SliceMapFile file;
+  try {
+    file.Open(path);
+    Assertf(file.GetResolution() == volume_resolution,
+            "slice map resolution %d, expected %d", file.GetResolution(),
+            volume_resolution);
+    file.WriteToTextures(voxel_framebuffer.GetTextures());
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  fit_mode = FIT_ORIENTED_BOX;
+  volume_projection = file.GetProjection();
+  slice_map_mvp = volume_projection;
+  back_next_buffer = 0;
+  distance_field_outdated = true;
+  density_outdated = true;
+  bricks_outdated = true;
+  proxy_mesh_outdated = true;
+  query_volume_outdated = true;
+}
+
+// Prints the size of a sparse voxel DAG against the structures it replaces
+void PrintSparseVoxelDAGMemory(const SparseVoxelDAG& dag) {
+  auto MB = [](double bytes) { return bytes / (1024 * 1024); };
+  // Same entries without the deduplication, plus the padding words
+  double tree_size = (dag.GetNumberOfTreeNodes() * 8 +
+                      dag.GetNumberOfTreeBricks() * 2 + 2) * sizeof(uint32_t);
+  double dense_size = pow(dag.GetResolution(), 3) / 8;
+  printf("%-12s %12s %12s %12s\n", "structure", "nodes", "bricks",
+         "size (MB)");
+  printf("%-12s %12s %12s %12.2f\n", "slice map", "-", "-", MB(dense_size));
+  printf("%-12s %12zu %12zu %12.2f\n", "octree", dag.GetNumberOfTreeNodes(),
+         dag.GetNumberOfTreeBricks(), MB(tree_size));
+  printf("%-12s %12zu %12zu %12.2f\n", "dag", dag.GetNumberOfNodes(),
+         dag.GetNumberOfBricks(), MB(dag.GetSize()));
+  printf("compression ratio: %.1fx (slice map), %.2fx (octree)\n",
+         dense_size / dag.GetSize(), tree_size / dag.GetSize());
+}
+
+// Voxelizes the object in the fitted volume and saves it as a sparse voxel
+// DAG
+void SaveSparseVoxelDAG(const std::string& path) {
+  ReadFittedVolume();
+  SparseVoxelDAG dag;
+  dag.Build(cpu_volume);
+  try {
+    dag.Save(path, volume_projection);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  PrintSparseVoxelDAGMemory(dag);
+}
+
+// Loads a saved sparse voxel DAG and expands it into the slice map, which
+// replaces the voxelization while the fitted volume is used
+void LoadSparseVoxelDAG(const std::string& path) {
+  SparseVoxelDAG dag;
+  glm::mat4 projection;
+  try {
+    projection = dag.Load(path);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  Assertf(dag.GetResolution() == volume_resolution,
+          "DAG resolution %d, expected %d", dag.GetResolution(),
+          volume_resolution);
+  dag.Decode(&cpu_volume);
+  cpu_volume.WriteToTextures(voxel_framebuffer.GetTextures());
+  fit_mode = FIT_ORIENTED_BOX;
+  volume_projection = projection;
+  slice_map_mvp = volume_projection;
+  back_next_buffer = 0;
+  distance_field_outdated = true;
+  density_outdated = true;
+  bricks_outdated = true;
+  proxy_mesh_outdated = true;
+  query_volume_outdated = true;
+}
+
+// Compares the startup cost of voxelizing the object and of loading the
+// slice map from a file, uncompressed and compressed
+void BenchmarkSliceMapFile(GLFWwindow *window) {
+  const int N_LOADS = 10;
+  const char *PATHS[] = {"benchmark.slicemap", "benchmark_zlib.slicemap"};
+  const char *NAMES[] = {"file", "file (zlib)"};
+  auto MB = [](double bytes) { return bytes / (1024 * 1024); };
+  RenderFrame(window);
+
+  glFinish();
+  double start = glfwGetTime();
+  for (int i = 0; i < N_LOADS; ++i) {
+    UpdateObjectMatrices(volume_projection *
+                         glm::inverse(view * object_model));
+    RenderSliceMap();
+  }
+  glFinish();
+  double voxelization_time = (glfwGetTime() - start) * 1000 / N_LOADS;
+  printf("%-16s %10s %10s %10s\n", "slice map", "size (MB)", "save (ms)",
+         "load (ms)");
+  printf("%-16s %10s %10s %10.2f\n", "voxelization", "-", "-",
+         voxelization_time);
+
+  for (int i = 0; i < 2; ++i) {
+    auto compression = (SliceMapFile::Compression)i;
+    start = glfwGetTime();
+    SaveSliceMap(PATHS[i], compression);
+    double save_time = (glfwGetTime() - start) * 1000;
+    glFinish();
+    start = glfwGetTime();
+    for (int j = 0; j < N_LOADS; ++j)
+      LoadSliceMapFile(PATHS[i]);
+    glFinish();
+    double load_time = (glfwGetTime() - start) * 1000 / N_LOADS;
+    SliceMapFile file;
+    file.Open(PATHS[i]);
+    printf("%-16s %10.1f %10.2f %10.2f\n", NAMES[i], MB(file.GetFileSize()),
+           save_time, load_time);
+    file.Close();
+    remove(PATHS[i]);
+  }
+}
+
+// Writes a raw volume of bytes with the size of the slice map: a sphere made
+// of concentric shells, with a noisy value in each voxel
+void WriteBenchmarkVolume(const std::string& path) {
+  const int N = volume_resolution;
+  FILE *file = fopen(path.c_str(), "wb");
+  Assertf(file, "cannot create %s", path.c_str());
+  std::vector<unsigned char> slice(N * N);
+  float radius = 0.45f * N;
+  for (int z = 0; z < N; ++z) {
+    for (int y = 0; y < N; ++y) {
+      for (int x = 0; x < N; ++x) {
+        auto d = glm::length(glm::vec3(x, y, z) - N / 2.0f);
+        bool shell = d < radius && (int)d % 64 < 32;
+        slice[y * N + x] = shell ? 128 + ((x * 7 + y * 13 + z) & 127) :
+                                   (x ^ y ^ z) & 127;
+      }
+    }
+    fwrite(slice.data(), 1, slice.size(), file);
+  }
+  fclose(file);
+}
+
+// Measures how fast a raw volume with the size of the slice map is loaded
+// (read and packed in the slice map layout) and uploaded, against the
+// voxelization of the object
+void BenchmarkVolumeLoad(GLFWwindow *window) {
+  const int N_LOADS = 3;
+  const char *PATH = "benchmark.raw";
+  const int N = volume_resolution;
+  RenderFrame(window);
+
+  glFinish();
+  double start = glfwGetTime();
+  for (int i = 0; i < N_LOADS && !volume_scene; ++i) {
+    UpdateObjectMatrices(volume_projection *
+                         glm::inverse(view * object_model));
+    RenderSliceMap();
+  }
+  glFinish();
+  double voxelization_time = (glfwGetTime() - start) * 1000 / N_LOADS;
+
+  WriteBenchmarkVolume(PATH);
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  double load_time = 0, upload_time = 0;
+  glm::ivec3 offset;
+  for (int i = 0; i < N_LOADS; ++i) {
+    start = glfwGetTime();
+    try {
+      LoadRawVolume(PATH, glm::ivec3(N), 128, &cpu_volume, &offset);
+    } catch (std::exception &e) {
+      Assertf(false, "%s", e.what());
+    }
+    load_time += (glfwGetTime() - start) * 1000 / N_LOADS;
+    glFinish();
+    start = glfwGetTime();
+    cpu_volume.WriteToTextures(voxel_framebuffer.GetTextures());
+    glFinish();
+    upload_time += (glfwGetTime() - start) * 1000 / N_LOADS;
+  }
+  remove(PATH);
+  slice_map_mvp = glm::mat4(0);
+
+  double GB = (double)N * N * N / (1024 * 1024 * 1024);
+  printf("raw volume %d^3 (%.2f GB), %zu active voxels\n", N, GB,
+         cpu_volume.CountActive());
+  printf("%-16s %10s %10s\n", "slice map", "time (ms)", "GB/s");
+  if (!volume_scene)
+    printf("%-16s %10.2f %10s\n", "voxelization", voxelization_time, "-");
+  printf("%-16s %10.2f %10.2f\n", "load and pack", load_time,
+         GB / (load_time / 1000));
+  printf("%-16s %10.2f %10s\n", "upload", upload_time, "-");
+}
+
+// Measures the size of the sparse voxel DAG of the fitted volume and how
+// fast it expands back into the slice map
+void BenchmarkSparseVoxelDAG(GLFWwindow *window) {
+  const int N_DECODES = 10;
+  RenderFrame(window);
+  ReadFittedVolume();
+  std::vector<uint32_t> original(cpu_volume.GetData(),
+                                 cpu_volume.GetData() +
+                                     cpu_volume.GetSize() / sizeof(uint32_t));
+  SparseVoxelDAG dag;
+  double start = glfwGetTime();
+  dag.Build(cpu_volume);
+  double build_time = (glfwGetTime() - start) * 1000;
+  PrintSparseVoxelDAGMemory(dag);
+  printf("build: %.2f ms\n\n", build_time);
+
+  start = glfwGetTime();
+  for (int i = 0; i < N_DECODES; ++i)
+    dag.Decode(&cpu_volume);
+  double decode_time = (glfwGetTime() - start) * 1000 / N_DECODES;
+  glFinish();
+  start = glfwGetTime();
+  cpu_volume.WriteToTextures(voxel_framebuffer.GetTextures());
+  glFinish();
+  double upload_time = (glfwGetTime() - start) * 1000;
+  bool equal = memcmp(original.data(), cpu_volume.GetData(),
+                      cpu_volume.GetSize()) == 0;
+  printf("decode: %.2f ms (%.2f GB/s), upload: %.2f ms, lossless: %s\n",
+         decode_time, cpu_volume.GetSize() / (decode_time * 1e6), upload_time,
+         equal ? "yes" : "no");
+}
+
+// Compares the voxel occupancy of the volume fitted to the bounding sphere
+// and to the oriented bounding box
+void BenchmarkBounds(GLFWwindow *window) {
+  if (cpu_volume.GetResolution() != volume_resolution)
+    cpu_volume.Init(volume_resolution);
+  double n_voxels = pow(volume_resolution, 3);
+  printf("%-22s %12s %16s %12s\n", "volume fit", "voxel size",
+         "active voxels", "utilization");
+  for (int i = 0; i < FIT_MODE_NUMBER; ++i) {
+    fit_mode = (FitMode)i;
+    RenderFrame(window);
+    cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+    double n_active = cpu_volume.CountActive();
+    float voxel_size = 2 * scene_radius / volume_resolution;
+    if (fit_mode == FIT_ORIENTED_BOX)
+      GetFittedResolution(&voxel_size);
+    printf("%-22s %12.5f %16.0f %11.2f%%\n", FIT_MODE_NAMES[i], voxel_size,
+           n_active, 100 * n_active / n_voxels);
+  }
+}
+
+// Compares the memory and the lighting cost of the dense and of the
+// bricked slice map
+void BenchmarkBricks(GLFWwindow *window) {
+  const int N_BUILDS = 3;
+  use_bricks = true;
+  RenderFrame(window);
+  double start = glfwGetTime();
+  for (int i = 0; i < N_BUILDS; ++i)
+    BuildBricks();
+  double build_time = (glfwGetTime() - start) * 1000 / N_BUILDS;
+  PrintBricksMemory();
+  printf("build (readback included): %.2f ms\n\n", build_time);
+  printf("%-12s %14s %16s\n", "slice map", "lighting (ms)",
+         "steps per pixel");
+  for (int i = 0; i < 2; ++i) {
+    use_bricks = i == 1;
+    double lighting_time, steps_per_pixel;
+    MeasureLighting(window, &lighting_time, &steps_per_pixel);
+    printf("%-12s %14.2f %16.1f\n", use_bricks ? "bricked" : "dense",
+           lighting_time, steps_per_pixel);
+  }
+}
+
+// Voxelizes the object in the fitted volume and saves its proxy mesh as an
+// OBJ file, in object space
+void ExportProxyMesh(const std::string& path) {
+  ReadFittedVolume();
+  double extraction_time = ExtractProxyMesh(volume_projection);
+  try {
+    proxy_mesh.SaveObj(path);
+  } catch (std::exception &e) {
+    Assertf(false, "%s", e.what());
+  }
+  proxy_mesh_outdated = true;
+  PrintProxyMeshReport(extraction_time);
+}
+
+// Measures the greedy mesher on the fitted volume (extraction time and
+// triangles) and the geometry pass of the proxy mesh against the scene
+void BenchmarkProxyMesh(GLFWwindow *window) {
+  const int N_BUILDS = 3;
+  const int N_FRAMES = 100;
+  RenderFrame(window);
+  ReadFittedVolume();
+  double extraction_time = 0;
+  for (int i = 0; i < N_BUILDS; ++i)
+    extraction_time += ExtractProxyMesh(volume_projection) / N_BUILDS;
+  PrintProxyMeshReport(extraction_time);
+
+  printf("\n%-12s %18s\n", "geometry", "geometry pass (ms)");
+  for (int i = 0; i < 2; ++i) {
+    use_proxy_mesh = i == 1;
+    RenderFrame(window);
+    glFinish();
+    double start = glfwGetTime();
+    for (int j = 0; j < N_FRAMES; ++j)
+      RenderGeometry();
+    glFinish();
+    double geometry_time = (glfwGetTime() - start) * 1000 / N_FRAMES;
+    printf("%-12s %18.3f\n", use_proxy_mesh ? "proxy mesh" : "scene",
+           geometry_time);
+  }
+  use_proxy_mesh = false;
+}
+
+// Measures how the cpu copy of the fitted volume is filled (synchronous and
+// asynchronous readbacks, cpu voxelization) and the throughput of the
+// occupancy queries, in millions per second
+void BenchmarkOccupancyQueries(GLFWwindow *window) {
+  const int N_QUERIES = 1 << 20;
+  const int N_RUNS = 3;
+  const int CHUNK = 4096;
+  RenderFrame(window);
+  ReadFittedVolume();
+  printf("%-24s %12s %8s\n", "fill", "time (ms)", "frames");
+
+  glFinish();
+  double start = glfwGetTime();
+  cpu_volume.ReadFromTextures(voxel_framebuffer.GetTextures());
+  printf("%-24s %12.2f %8s\n", "readback", (glfwGetTime() - start) * 1000,
+         "-");
+
+  // The frames keep rendering while the copy is in flight; the blocking
+  // time is only the one spent in Start and Finish
+  start = glfwGetTime();
+  double blocking_time = 0;
+  int frames = 0;
+  double call_start = glfwGetTime();
+  query_readback.Start(voxel_framebuffer.GetTextures(), volume_resolution);
+  blocking_time += glfwGetTime() - call_start;
+  while (true) {
+    call_start = glfwGetTime();
+    bool ready = query_readback.Finish(&query_volume);
+    blocking_time += glfwGetTime() - call_start;
+    if (ready)
+      break;
+    RenderFrame(window);
+    frames++;
+  }
+  printf("%-24s %12.2f %8d\n", "async readback (total)",
+         (glfwGetTime() - start) * 1000, frames);
+  printf("%-24s %12.2f %8s\n", "async readback (block)",
+         blocking_time * 1000, "-");
+
+  if (!volume_scene) {
+    start = glfwGetTime();
+    cpu_voxelizer.Voxelize(volume_projection, instance_models, &query_volume);
+    double voxelization_time = (glfwGetTime() - start) * 1000;
+    size_t different = 0;
+    for (size_t i = 0; i < cpu_volume.GetSize() / sizeof(uint32_t); ++i) {
+      different += __builtin_popcount(cpu_volume.GetData()[i] ^
+                                      query_volume.GetData()[i]);
+    }
+    printf("%-24s %12.2f %8s (%.4f%% voxels differ from the gpu)\n",
+           "cpu voxelizer", voxelization_time, "-",
+           100.0 * different / std::max(cpu_volume.CountActive(), (size_t)1));
+  }
+
+  // Rays from a sphere around the volume to random points inside it
+  srand(1);
+  auto random = []() { return (float)rand() / (float)RAND_MAX; };
+  float n = volume_resolution;
+  std::vector<glm::vec3> points(N_QUERIES), origins(N_QUERIES),
+      dirs(N_QUERIES);
+  std::vector<float> max_distances(N_QUERIES, 2 * n);
+  std::vector<VoxelHit> hits(N_QUERIES);
+  for (int i = 0; i < N_QUERIES; ++i) {
+    points[i] = glm::vec3(random(), random(), random()) * n;
+    auto side = glm::normalize(glm::vec3(random(), random(), random()) -
+                               0.5f);
+    origins[i] = glm::vec3(n / 2) + side * n;
+    dirs[i] = glm::normalize(points[i] - origins[i]);
+  }
+
+  // Million queries per second of a batch of queries
+  auto Mqps = [&](const std::function<void()>& batch) {
+    double start = glfwGetTime();
+    for (int run = 0; run < N_RUNS; ++run)
+      batch();
+    return (double)N_QUERIES * N_RUNS / (glfwGetTime() - start) / 1e6;
+  };
+  int occupied = 0;
+  double point_rate = Mqps([&]() {
+    for (auto& p : points)
+      occupied += cpu_volume.Occupied(p);
+  });
+  double scalar_rate = Mqps([&]() {
+    for (int i = 0; i < N_QUERIES; ++i)
+      cpu_volume.Raycast(origins[i], dirs[i], max_distances[i], &hits[i]);
+  });
+  double packet_rate = Mqps([&]() {
+    cpu_volume.RaycastN(N_QUERIES, origins.data(), dirs.data(),
+                        max_distances.data(), hits.data());
+  });
+  double parallel_rate = Mqps([&]() {
+    ParallelFor(N_QUERIES / CHUNK, [&](int chunk) {
+      int first = chunk * CHUNK;
+      cpu_volume.RaycastN(CHUNK, origins.data() + first, dirs.data() + first,
+                          max_distances.data() + first, hits.data() + first);
+    });
+  });
+  int n_hits = 0;
+  for (auto& hit : hits)
+    n_hits += hit.hit;
+
+  int threads = GetNumberOfThreads();
+  printf("\n%d queries, %.1f%% points occupied, %.1f%% rays hit\n",
+         N_QUERIES, 100.0 * occupied / N_QUERIES / N_RUNS,
+         100.0 * n_hits / N_QUERIES);
+  printf("%-24s %18s\n", "query", "M/s per core");
+  printf("%-24s %18.2f\n", "Occupied", point_rate);
+  printf("%-24s %18.2f\n", "Raycast", scalar_rate);
+  printf("%-24s %18.2f\n", "RaycastN (packets of 4)", packet_rate);
+  printf("%-24s %18.2f (%.2f M/s on %d threads)\n", "RaycastN (threads)",
+         parallel_rate / threads, parallel_rate, threads);
+}
+
+// Compares the cost and the voxels of the parity and the surface
+// voxelizations of the fitted volume: the surface voxels the parity volume
+// also has, and the parity voxels off the surface (the filled inside)
+void BenchmarkSurfaceVoxelization(GLFWwindow *window) {
+  const int WARMUP_FRAMES = 2;
+  RenderFrame(window);
+  fit_mode = FIT_ORIENTED_BOX;
+  UpdateObjectMatrices(volume_projection * glm::inverse(view * object_model));
+  VoxelVolume volumes[VOXELIZATION_MODE_NUMBER];
+  printf("%-14s %10s %10s %15s\n", "voxelization", "mean (ms)", "max (ms)",
+         "active voxels");
+  for (int i = 0; i < VOXELIZATION_MODE_NUMBER; ++i) {
+    voxelization_mode = (VoxelizationMode)i;
+    for (int j = 0; j < WARMUP_FRAMES; ++j) {
+      voxelization_timer.Begin();
+      RenderSliceMap();
+      voxelization_timer.End();
+    }
+    double sum = 0, max_time = 0;
+    for (int j = 0; j < BENCHMARK_FRAMES; ++j) {
+      voxelization_timer.Begin();
+      RenderSliceMap();
+      voxelization_timer.End();
+      glFinish();
+      double time = voxelization_timer.GetElapsedTime();
+      sum += time;
+      max_time = std::max(max_time, time);
+    }
+    volumes[i].Init(volume_resolution);
+    volumes[i].ReadFromTextures(voxel_framebuffer.GetTextures());
+    printf("%-14s %10.3f %10.3f %15zu\n", VOXELIZATION_MODE_NAMES[i],
+           sum / BENCHMARK_FRAMES, max_time, volumes[i].CountActive());
+  }
+
+  auto& parity = volumes[VOXELIZATION_PARITY];
+  auto& surface = volumes[VOXELIZATION_SURFACE];
+  size_t shared = 0, inside = 0;
+  for (size_t i = 0; i < parity.GetSize() / sizeof(uint32_t); ++i) {
+    shared += __builtin_popcount(parity.GetData()[i] & surface.GetData()[i]);
+    inside += __builtin_popcount(parity.GetData()[i] & ~surface.GetData()[i]);
+  }
+  printf("\nsurface voxels in the parity volume: %.2f%%\n",
+         100.0 * shared / std::max(surface.CountActive(), (size_t)1));
+  printf("parity voxels off the surface: %zu\n", inside);
+  voxelization_mode = VOXELIZATION_PARITY;
+  slice_map_mvp = glm::mat4(0);
+}
+
+// Reads a channel of a floating point texture with the window size
+std::vector<float> ReadWindowTexture(unsigned int texture, int format) {
+  std::vector<float> values(window_w * window_h);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glGetTexImage(GL_TEXTURE_2D, 0, format, GL_FLOAT, values.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return values;
+}
+
+// Reads the ambient occlusion of the last frame, at the window resolution
+std::vector<float> ReadOcclusion() {
+  return ReadWindowTexture(GetOcclusion(), GL_RED);
+}
+
+// Differences between two ambient occlusion images over the pixels of the
+// scene: mean, maximum and mean squared absolute error, the PSNR (dB, for a
+// peak of 1, infinite for equal images), and the fraction of the pixels
+// whose error is above OCCLUSION_OUTLIER_ERROR
+struct OcclusionError {
+  double mean;
+  double max;
+  double mse;
+  double psnr;
+  double outliers;
+};
+const double OCCLUSION_OUTLIER_ERROR = 0.1;
+
+// Compares two ambient occlusion images of the last frame
+OcclusionError CompareOcclusion(const std::vector<float>& occlusion,
+                                const std::vector<float>& reference) {
+  auto material = ReadWindowTexture(geom_framebuffer.GetTextures()[2],
+                                    GL_RED);
+  OcclusionError result = {0, 0, 0, 0, 0};
+  double n_pixels = 0;
+  for (size_t i = 0; i < occlusion.size(); ++i) {
+    if (material[i] == 0)
+      continue;
+    double error = fabs(occlusion[i] - reference[i]);
+    result.mean += error;
+    result.mse += error * error;
+    result.max = std::max(result.max, error);
+    result.outliers += error > OCCLUSION_OUTLIER_ERROR;
+    n_pixels++;
+  }
+  n_pixels = std::max(n_pixels, 1.0);
+  result.mean /= n_pixels;
+  result.mse /= n_pixels;
+  result.psnr = result.mse > 0 ? 10 * log10(1 / result.mse) : INFINITY;
+  result.outliers /= n_pixels;
+  return result;
+}
+
+// Renders the benchmark frames and obtains the average gpu time (ms) of the
+// ambient occlusion pass
+double MeasureOcclusionTime(GLFWwindow *window) {
+  double time = 0;
+  for (int i = 0; i < BENCHMARK_FRAMES; ++i) {
+    RenderFrame(window);
+    glfwSwapBuffers(window);
+    glFinish();
+    time += occlusion_timer.GetElapsedTime() / BENCHMARK_FRAMES;
+  }
+  return time;
+}
+
+// Compares the ambient occlusion traced at full, half and quarter
+// resolution: the cost of the occlusion pass (with the upsampling), and the
+// error of the upsampled occlusion against the full resolution one over the
+// pixels of the scene (mean and maximum absolute error and PSNR)
+void BenchmarkOcclusionResolution(GLFWwindow *window) {
+  const int SCALES[] = {1, 2, 4};
+  const char *NAMES[] = {"full", "half", "quarter"};
+  int scale = occlusion_scale;
+  std::vector<float> reference;
+  double full_time = 0;
+  printf("%-12s %15s %9s %11s %10s %10s\n", "resolution", "occlusion (ms)",
+         "speedup", "mean error", "max error", "psnr (db)");
+  for (int i = 0; i < 3; ++i) {
+    SetOcclusionScale(SCALES[i]);
+    RenderFrame(window);
+    double time = MeasureOcclusionTime(window);
+    auto occlusion = ReadOcclusion();
+    if (i == 0) {
+      reference = occlusion;
+      full_time = time;
+    }
+    auto error = CompareOcclusion(occlusion, reference);
+    printf("%-12s %15.3f %8.2fx %11.4f %10.4f %10.2f\n", NAMES[i], time,
+           full_time / time, error.mean, error.max, error.psnr);
+  }
+  SetOcclusionScale(scale);
+}
+
+// Compares the temporal accumulation of the ambient occlusion with tracing
+// every ray each frame: the cost of the occlusion pass, the error of the
+// first frames after the history is reset and the frames until it stays
+// below CONVERGED_ERROR (convergence), and the error left by the history
+// after the object rotates for a while, against the occlusion of the same
+// pose traced from scratch (ghosting)
+void BenchmarkTemporalOcclusion(GLFWwindow *window) {
+  const int RAYS[] = {8, 4};
+  const int N_FRAMES = 64;
+  const int ROTATION_FRAMES = 60;
+  const double CONVERGED_ERROR = 0.01;
+  temporal_occlusion = false;
+  object_rotation = false;
+  double full_time = MeasureOcclusionTime(window);
+  auto reference = ReadOcclusion();
+  printf("%-10s %15s %9s %9s %9s %10s %9s %12s\n", "rays", "occlusion (ms)",
+         "frame 1", "frame 4", "frame 16", "converged", "ghosting",
+         "ghost pixels");
+  printf("%-10d %15.3f %9.4f %9.4f %9.4f %10d %9s %12s\n", n_rays, full_time,
+         0.0, 0.0, 0.0, 1, "-", "-");
+  for (int i = 0; i < (int)(sizeof(RAYS) / sizeof(RAYS[0])); ++i) {
+    temporal_occlusion = true;
+    temporal_rays = RAYS[i];
+    double time = MeasureOcclusionTime(window);
+
+    occlusion_history_valid = false;
+    std::vector<double> errors;
+    int converged = 0;
+    for (int j = 0; j < N_FRAMES; ++j) {
+      RenderFrame(window);
+      glfwSwapBuffers(window);
+      errors.push_back(CompareOcclusion(ReadOcclusion(), reference).mean);
+      if (errors.back() >= CONVERGED_ERROR)
+        converged = j + 2;
+    }
+
+    object_rotation = true;
+    for (int j = 0; j < ROTATION_FRAMES; ++j) {
+      RenderFrame(window);
+      glfwSwapBuffers(window);
+    }
+    object_rotation = false;
+    auto accumulated = ReadOcclusion();
+    temporal_occlusion = false;
+    RenderFrame(window);
+    auto ghosting = CompareOcclusion(accumulated, ReadOcclusion());
+
+    auto converged_name = converged > N_FRAMES ? std::string("never") :
+                          std::to_string(std::max(converged, 1));
+    printf("%-10d %15.3f %9.4f %9.4f %9.4f %10s %9.4f %11.2f%%\n", RAYS[i],
+           time, errors[0], errors[3], errors[15], converged_name.c_str(),
+           ghosting.mean, 100 * ghosting.outliers);
+  }
+  temporal_occlusion = false;
+}
+
+// Ray set settings, saved and restored by the benchmarks that change them
+struct RaySettings {
+  int n_rays;
+  RaySet ray_set;
+  bool use_rotation_noise;
+};
+
+RaySettings GetRaySettings() {
+  return {n_rays, ray_set, use_rotation_noise};
+}
+
+void SetRaySettings(const RaySettings& settings) {
+  n_rays = settings.n_rays;
+  ray_set = settings.ray_set;
+  use_rotation_noise = settings.use_rotation_noise;
+  CreateRays();
+}
+
+// Renders the reference occlusion of the benchmarks, traced with 256 cosine
+// weighted Hammersley rays without the rotation, and restores the ray set
+std::vector<float> RenderReferenceOcclusion(GLFWwindow *window) {
+  const int REFERENCE_RAYS = 256;
+  auto settings = GetRaySettings();
+  SetRaySettings({REFERENCE_RAYS, RAY_SET_HAMMERSLEY, false});
+  RenderFrame(window);
+  auto reference = ReadOcclusion();
+  SetRaySettings(settings);
+  return reference;
+}
+
+// Compares the ray sets against the reference occlusion: the cost and the
+// error of each set, with and without the blue noise rotation, for several
+// numbers of rays. The occlusion is traced at full resolution, without
+// temporal accumulation
+void BenchmarkRaySets(GLFWwindow *window) {
+  const int RAYS[] = {8, 16, 32};
+  int scale = occlusion_scale;
+  auto settings = GetRaySettings();
+  temporal_occlusion = false;
+  SetOcclusionScale(1);
+  auto reference = RenderReferenceOcclusion(window);
+
+  printf("%-12s %10s %6s %15s %11s %10s\n", "ray set", "rotation", "rays",
+         "occlusion (ms)", "mean error", "psnr (db)");
+  for (int i = 0; i < RAY_SET_NUMBER; ++i) {
+    for (int noise = 0; noise < 2; ++noise) {
+      for (int j = 0; j < (int)(sizeof(RAYS) / sizeof(RAYS[0])); ++j) {
+        SetRaySettings({RAYS[j], (RaySet)i, noise != 0});
+        double time = MeasureOcclusionTime(window);
+        auto error = CompareOcclusion(ReadOcclusion(), reference);
+        printf("%-12s %10s %6d %15.3f %11.4f %10.2f\n", RAY_SET_NAMES[i],
+               noise ? "blue noise" : "none", n_rays, time, error.mean,
+               error.psnr);
+      }
+    }
+  }
+  SetRaySettings(settings);
+  SetOcclusionScale(scale);
+}
+
+// Compares the interleaved sampling against the reference occlusion: the
+// cost, the cost per traced ray (which falls with the cache misses of the
+// traversal) and the error of tracing every ray in each pixel, of the
+// interleaved sampling, and of tracing as many rays as the interleaved
+// sampling in each pixel, with the blue noise rotation
+void BenchmarkInterleavedOcclusion(GLFWwindow *window) {
+  const int RAYS[] = {32, 64};
+  const int SUBSETS = interleave_size * interleave_size;
+  const char *NAMES[] = {"every ray", "interleaved", "rotated"};
+  auto settings = GetRaySettings();
+  bool interleaved_used = interleaved_occlusion;
+  temporal_occlusion = false;
+  interleaved_occlusion = false;
+  auto reference = RenderReferenceOcclusion(window);
+  double traced_pixels = occlusion_framebuffer.GetWidth() *
+                         occlusion_framebuffer.GetHeight();
+
+  printf("%-12s %6s %14s %15s %11s %11s %10s\n", "sampling", "rays",
+         "rays / pixel", "occlusion (ms)", "ns / ray", "mean error",
+         "psnr (db)");
+  for (int i = 0; i < (int)(sizeof(RAYS) / sizeof(RAYS[0])); ++i) {
+    for (int j = 0; j < 3; ++j) {
+      interleaved_occlusion = j == 1;
+      SetRaySettings({j == 2 ? RAYS[i] / SUBSETS : RAYS[i], settings.ray_set,
+                      j != 1});
+      double time = MeasureOcclusionTime(window);
+      auto error = CompareOcclusion(ReadOcclusion(), reference);
+      int traced_rays = GetTracedRays();
+      printf("%-12s %6d %14d %15.3f %11.3f %11.4f %10.2f\n", NAMES[j],
+             n_rays, traced_rays, time,
+             time * 1e6 / (traced_pixels * traced_rays), error.mean,
+             error.psnr);
+    }
+  }
+  interleaved_occlusion = interleaved_used;
+  SetRaySettings(settings);
+}
+
+// Compares the iterations of the denoiser against the reference occlusion:
+// the cost of the occlusion pass with each number of iterations (and of the
+// iterations alone) and the error, with 4, 8 and 32 rays per pixel and the
+// blue noise rotation
+void BenchmarkDenoiser(GLFWwindow *window) {
+  const int RAYS[] = {4, 8, 32};
+  auto settings = GetRaySettings();
+  int iterations_used = denoise_iterations;
+  temporal_occlusion = false;
+  interleaved_occlusion = false;
+  denoise_iterations = 0;
+  auto reference = RenderReferenceOcclusion(window);
+
+  printf("%-6s %11s %15s %13s %11s %10s\n", "rays", "iterations",
+         "occlusion (ms)", "denoise (ms)", "mean error", "psnr (db)");
+  for (int i = 0; i < (int)(sizeof(RAYS) / sizeof(RAYS[0])); ++i) {
+    SetRaySettings({RAYS[i], settings.ray_set, true});
+    double trace_time = 0;
+    for (int j = 0; j <= max_denoise_iterations; ++j) {
+      denoise_iterations = j;
+      double time = MeasureOcclusionTime(window);
+      if (j == 0)
+        trace_time = time;
+      auto error = CompareOcclusion(ReadOcclusion(), reference);
+      printf("%-6d %11d %15.3f %13.3f %11.4f %10.2f\n", n_rays, j, time,
+             time - trace_time, error.mean, error.psnr);
+    }
+  }
+  denoise_iterations = iterations_used;
+  SetRaySettings(settings);
+}
+
+// Compares the adaptive sampling with tracing a fixed number of rays,
+// against the reference occlusion: the cost, the mean rays traced per pixel
+// of the scene and the error, with every ray and with several error
+// thresholds of the adaptive sampling
+void BenchmarkAdaptiveSampling(GLFWwindow *window) {
+  const int RAYS[] = {8, 16, 32};
+  const float ERRORS[] = {0.01f, 0.02f, 0.04f};
+  auto settings = GetRaySettings();
+  bool adaptive_used = adaptive_occlusion;
+  float error_used = adaptive_error;
+  temporal_occlusion = false;
+  interleaved_occlusion = false;
+  adaptive_occlusion = false;
+  auto reference = RenderReferenceOcclusion(window);
+  auto material = ReadWindowTexture(geom_framebuffer.GetTextures()[2],
+                                    GL_RED);
+
+  printf("%-10s %6s %10s %15s %14s %11s %10s\n", "sampling", "rays",
+         "threshold", "occlusion (ms)", "rays / pixel", "mean error",
+         "psnr (db)");
+  int n_fixed = sizeof(RAYS) / sizeof(RAYS[0]);
+  int n_errors = sizeof(ERRORS) / sizeof(ERRORS[0]);
+  for (int i = 0; i < n_fixed + n_errors; ++i) {
+    adaptive_occlusion = i >= n_fixed;
+    if (adaptive_occlusion)
+      adaptive_error = ERRORS[i - n_fixed];
+    SetRaySettings({adaptive_occlusion ? RAYS[n_fixed - 1] : RAYS[i],
+                    RAY_SET_SOBOL, true});
+    double time = MeasureOcclusionTime(window);
+    auto error = CompareOcclusion(ReadOcclusion(), reference);
+    auto traced = ReadWindowTexture(GetOcclusion(), GL_ALPHA);
+    double total_rays = 0, n_pixels = 0;
+    for (size_t j = 0; j < traced.size(); ++j) {
+      if (material[j] == 0)
+        continue;
+      total_rays += traced[j];
+      n_pixels++;
+    }
+    auto threshold = adaptive_occlusion ?
+        std::to_string(adaptive_error).substr(0, 4) : std::string("-");
+    printf("%-10s %6d %10s %15.3f %14.2f %11.4f %10.2f\n",
+           adaptive_occlusion ? "adaptive" : "fixed", n_rays,
+           threshold.c_str(), time, total_rays / std::max(n_pixels, 1.0),
+           error.mean, error.psnr);
+  }
+  adaptive_occlusion = adaptive_used;
+  adaptive_error = error_used;
+  SetRaySettings(settings);
+}
+
+// Measures the progressive refinement of a static view against the
+// reference occlusion: the cost of the occlusion pass and the error after
+// each power of 2 batches, and the cost of the occlusion pass once it
+// converged
+void BenchmarkProgressiveRefinement(GLFWwindow *window) {
+  bool progressive_used = progressive_occlusion;
+  temporal_occlusion = false;
+  interleaved_occlusion = false;
+  progressive_occlusion = false;
+  object_rotation = false;
+  light_rotation = false;
+  auto reference = RenderReferenceOcclusion(window);
+
+  progressive_occlusion = true;
+  occlusion_history_valid = false;
+  printf("%-8s %6s %15s %11s %10s\n", "batches", "rays", "occlusion (ms)",
+         "mean error", "psnr (db)");
+  double time = 0;
+  for (int i = 1; i <= progressive_batches; ++i) {
+    RenderFrame(window);
+    glfwSwapBuffers(window);
+    glFinish();
+    time += occlusion_timer.GetElapsedTime();
+    if ((i & (i - 1)) != 0 && i != progressive_batches)
+      continue;
+    auto error = CompareOcclusion(ReadOcclusion(), reference);
+    printf("%-8d %6d %15.3f %11.4f %10.2f\n", i, i * n_rays, time / i,
+           error.mean, error.psnr);
+  }
+  printf("\nconverged: %s, occlusion pass %.3f ms\n",
+         IsOcclusionConverged(window) ? "yes" : "no",
+         MeasureOcclusionTime(window));
+  progressive_occlusion = progressive_used;
+}
+
+// Measures the world space occlusion cache: the time (ms) of a full update
+// and of an update where no cell changed, and the cost of the occlusion pass
+// and the error against tracing every ray in each pixel, sampling the cache
+// with and without the detail rays
+void BenchmarkOcclusionCache(GLFWwindow *window) {
+  bool cache_used = use_occlusion_cache;
+  bool detail_used = use_detail_rays;
+  temporal_occlusion = false;
+  interleaved_occlusion = false;
+  progressive_occlusion = false;
+  object_rotation = false;
+  use_occlusion_cache = false;
+  double trace_time = MeasureOcclusionTime(window);
+  auto reference = ReadOcclusion();
+
+  use_occlusion_cache = true;
+  RenderFrame(window);
+  auto MeasureUpdate = []() {
+    glFinish();
+    double start = glfwGetTime();
+    UpdateOcclusionCache();
+    glFinish();
+    return (glfwGetTime() - start) * 1000;
+  };
+  ResetOcclusionCache();
+  double full_update = MeasureUpdate();
+  double static_update = MeasureUpdate();
+  printf("cache: %d^3 cells, full update %.3f ms, static update %.3f ms\n\n",
+         occlusion_cache_resolution, full_update, static_update);
+
+  printf("%-14s %15s %11s %10s\n", "occlusion", "occlusion (ms)",
+         "mean error", "psnr (db)");
+  printf("%-14s %15.3f %11.4f %10.2f\n", "traced", trace_time, 0.0,
+         INFINITY);
+  for (int detail = 0; detail < 2; ++detail) {
+    use_detail_rays = detail;
+    double time = MeasureOcclusionTime(window);
+    auto error = CompareOcclusion(ReadOcclusion(), reference);
+    printf("%-14s %15.3f %11.4f %10.2f\n",
+           detail ? "cache + detail" : "cache", time, error.mean, error.psnr);
+  }
+  use_occlusion_cache = cache_used;
+  use_detail_rays = detail_used;
+}
+
+// Measures how the lightmap bake scales with the cpu cores: the texels
+// baked per second with 1, 2, 4... threads and the speedup over a single
+// thread (the object needs texture coordinates, see --object=)
+void BenchmarkLightmap(GLFWwindow *window) {
+  RenderFrame(window);
+  VoxelizeBakedObject();
+  Lightmap target;
+  RasterizeLightmap(&target);
+  OcclusionBaker baker;
+  InitOcclusionBaker(&baker);
+  int n_texels = target.CountCoveredTexels();
+  printf("lightmap: %dx%d, %d texels, %d rays\n\n", lightmap_size,
+         lightmap_size, n_texels, n_rays);
+
+  printf("%-8s %12s %14s %8s\n", "threads", "bake (ms)", "texels/s",
+         "speedup");
+  int max_threads = GetNumberOfThreads();
+  double single_time = 0;
+  for (int threads = 1;; threads = std::min(2 * threads, max_threads)) {
+    SetNumberOfThreads(threads);
+    double start = glfwGetTime();
+    target.Bake(cpu_volume, baker);
+    double time = glfwGetTime() - start;
+    if (threads == 1)
+      single_time = time;
+    printf("%-8d %12.2f %14.0f %7.2fx\n", threads, time * 1000,
+           n_texels / time, single_time / time);
+    if (threads == max_threads)
+      break;
+  }
+  SetNumberOfThreads(0);
+}
+
+// Runs a benchmark and prints the results in the terminal
+void RunBenchmark(GLFWwindow *window, const std::string& name) {
+  if (name == "distance-field")
+    BenchmarkDistanceField(window);
+  else if (name == "svo")
+    BenchmarkSparseVoxelOctree(window);
+  else if (name == "cone-tracing")
+    BenchmarkConeTracing(window);
+  else if (name == "clipmap")
+    BenchmarkClipmap(window);
+  else if (name == "bounds")
+    BenchmarkBounds(window);
+  else if (name == "slicemap")
+    BenchmarkSliceMapFile(window);
+  else if (name == "bricks")
+    BenchmarkBricks(window);
+  else if (name == "svdag")
+    BenchmarkSparseVoxelDAG(window);
+  else if (name == "amortization")
+    BenchmarkAmortizedVoxelization(window);
+  else if (name == "object-volumes")
+    BenchmarkObjectVolumes(window);
+  else if (name == "volume-load")
+    BenchmarkVolumeLoad(window);
+  else if (name == "greedy-mesh")
+    BenchmarkProxyMesh(window);
+  else if (name == "queries")
+    BenchmarkOccupancyQueries(window);
+  else if (name == "surface-voxelization")
+    BenchmarkSurfaceVoxelization(window);
+  else if (name == "ao-resolution")
+    BenchmarkOcclusionResolution(window);
+  else if (name == "temporal")
+    BenchmarkTemporalOcclusion(window);
+  else if (name == "ray-sets")
+    BenchmarkRaySets(window);
+  else if (name == "interleaved")
+    BenchmarkInterleavedOcclusion(window);
+  else if (name == "denoiser")
+    BenchmarkDenoiser(window);
+  else if (name == "adaptive")
+    BenchmarkAdaptiveSampling(window);
+  else if (name == "progressive")
+    BenchmarkProgressiveRefinement(window);
+  else if (name == "occlusion-cache")
+    BenchmarkOcclusionCache(window);
+  else if (name == "lightmap")
+    BenchmarkLightmap(window);
+  else
+    Assertf(false, "unknown benchmark: %s", name.c_str());
+}
+
 // Main function
 int main(int argc, char *argv[]) {
   auto window = InitGLFW(argc, argv);
   InitGLEW();
+  auto svo_resolution_arg = GetArgument(argc, argv, "--svo-resolution=");
+  if (svo_resolution_arg)
+    svo_resolution = atoi(svo_resolution_arg);
+  Assertf(svo_resolution >= volume_resolution &&
+          (svo_resolution & (svo_resolution - 1)) == 0,
+          "invalid octree resolution: %d", svo_resolution);
+  auto instances_arg = GetArgument(argc, argv, "--instances=");
+  if (instances_arg) {
+    n_instances = atoi(instances_arg);
+    n_dynamic_instances = n_instances > 1 ? 1 : 0;
+  }
+  auto dynamic_arg = GetArgument(argc, argv, "--dynamic-instances=");
+  if (dynamic_arg)
+    n_dynamic_instances = atoi(dynamic_arg);
+  Assertf(n_instances > 0 && n_instances <= max_instances,
+          "invalid number of instances: %d", n_instances);
+  Assertf(n_dynamic_instances >= 0 && n_dynamic_instances <= n_instances &&
+          n_dynamic_instances <= max_dynamic_instances,
+          "invalid number of dynamic instances: %d", n_dynamic_instances);
+  auto amortization_arg = GetArgument(argc, argv, "--amortization-frames=");
+  if (amortization_arg) {
+    amortization_frames = atoi(amortization_arg);
+    amortized_voxelization = true;
+  }
+  Assertf(amortization_frames > 0 &&
+          n_volume_buffers % amortization_frames == 0,
+          "invalid amortization frames: %d", amortization_frames);
+  auto staleness_arg = GetArgument(argc, argv, "--max-staleness=");
+  if (staleness_arg)
+    max_staleness = atoi(staleness_arg);
+  auto motion_arg = GetArgument(argc, argv, "--max-motion=");
+  if (motion_arg)
+    max_motion = atof(motion_arg);
+  auto volume_arg = GetArgument(argc, argv, "--load-volume=");
+  if (volume_arg) {
+    volume_scene = true;
+    volume_path = volume_arg;
+    Assert(n_instances == 1, "volumetric scenes have a single instance");
+  }
+  auto volume_size_arg = GetArgument(argc, argv, "--volume-size=");
+  if (volume_size_arg) {
+    int n = sscanf(volume_size_arg, "%dx%dx%d", &raw_volume_size.x,
+                   &raw_volume_size.y, &raw_volume_size.z);
+    Assertf(n == 3, "invalid volume size: %s", volume_size_arg);
+  }
+  if (volume_scene && !IsVoxFile(volume_path))
+    Assert(raw_volume_size.x > 0 && raw_volume_size.y > 0 &&
+           raw_volume_size.z > 0,
+           "raw volumes need a positive --volume-size=<x>x<y>x<z>");
+  auto threshold_arg = GetArgument(argc, argv, "--volume-threshold=");
+  if (threshold_arg)
+    raw_volume_threshold = atoi(threshold_arg);
+  auto object_arg = GetArgument(argc, argv, "--object=");
+  if (object_arg)
+    object_path = object_arg;
+  baked_occlusion_path = GetArgument(argc, argv, "--baked-ao=");
+  if (baked_occlusion_path) {
+    Assert(!volume_scene, "volumetric scenes have no baked occlusion");
+    use_baked_occlusion = true;
+  }
+  lightmap_path = GetArgument(argc, argv, "--lightmap=");
+  if (lightmap_path) {
+    Assert(!volume_scene, "volumetric scenes have no lightmap");
+    use_baked_occlusion = true;
+  }
+  auto lightmap_size_arg = GetArgument(argc, argv, "--lightmap-size=");
+  if (lightmap_size_arg)
+    lightmap_size = atoi(lightmap_size_arg);
+  Assertf(lightmap_size > 0 && lightmap_size <= 16384,
+          "invalid lightmap size: %d", lightmap_size);
+  use_cpu_voxelizer = GetArgument(argc, argv, "--cpu-voxelizer") != nullptr;
+  if (GetArgument(argc, argv, "--surface-voxelization"))
+    voxelization_mode = VOXELIZATION_SURFACE;
+  auto ao_scale_arg = GetArgument(argc, argv, "--ao-scale=");
+  if (ao_scale_arg)
+    occlusion_scale = atoi(ao_scale_arg);
+  Assertf(occlusion_scale == 1 || occlusion_scale == 2 || occlusion_scale == 4,
+          "invalid ambient occlusion scale: %d", occlusion_scale);
+  auto rays_arg = GetArgument(argc, argv, "--rays=");
+  if (rays_arg)
+    n_rays = atoi(rays_arg);
+  Assertf(n_rays > 0 && n_rays <= 256, "invalid number of rays: %d", n_rays);
+  auto ray_set_arg = GetArgument(argc, argv, "--ray-set=");
+  if (ray_set_arg) {
+    int i = 0;
+    while (i < RAY_SET_NUMBER && strcmp(ray_set_arg, RAY_SET_NAMES[i]) != 0)
+      i++;
+    Assertf(i < RAY_SET_NUMBER, "invalid ray set: %s", ray_set_arg);
+    ray_set = (RaySet)i;
+  }
+  auto ray_seed_arg = GetArgument(argc, argv, "--ray-seed=");
+  if (ray_seed_arg)
+    ray_seed = strtoul(ray_seed_arg, nullptr, 10);
+  if (GetArgument(argc, argv, "--no-rotation-noise"))
+    use_rotation_noise = false;
+  auto temporal_arg = GetArgument(argc, argv, "--temporal-rays=");
+  if (temporal_arg) {
+    temporal_rays = atoi(temporal_arg);
+    temporal_occlusion = true;
+  }
+  Assertf(temporal_rays > 0 && n_rays % temporal_rays == 0,
+          "invalid temporal rays: %d", temporal_rays);
+  if (GetArgument(argc, argv, "--occlusion-cache"))
+    use_occlusion_cache = true;
+  if (GetArgument(argc, argv, "--detail-rays"))
+    use_detail_rays = true;
+  auto progressive_arg = GetArgument(argc, argv, "--progressive=");
+  if (progressive_arg) {
+    progressive_batches = atoi(progressive_arg);
+    progressive_occlusion = true;
+  }
+  Assertf(progressive_batches > 0, "invalid progressive batches: %d",
+          progressive_batches);
+  auto adaptive_arg = GetArgument(argc, argv, "--adaptive-error=");
+  if (adaptive_arg) {
+    adaptive_error = atof(adaptive_arg);
+    adaptive_occlusion = true;
+  }
+  Assertf(adaptive_error > 0, "invalid adaptive error: %f", adaptive_error);
+  auto denoise_arg = GetArgument(argc, argv, "--denoise=");
+  if (denoise_arg)
+    denoise_iterations = atoi(denoise_arg);
+  Assertf(denoise_iterations >= 0 &&
+          denoise_iterations <= max_denoise_iterations,
+          "invalid denoiser iterations: %d", denoise_iterations);
+  if (GetArgument(argc, argv, "--interleaved")) {
+    Assertf(n_rays % (interleave_size * interleave_size) == 0,
+            "interleaved sampling needs a multiple of %d rays",
+            interleave_size * interleave_size);
+    interleaved_occlusion = true;
+  }
   InitApplication();
-  MainLoop(window);
+  auto save_path = GetArgument(argc, argv, "--save-slicemap=");
+  if (save_path) {
+    auto compression = GetArgument(argc, argv, "--slicemap-compression=");
+    bool zlib = compression && strcmp(compression, "zlib") == 0;
+    SaveSliceMap(save_path, zlib ? SliceMapFile::COMPRESSION_ZLIB :
+                                   SliceMapFile::COMPRESSION_NONE);
+  }
+  auto load_path = GetArgument(argc, argv, "--load-slicemap=");
+  if (load_path)
+    LoadSliceMapFile(load_path);
+  auto export_dag_path = GetArgument(argc, argv, "--export-svdag=");
+  if (export_dag_path)
+    SaveSparseVoxelDAG(export_dag_path);
+  auto load_dag_path = GetArgument(argc, argv, "--load-svdag=");
+  if (load_dag_path)
+    LoadSparseVoxelDAG(load_dag_path);
+  auto export_mesh_path = GetArgument(argc, argv, "--export-mesh=");
+  if (export_mesh_path)
+    ExportProxyMesh(export_mesh_path);
+  auto bake_path = GetArgument(argc, argv, "--bake-ao=");
+  auto bake_lightmap_path = GetArgument(argc, argv, "--bake-lightmap=");
+  auto benchmark = GetArgument(argc, argv, "--benchmark=");
+  if (bake_path)
+    BakeVertexOcclusion(bake_path);
+  else if (bake_lightmap_path)
+    BakeLightmap(bake_lightmap_path);
+  else if (benchmark)
+    RunBenchmark(window, benchmark);
+  else
+    MainLoop(window);
   glfwTerminate();
   return 0;
 }
@@ -0,0 +1,74 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Voxels in each axis of a cascade
+const int RESOLUTION = 256;
+
+// Position of the first voxel of the cascade depth in the toroidal storage
+uniform int z_origin;
+
+// The voxels [slab_begin, slab_end) of the cascade depth are cleared
+uniform int slab_begin;
+uniform int slab_end;
+
+// Screen texture coordinates
+in vec2 frag_textcoord;
+
+// Inverse of the slab mask, combined with the logic operation AND
+out uvec4 voxels[2];
+
+// Mask with the bits [lo, hi] of a word set
+uint bit_range(int lo, int hi) {
+  return (0xFFFFFFFFu >> (31 - hi)) & (0xFFFFFFFFu << lo);
+}
+
+// Mask with the bits of the word that store the voxels [begin, end)
+uint word_mask(int word, int begin, int end) {
+  int lo = max(begin - word * 32, 0);
+  int hi = min(end - word * 32, 32) - 1;
+  return hi >= lo ? bit_range(lo, hi) : 0u;
+}
+
+// Mask with the bits of the word that store the voxels [begin, end) of the
+// cascade depth; the storage wraps around
+uint wrapped_mask(int word, int begin, int end) {
+  int first = begin + z_origin;
+  int last = end + z_origin;
+  if (first >= RESOLUTION)
+    return word_mask(word, first - RESOLUTION, last - RESOLUTION);
+  if (last <= RESOLUTION)
+    return word_mask(word, first, last);
+  return word_mask(word, first, RESOLUTION) |
+         word_mask(word, 0, last - RESOLUTION);
+}
+
+void main() {
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j)
+      voxels[i][j] = ~wrapped_mask(i * 4 + j, slab_begin, slab_end);
+  }
+}
@@ -0,0 +1,81 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#version 450
+
+// One work group per 8x8 columns of a slice map buffer
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// Maximum number of dynamic instances
+const int MAX_MOVERS = 16;
+
+// Static layer and slice map buffers being composited
+uniform usampler2D static_layer;
+layout(rgba32ui) uniform writeonly uimage2D slice_map;
+
+// Slice map buffer (128 voxels of depth) and columns composited
+uniform int buffer_index;
+uniform int region_x0;
+uniform int region_y0;
+uniform int region_x1;
+uniform int region_y1;
+
+// Object volume, voxelized in the object space (2 buffers)
+uniform usampler2D object_volume[2];
+uniform int object_volume_resolution;
+
+// Dynamic instances, as the object volume coordinates of the slice map
+// voxels
+uniform int n_movers;
+uniform mat4 object_from_scene[MAX_MOVERS];
+
+// Obtains a voxel of the object volume
+bool get_object_voxel(ivec3 voxel) {
+  uvec4 texel = voxel.z < 128 ? texelFetch(object_volume[0], voxel.xy, 0) :
+                                texelFetch(object_volume[1], voxel.xy, 0);
+  int z = voxel.z % 128;
+  return ((texel[z / 32] >> (z % 32)) & 1u) != 0u;
+}
+
+void main() {
+  ivec2 column = ivec2(region_x0, region_y0) + ivec2(gl_GlobalInvocationID.xy);
+  if (column.x >= region_x1 || column.y >= region_y1)
+    return;
+  uvec4 words = texelFetch(static_layer, column, 0);
+  for (int i = 0; i < n_movers; ++i) {
+    // The transformation is affine, so the voxels of the column are a line
+    vec4 first = vec4(vec2(column) + 0.5, buffer_index * 128 + 0.5, 1);
+    vec3 position = vec3(object_from_scene[i] * first);
+    vec3 step = object_from_scene[i][2].xyz;
+    for (int z = 0; z < 128; ++z, position += step) {
+      ivec3 voxel = ivec3(floor(position));
+      if (any(lessThan(voxel, ivec3(0))) ||
+          any(greaterThanEqual(voxel, ivec3(object_volume_resolution))))
+        continue;
+      if (get_object_voxel(voxel))
+        words[z / 32] |= 1u << (z % 32);
+    }
+  }
+  imageStore(slice_map, column, words);
+}
@@ -0,0 +1,51 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#version 450
+
+// One work group per 8x8 cells of the same depth, so the slice map index is
+// uniform inside the group
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// Slice map
+uniform usampler2D slice_map[8];
+
+// Fraction of active voxels of each 2x2x2 block of the slice map
+layout(r8) uniform writeonly image3D density;
+
+void main() {
+  ivec3 cell = ivec3(gl_GlobalInvocationID);
+  int z = cell.z * 2;
+  int word = z / 32;
+  int shift = z % 32;
+  int n_active = 0;
+  for (int y = 0; y < 2; ++y) {
+    for (int x = 0; x < 2; ++x) {
+      uvec4 column = texelFetch(slice_map[word / 4], cell.xy * 2 + ivec2(x, y),
+                                0);
+      n_active += bitCount((column[word % 4] >> shift) & 3u);
+    }
+  }
+  imageStore(density, cell, vec4(n_active / 8.0));
+}
@@ -0,0 +1,58 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// Nearest seed of each cell, packed as x | y << 10 | z << 20
+layout(r32ui) uniform readonly uimage3D seeds;
+
+// Distance that can be traveled from any point of a cell without reaching an
+// active voxel, in slice map units
+layout(r16f) uniform writeonly image3D distance_field;
+
+// Value of the cells without a seed
+const uint NO_SEED = 0xFFFFFFFFu;
+
+// Distance used when the volume is empty
+const float MAX_DISTANCE = 2.0;
+
+// Unpacks the seed coordinates
+ivec3 unpack_seed(uint seed) {
+  return ivec3(seed & 0x3FF, (seed >> 10) & 0x3FF, seed >> 20);
+}
+
+void main() {
+  ivec3 cell = ivec3(gl_GlobalInvocationID);
+  uint seed = imageLoad(seeds, cell).r;
+  float dist = MAX_DISTANCE;
+  if (seed != NO_SEED) {
+    // Both the point and the active voxel may be anywhere inside their cells
+    float cells = length(vec3(unpack_seed(seed) - cell)) - sqrt(3.0);
+    dist = max(cells, 0) / imageSize(seeds).x;
+  }
+  imageStore(distance_field, cell, vec4(dist));
+}
@@ -0,0 +1,70 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// Distance between the cells compared in this pass
+uniform int jump;
+
+// Nearest seed of each cell, packed as x | y << 10 | z << 20
+layout(r32ui) uniform readonly uimage3D src_seeds;
+layout(r32ui) uniform writeonly uimage3D dst_seeds;
+
+// Value of the cells without a seed
+const uint NO_SEED = 0xFFFFFFFFu;
+
+// Unpacks the seed coordinates
+ivec3 unpack_seed(uint seed) {
+  return ivec3(seed & 0x3FF, (seed >> 10) & 0x3FF, seed >> 20);
+}
+
+void main() {
+  ivec3 cell = ivec3(gl_GlobalInvocationID);
+  ivec3 size = imageSize(src_seeds);
+  uint best_seed = NO_SEED;
+  float best_dist = 0;
+  for (int z = -1; z <= 1; ++z) {
+    for (int y = -1; y <= 1; ++y) {
+      for (int x = -1; x <= 1; ++x) {
+        ivec3 neighbor = cell + ivec3(x, y, z) * jump;
+        if (any(lessThan(neighbor, ivec3(0))) ||
+            any(greaterThanEqual(neighbor, size)))
+          continue;
+        uint seed = imageLoad(src_seeds, neighbor).r;
+        if (seed == NO_SEED)
+          continue;
+        vec3 offset = vec3(unpack_seed(seed) - cell);
+        float dist = dot(offset, offset);
+        if (best_seed == NO_SEED || dist < best_dist) {
+          best_seed = seed;
+          best_dist = dist;
+        }
+      }
+    }
+  }
+  imageStore(dst_seeds, cell, uvec4(best_seed));
+}
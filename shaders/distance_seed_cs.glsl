@@ -0,0 +1,68 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// One work group per 8x8 cells of the same depth, so the slice map index is
+// uniform inside the group
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// Slice map
+uniform usampler2D slice_map[8];
+
+// Number of voxels covered by each cell in each axis
+uniform int cell_size;
+
+// Nearest seed of each cell, packed as x | y << 10 | z << 20
+layout(r32ui) uniform writeonly uimage3D seeds;
+
+// Value of the cells without a seed
+const uint NO_SEED = 0xFFFFFFFFu;
+
+// Mask with the bits [lo, hi] of a word set
+uint bit_range(int lo, int hi) {
+  return (0xFFFFFFFFu >> (31 - hi)) & (0xFFFFFFFFu << lo);
+}
+
+void main() {
+  ivec3 cell = ivec3(gl_GlobalInvocationID);
+  ivec2 first_texel = cell.xy * cell_size;
+  int z0 = cell.z * cell_size;
+  int z1 = z0 + cell_size - 1;
+  bool occupied = false;
+  for (int word = z0 / 32; word <= z1 / 32 && !occupied; ++word) {
+    int base = word * 32;
+    uint mask = bit_range(max(z0 - base, 0), min(z1 - base, 31));
+    for (int y = 0; y < cell_size && !occupied; ++y) {
+      for (int x = 0; x < cell_size && !occupied; ++x) {
+        ivec2 texel = first_texel + ivec2(x, y);
+        uvec4 column = texelFetch(slice_map[word / 4], texel, 0);
+        occupied = (column[word % 4] & mask) != 0;
+      }
+    }
+  }
+  uint seed = occupied ? uint(cell.x | cell.y << 10 | cell.z << 20) : NO_SEED;
+  imageStore(seeds, cell, uvec4(seed));
+}
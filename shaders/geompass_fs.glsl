@@ -28,9 +28,15 @@
 // Vertex material
 uniform int material_id;
 
+// Baked ambient occlusion in texture space, the texels have 1 - occlusion
+uniform bool use_lightmap;
+uniform sampler2D lightmap;
+
 // Input from vertex shader
 in vec3 frag_position;
 in vec3 frag_normal;
+in float frag_occlusion;
+in vec2 frag_textcoord;
 
 // Geometry output
 layout(location = 0) out vec3 position;
@@ -44,5 +50,11 @@ void main() {
   // If the material equals to 0, no geometry was rendered and the
   // lightpass should render the background color
   material.r = material_id + 1;
+
+  // The baked ambient occlusion factor is kept for the lightpass
+  if (use_lightmap)
+    material.g = 1 - texture(lightmap, frag_textcoord).r;
+  else
+    material.g = frag_occlusion;
 }
 
@@ -38,15 +38,24 @@ layout(std140) uniform MatricesBlock { Matrices matrices[100]; };
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec4 normal;
 
+// Baked ambient occlusion of the vertex (0 if the mesh has none)
+layout(location = 2) in float occlusion;
+
+// Texture coordinates of the lightmap (only read if there is one)
+layout(location = 3) in vec2 textcoord;
+
 // Vertex output
 out vec3 frag_position;
 out vec3 frag_normal;
 out vec2 frag_textcoord;
+out float frag_occlusion;
 
 void main() {
   Matrices M = matrices[gl_InstanceID];
   gl_Position = M.mvp * position;
   frag_position = vec3(M.modelview * position);
   frag_normal = normalize(vec3(M.normalmatrix * normal));
+  frag_occlusion = occlusion;
+  frag_textcoord = textcoord;
 }
 
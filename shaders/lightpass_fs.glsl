@@ -58,32 +58,32 @@ struct Material {
 };
 layout(std140) uniform MaterialsBlock { Material materials[8]; };
 
-// Slice map
-uniform usampler2D slice_map[8];
-
-// Mapping * Projection * View matrix
-uniform mat4 slice_map_matrix;
-
-// Slice map matrix inverse transpose
-uniform mat4 slice_map_matrix_it;
-
 // Enables ambient occlusion debug
 uniform bool ambient_occlusion_debug;
 
-// Rays buffer object
-layout(std140) uniform RaysBlock { vec3 rays[256]; };
+// Ambient occlusion strength
+uniform float occlusion_factor;
+
+// Occlusion pass output at the resolution of the geometry pass (occlusion
+// factor, traversal steps, samples blended and rays traced)
+uniform sampler2D occlusion_sampler;
 
-// Ambient occlusion parameters
-const float OCCLUSION_FACTOR = 2.0;
-uniform float max_distance;
+// Uses the baked occlusion of the vertices, kept in the material target,
+// instead of the occlusion pass
+uniform bool baked_occlusion;
+
+// Rays per pixel, scales the steps and rays debugs
 uniform int n_rays;
-uniform float step_size;
-uniform int n_volume_buffers;
+
+// Traversal steps per ray shown as red by the steps debug
+const float STEPS_DEBUG_SCALE = 128.0;
 
 // Visualization mode
 const int MODE_FULL_LIGHTING = 0;
 const int MODE_DIFFUSE_ONLY = 1;
 const int MODE_OCCLUSION_DEBUG = 2;
+const int MODE_STEPS_DEBUG = 3;
+const int MODE_RAYS_DEBUG = 4;
 uniform int mode;
 
 // Screen texture coordinates
@@ -92,28 +92,6 @@ in vec2 frag_textcoord;
 // Output color
 out vec3 color;
 
-// Multiplies a vec3 by a mat4
-vec3 multmatrix(mat4 matrix, vec3 vector) {
-  vec4 result_vector = matrix * vec4(vector, 1);
-  return result_vector.xyz / result_vector.w;
-}
-
-// Multiplies a vec3 by a mat4 ignoring the w coordinate
-vec3 multnormal(mat4 matrix, vec3 normal) {
-  return normalize((matrix * vec4(normal, 1)).xyz);
-}
-
-// Given the position in slicemap space, obtains the voxel value
-// True means that the voxel is active
-bool get_voxel(vec3 position) {
-  float z = position.z;
-  float slice_position = z * n_volume_buffers;
-  uvec4 column = texture(slice_map[int(slice_position)], position.xy);
-  int voxel_idx = int(fract(slice_position) * 128);
-  uint voxel = (column[voxel_idx / 32] >> voxel_idx % 32) & 1;
-  return voxel == 1;
-}
-
 // Compute the diffuse lighting
 vec3 compute_diffuse(Light L, Material M, vec3 normal, vec3 light_dir) {
   vec3 diffuse = M.diffuse * L.diffuse;
@@ -158,84 +136,10 @@ vec3 compute_shading(Light L, Material M, vec3 normal, vec3 position) {
   return spot_intensity * (diffuse + specular);
 }
 
-// Returns true if the ray hit something, else returns false
-// Also returns the distance that the ray traveled
-// The traveled_dist must be set outside of the function
-bool march_ray(vec3 start, vec3 ray, float step_size, float max_dist,
-               inout float traveled_dist) {
-  vec3 curr_pos = start;
-  vec3 ray_step = ray * step_size;
-  while (traveled_dist < max_dist) {
-    if (curr_pos.x < 0 || curr_pos.x > 1 ||
-        curr_pos.y < 0 || curr_pos.y > 1 ||
-        curr_pos.z < 0 || curr_pos.z > 1) {
-      return false;
-    }
-    if (get_voxel(curr_pos)) {
-      return true;
-    }
-    traveled_dist += step_size;
-    curr_pos += ray_step;
-  }
-  return false;
-}
-
-// GLSL rotation about an arbitrary axis
-// http://www.neilmendoza.com/glsl-rotation-about-an-arbitrary-axis/
-mat3 create_rotation_matrix(vec3 axis, float s) {
-  float c = -sqrt(1 - s * s);
-  float oc = 1.0 - c;
-  return mat3(
-      oc * axis.x * axis.x + c,
-      oc * axis.x * axis.y - axis.z * s,
-      oc * axis.z * axis.x + axis.y * s,
-      oc * axis.x * axis.y + axis.z * s,
-      oc * axis.y * axis.y + c,
-      oc * axis.y * axis.z - axis.x * s,
-      oc * axis.z * axis.x - axis.y * s,
-      oc * axis.y * axis.z + axis.x * s,
-      oc * axis.z * axis.z + c);
-}
-
-// Computes the matrix to rotate the rays to the normal semihemisphere
-mat3 compute_hemisphere_rotation(vec3 normal) {
-  vec3 hemisphere_dir = vec3(0, 0, 1);
-  vec3 w = cross(normal, hemisphere_dir);
-  float lw = length(w);
-  if (lw < 0.001)
-    return mat3(1, 0, 0, 0, 1, 0, 0, 0, -1);
-  else
-    return create_rotation_matrix(normalize(w), lw);
-}
-
-// Computes the ambient occlusion factor
-float compute_ambient_occlusion(vec3 normal_vs, vec3 position_vs) {
-  vec3 position = multmatrix(slice_map_matrix, position_vs);
-  vec3 normal = multnormal(slice_map_matrix_it, normal_vs);
-  int n_rays_used = 0;
-  float acc_factor = 0;
-
-  mat3 R = compute_hemisphere_rotation(normal);
-
-  for (int i = 0; i < n_rays; ++i) {
-    vec3 ray = R * rays[i];
-    float angle = dot(ray, normal);
-    if (angle < 0.1)
-      continue;
-    float d0 = step_size * sqrt(3.0) / angle;
-    vec3 start = position + ray * d0;
-    float traveled_dist = d0;
-    bool hit = march_ray(start, ray, step_size, max_distance, traveled_dist);
-    if (hit) {
-      acc_factor += (1 - traveled_dist / max_distance) * angle;
-    }
-    n_rays_used++;
-  }
-
-  if (n_rays_used != 0)
-    return acc_factor / n_rays_used;
-  else
-    return 0;
+// Maps a value in [0, 1] to blue, green and red
+vec3 heatmap(float value) {
+  float v = clamp(value, 0, 1) * 4;
+  return clamp(vec3(v - 2, 2 - abs(v - 2), 2 - v), 0, 1);
 }
 
 // Compute the ambient lighting
@@ -245,7 +149,8 @@ vec3 compute_ambient(Material M) {
 
 // Computes the final fragment color
 void main() {
-  int material = int(texture(material_sampler, frag_textcoord).x) - 1;
+  vec2 material_texel = texture(material_sampler, frag_textcoord).xy;
+  int material = int(material_texel.x) - 1;
   if (material == -1) {
     color = background;
     return;
@@ -260,15 +165,20 @@ void main() {
     acc_color += compute_shading(L, M, normal, position);
   }
   vec3 ambient = compute_ambient(M);
-  float occlusion =
-      1 - OCCLUSION_FACTOR * compute_ambient_occlusion(normal, position);
+  vec4 ambient_occlusion = texture(occlusion_sampler, frag_textcoord);
+  if (baked_occlusion)
+    ambient_occlusion = vec4(material_texel.y, 0, 0, 0);
+  float occlusion = 1 - occlusion_factor * ambient_occlusion.x;
 
   if (mode == MODE_FULL_LIGHTING) {
     color = acc_color + ambient * occlusion;
   } else if (mode == MODE_DIFFUSE_ONLY) {
     color = acc_color + ambient;
+  } else if (mode == MODE_STEPS_DEBUG) {
+    color = heatmap(ambient_occlusion.y / (n_rays * STEPS_DEBUG_SCALE));
+  } else if (mode == MODE_RAYS_DEBUG) {
+    color = heatmap(ambient_occlusion.w / n_rays);
   } else {
     color = vec3(occlusion, occlusion, occlusion);
   }
 }
-
@@ -0,0 +1,618 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Ambient occlusion over the voxel volumes (slice map, bricks, clipmap,
+// octree and density), shared by the passes that trace the occlusion
+
+// Slice map
+uniform usampler2D slice_map[8];
+
+// Mapping * Projection * View matrix
+uniform mat4 slice_map_matrix;
+
+// Slice map matrix inverse transpose
+uniform mat4 slice_map_matrix_it;
+
+// Rays buffer object
+layout(std140) uniform RaysBlock { vec3 rays[256]; };
+
+// Ambient occlusion parameters; each pixel traces n_rays of the ray set,
+// starting at ray_offset (the set is rotated by the temporal accumulation)
+uniform float max_distance;
+uniform int n_rays;
+uniform int ray_offset;
+uniform int ray_set_size;
+
+// The rays of the set are cosine distributed around z, so the hits aren't
+// weighted by the cosine, or uniform in the hemisphere
+uniform bool cosine_rays;
+
+// Rotation of the ray set around the normal of each pixel by a tiled blue
+// noise angle, so the neighbouring pixels trace different rays and the error
+// is fine noise instead of banding, plus rotation_offset (in turns), which
+// changes the rays traced by the frames that accumulate the occlusion
+uniform bool use_rotation_noise;
+uniform sampler2D rotation_noise;
+uniform float rotation_offset;
+
+// Interleaved sampling: the target is split in interleave_size x
+// interleave_size sub-images of sub_image_size pixels, and the sub-image k
+// traces the rays [k * n_rays, (k + 1) * n_rays) of the set, so the pixels of
+// a sub-image trace the same rays through nearby voxels
+uniform bool interleaved;
+uniform int interleave_size;
+uniform ivec2 sub_image_size;
+
+// World space ambient occlusion cache, a grid over the volume with the
+// occlusion of the cells next to the surface and its weight (0 in the other
+// cells), and the detail rays traced up to detail_distance from each pixel
+uniform sampler3D occlusion_cache;
+uniform int detail_rays;
+uniform float detail_distance;
+
+// Total weight of the cells of the cache below which it is missed
+const float CACHE_MIN_WEIGHT = 0.05;
+
+// Adaptive sampling: the rays are traced in batches of adaptive_batch, and
+// the pixel stops after a batch once the estimated standard error of its
+// occlusion is below adaptive_error
+uniform bool adaptive;
+uniform int adaptive_batch;
+uniform float adaptive_error;
+
+// Slice map layout: size of a voxel in texture coordinates (the ray marching
+// step), number of slice map textures and voxels per axis
+uniform float step_size;
+uniform int n_volume_buffers;
+uniform int volume_resolution;
+
+// Distance field used to skip the empty space
+uniform sampler3D distance_field;
+uniform int distance_field_resolution;
+uniform bool use_distance_field;
+
+// Bricked slice map, used instead of the dense one if enabled
+// Page table entries: 0 is an empty brick, 1 a full brick, otherwise the
+// index of the brick in the pool plus 2; each brick of the pool has 4 texels
+// and the column (x, y) of the brick is the byte x + 8 * y
+const int BRICK_SIZE = 8;
+const int POOL_WIDTH = 1024;
+uniform usampler3D brick_table;
+uniform usampler2D brick_pool;
+uniform bool use_bricks;
+
+// Clipmap cascades centred at the camera, used instead of the slice map if
+// enabled; the levels are stacked along y in the textures and each one is
+// addressed toroidally (the voxel g of the grid is stored at g % resolution)
+uniform usampler2D clipmap[2];
+uniform bool use_clipmap;
+uniform int clipmap_levels;
+uniform int clipmap_resolution;
+
+// View space to the grid of the first level, the grid of the level k is
+// scaled by 1 / 2^k; the cascade k covers [origin, origin + resolution)
+uniform mat4 clipmap_matrix;
+uniform mat4 clipmap_matrix_it;
+uniform vec3 clipmap_origins[4];
+
+// Ambient occlusion distance in voxels of the first level
+uniform float clipmap_max_distance;
+
+// Cascade traversed by march_ray, -1 means the slice map
+int active_level = -1;
+
+// Sparse voxel octree, used instead of the slice map if enabled
+// Entries: 0 is an empty child, 1 a full child, otherwise the offset of the
+// child; nodes have 8 entries and the 4x4x4 bricks have 2 words
+layout(std430) readonly buffer OctreeBlock { uint svo_nodes[]; };
+uniform bool use_svo;
+uniform int svo_root;
+uniform int svo_depth;
+uniform int svo_resolution;
+
+// Ambient occlusion method
+const int AO_RAY_MARCHING = 0;
+const int AO_CONE_TRACING = 1;
+uniform int ao_method;
+
+// Mip chain of the fraction of active voxels, used by the cone tracing; the
+// first level has half of the slice map resolution
+uniform sampler3D density;
+uniform int density_resolution;
+
+// Cones used by the cone tracing (normal hemisphere, z is the normal); they
+// have an aperture of 60 degrees and together they cover the hemisphere
+const int N_CONES = 6;
+const vec3 CONES[N_CONES] = vec3[](
+    vec3(0, 0, 1),
+    vec3(0.866025, 0, 0.5),
+    vec3(0.267617, 0.823639, 0.5),
+    vec3(-0.700629, 0.509037, 0.5),
+    vec3(-0.700629, -0.509037, 0.5),
+    vec3(0.267617, -0.823639, 0.5));
+const float CONE_WEIGHTS[N_CONES] = float[](0.25, 0.15, 0.15, 0.15, 0.15,
+                                            0.15);
+const float CONE_TAN_HALF_APERTURE = 0.57735;
+
+// Number of traversal steps of the fragment
+int n_steps = 0;
+
+// Number of rays traced by the fragment
+int n_traced_rays = 0;
+
+// Pixel of the fragment, which selects its rotation and its sub-image
+ivec2 sample_pixel = ivec2(0, 0);
+
+// Multiplies a vec3 by a mat4
+vec3 multmatrix(mat4 matrix, vec3 vector) {
+  vec4 result_vector = matrix * vec4(vector, 1);
+  return result_vector.xyz / result_vector.w;
+}
+
+// Multiplies a vec3 by a mat4 ignoring the w coordinate
+vec3 multnormal(mat4 matrix, vec3 normal) {
+  return normalize((matrix * vec4(normal, 1)).xyz);
+}
+
+// Obtains the voxels of the column (x, y) of a brick, one per bit
+uint fetch_brick_column(ivec3 brick, ivec2 xy) {
+  uint entry = texelFetch(brick_table, brick, 0).r;
+  if (entry <= 1)
+    return entry == 1 ? 0xFFu : 0u;
+  int index = int(entry) - 2;
+  int byte = xy.x % BRICK_SIZE + BRICK_SIZE * (xy.y % BRICK_SIZE);
+  ivec2 texel = ivec2(index % POOL_WIDTH * 4 + byte / 16, index / POOL_WIDTH);
+  uint word = texelFetch(brick_pool, texel, 0)[byte / 4 % 4];
+  return (word >> (byte % 4 * 8)) & 0xFFu;
+}
+
+// Same as fetch_word, but for the bricked slice map; a word spans 4 bricks
+uint fetch_brick_word(ivec2 xy, int word) {
+  ivec3 brick = ivec3(xy / BRICK_SIZE, word * 32 / BRICK_SIZE);
+  uint bits = 0;
+  for (int i = 0; i < 32 / BRICK_SIZE; ++i)
+    bits |= fetch_brick_column(brick + ivec3(0, 0, i), xy) << (i * BRICK_SIZE);
+  return bits;
+}
+
+// Given the position in slicemap space, obtains the voxel value
+// True means that the voxel is active
+bool get_voxel(vec3 position) {
+  if (use_bricks) {
+    ivec3 voxel = min(ivec3(position * volume_resolution),
+                      ivec3(volume_resolution - 1));
+    uint column = fetch_brick_column(voxel / BRICK_SIZE, voxel.xy);
+    return ((column >> (voxel.z % BRICK_SIZE)) & 1) == 1;
+  }
+  float z = position.z;
+  float slice_position = z * n_volume_buffers;
+  uvec4 column = texture(slice_map[int(slice_position)], position.xy);
+  int voxel_idx = int(fract(slice_position) * 128);
+  uint voxel = (column[voxel_idx / 32] >> voxel_idx % 32) & 1;
+  return voxel == 1;
+}
+
+// Obtains a word of the toroidal storage of the active cascade
+uint fetch_clipmap_storage(ivec2 xy, int word) {
+  ivec2 texel = xy + ivec2(0, active_level * clipmap_resolution);
+  uvec4 column = texelFetch(clipmap[word / 4], texel, 0);
+  return column[word % 4];
+}
+
+// Same as fetch_word, but for the active cascade; the coordinates are
+// rotated to the toroidal storage, so a word may be split in two
+uint fetch_clipmap_word(ivec2 xy, int word) {
+  int n_words = clipmap_resolution / 32;
+  vec3 origin = clipmap_origins[active_level];
+  ivec3 offset = ivec3(mod(origin, float(clipmap_resolution)));
+  ivec2 storage_xy = (xy + offset.xy) % clipmap_resolution;
+  int first = word * 32 + offset.z;
+  int shift = first % 32;
+  int storage_word = (first / 32) % n_words;
+  uint bits = fetch_clipmap_storage(storage_xy, storage_word) >> shift;
+  if (shift != 0) {
+    int next_word = (storage_word + 1) % n_words;
+    bits |= fetch_clipmap_storage(storage_xy, next_word) << (32 - shift);
+  }
+  return bits;
+}
+
+// Obtains 32 voxels of the column (x, y), starting at z = 32 * word
+uint fetch_word(ivec2 xy, int word) {
+  if (active_level >= 0)
+    return fetch_clipmap_word(xy, word);
+  if (use_bricks)
+    return fetch_brick_word(xy, word);
+  uvec4 column = texelFetch(slice_map[word / 4], xy, 0);
+  return column[word % 4];
+}
+
+// Mask with the bits [lo, hi] of a word set
+uint bit_range(int lo, int hi) {
+  return (0xFFFFFFFFu >> (31 - hi)) & (0xFFFFFFFFu << lo);
+}
+
+// Finds the first active voxel of the column (x, y) between the voxels z0
+// and z1 (inclusive), walking from z0 to z1
+// Tests 32 voxels at once; returns -1 if there is no active voxel
+int find_in_column(ivec2 xy, int z0, int z1) {
+  int lo = min(z0, z1);
+  int hi = max(z0, z1);
+  if (z1 >= z0) {
+    for (int word = lo / 32; word <= hi / 32; ++word) {
+      int base = word * 32;
+      uint mask = bit_range(max(lo - base, 0), min(hi - base, 31));
+      uint bits = fetch_word(xy, word) & mask;
+      if (bits != 0)
+        return base + findLSB(bits);
+    }
+  } else {
+    for (int word = hi / 32; word >= lo / 32; --word) {
+      int base = word * 32;
+      uint mask = bit_range(max(lo - base, 0), min(hi - base, 31));
+      uint bits = fetch_word(xy, word) & mask;
+      if (bits != 0)
+        return base + findMSB(bits);
+    }
+  }
+  return -1;
+}
+
+// Returns true if the ray hit something, else returns false
+// Also returns the distance that the ray traveled
+// The traveled_dist must be set outside of the function
+//
+// Amanatides-Woo traversal over the (x, y) columns of the slice map; inside
+// each column, the voxels crossed by the ray are tested with bit masks, so
+// every voxel is visited exactly once and the hit distance is exact
+bool march_ray(vec3 start, vec3 ray, float max_dist,
+               inout float traveled_dist) {
+  if (any(lessThan(start, vec3(0))) || any(greaterThan(start, vec3(1))))
+    return false;
+
+  // Works in voxel units
+  int resolution = active_level >= 0 ? clipmap_resolution : volume_resolution;
+  float res = float(resolution);
+  vec3 p = start * res;
+  vec3 dir = mix(ray, vec3(1e-6), lessThan(abs(ray), vec3(1e-6)));
+  vec3 inv_dir = 1.0 / dir;
+
+  // Clips the ray against the volume
+  vec3 t_exit = (step(0, dir) * res - p) * inv_dir;
+  float t_end = min((max_dist - traveled_dist) * res,
+                    min(t_exit.x, min(t_exit.y, t_exit.z)));
+
+  ivec2 cell = ivec2(min(floor(p.xy), vec2(res - 1)));
+  ivec2 cell_step = ivec2(sign(dir.xy));
+  vec2 t_delta = abs(inv_dir.xy);
+  vec2 t_next = (vec2(cell) + step(0, dir.xy) - p.xy) * inv_dir.xy;
+
+  float t = 0;
+  while (t < t_end) {
+    n_steps++;
+    if (any(lessThan(cell, ivec2(0))) ||
+        any(greaterThanEqual(cell, ivec2(resolution))))
+      break;
+    float t_leave = min(min(t_next.x, t_next.y), t_end);
+    int z0 = clamp(int(floor(p.z + dir.z * t)), 0, resolution - 1);
+    int z1 = clamp(int(floor(p.z + dir.z * t_leave)), 0, resolution - 1);
+    int z = find_in_column(cell, z0, z1);
+    if (z >= 0) {
+      float t_hit = t;
+      if (z != z0)
+        t_hit = (float(dir.z > 0 ? z : z + 1) - p.z) * inv_dir.z;
+      traveled_dist += t_hit / res;
+      return true;
+    }
+    t = t_leave;
+    if (t_next.x < t_next.y) {
+      cell.x += cell_step.x;
+      t_next.x += t_delta.x;
+    } else {
+      cell.y += cell_step.y;
+      t_next.y += t_delta.y;
+    }
+  }
+  traveled_dist += t_end / res;
+  return false;
+}
+
+// Obtains the value of a voxel of the sparse voxel octree
+// Also returns the size of the uniform cube that contains the voxel
+bool get_svo_voxel(ivec3 voxel, out int size) {
+  uint entry = uint(svo_root);
+  size = svo_resolution;
+  for (int level = 0; level < svo_depth && entry > 1; ++level) {
+    size /= 2;
+    ivec3 child = (voxel / size) & 1;
+    entry = svo_nodes[entry + child.x + 2 * child.y + 4 * child.z];
+  }
+  if (entry <= 1)
+    return entry == 1;
+  ivec3 brick_voxel = voxel & 3;
+  int bit = brick_voxel.z + 4 * (brick_voxel.x + 4 * brick_voxel.y);
+  size = 1;
+  return ((svo_nodes[entry + bit / 32] >> (bit % 32)) & 1) != 0;
+}
+
+// Same as march_ray, but traverses the sparse voxel octree; the empty nodes
+// are skipped at once
+bool march_svo(vec3 start, vec3 ray, float max_dist,
+               inout float traveled_dist) {
+  if (any(lessThan(start, vec3(0))) || any(greaterThan(start, vec3(1))))
+    return false;
+
+  // Works in voxel units
+  float res = float(svo_resolution);
+  vec3 p = start * res;
+  vec3 dir = mix(ray, vec3(1e-6), lessThan(abs(ray), vec3(1e-6)));
+  vec3 inv_dir = 1.0 / dir;
+
+  // Clips the ray against the volume
+  vec3 t_exit = (step(0, dir) * res - p) * inv_dir;
+  float t_end = min((max_dist - traveled_dist) * res,
+                    min(t_exit.x, min(t_exit.y, t_exit.z)));
+
+  float t = 0;
+  while (t < t_end) {
+    n_steps++;
+    ivec3 voxel = clamp(ivec3(floor(p + dir * t)), ivec3(0),
+                        ivec3(svo_resolution - 1));
+    int size;
+    if (get_svo_voxel(voxel, size)) {
+      traveled_dist += t / res;
+      return true;
+    }
+    // Jumps to the exit of the uniform cube
+    vec3 corner = vec3((voxel / size) * size);
+    vec3 t_cube = (corner + step(0, dir) * float(size) - p) * inv_dir;
+    t = max(min(t_cube.x, min(t_cube.y, t_cube.z)), t) + 1e-3;
+  }
+  traveled_dist += t_end / res;
+  return false;
+}
+
+// Same as march_ray, but skips the empty space with sphere tracing over the
+// distance field and only marches the voxels of the cells near the geometry
+// Uses the sparse voxel octree instead of the slice map if it is enabled
+bool trace_ray(vec3 start, vec3 ray, float max_dist,
+               inout float traveled_dist) {
+  if (active_level >= 0)
+    return march_ray(start, ray, max_dist, traveled_dist);
+  if (use_svo)
+    return march_svo(start, ray, max_dist, traveled_dist);
+  if (!use_distance_field)
+    return march_ray(start, ray, max_dist, traveled_dist);
+
+  float cell_size = 1.0 / distance_field_resolution;
+  float start_dist = traveled_dist;
+  while (traveled_dist < max_dist) {
+    vec3 position = start + ray * (traveled_dist - start_dist);
+    if (any(lessThan(position, vec3(0))) ||
+        any(greaterThan(position, vec3(1))))
+      return false;
+    n_steps++;
+    ivec3 cell = min(ivec3(position * distance_field_resolution),
+                     ivec3(distance_field_resolution - 1));
+    float dist = texelFetch(distance_field, cell, 0).r;
+    if (dist > 0) {
+      traveled_dist += dist;
+      continue;
+    }
+    float segment_start = traveled_dist;
+    float segment_end = min(max_dist, traveled_dist + cell_size);
+    if (march_ray(position, ray, segment_end, traveled_dist))
+      return true;
+    if (traveled_dist <= segment_start)
+      return false;
+  }
+  return false;
+}
+
+// GLSL rotation about an arbitrary axis
+// http://www.neilmendoza.com/glsl-rotation-about-an-arbitrary-axis/
+mat3 create_rotation_matrix(vec3 axis, float s) {
+  float c = -sqrt(1 - s * s);
+  float oc = 1.0 - c;
+  return mat3(
+      oc * axis.x * axis.x + c,
+      oc * axis.x * axis.y - axis.z * s,
+      oc * axis.z * axis.x + axis.y * s,
+      oc * axis.x * axis.y + axis.z * s,
+      oc * axis.y * axis.y + c,
+      oc * axis.y * axis.z - axis.x * s,
+      oc * axis.z * axis.x - axis.y * s,
+      oc * axis.y * axis.z + axis.x * s,
+      oc * axis.z * axis.z + c);
+}
+
+// Computes the matrix to rotate the rays to the normal semihemisphere
+mat3 compute_hemisphere_rotation(vec3 normal) {
+  vec3 hemisphere_dir = vec3(0, 0, 1);
+  vec3 w = cross(normal, hemisphere_dir);
+  float lw = length(w);
+  if (lw < 0.001)
+    return mat3(1, 0, 0, 0, 1, 0, 0, 0, -1);
+  else
+    return create_rotation_matrix(normalize(w), lw);
+}
+
+// Selects the finest cascade that contains the ambient occlusion radius
+// around the point, given in the grid of the first level; the cascades are
+// centred at the camera, so it depends on the distance to the camera
+int select_cascade(vec3 grid) {
+  for (int level = 0; level < clipmap_levels - 1; ++level) {
+    float scale = exp2(float(-level));
+    vec3 p = grid * scale - clipmap_origins[level];
+    float radius = clipmap_max_distance * scale;
+    if (all(greaterThanEqual(p, vec3(radius))) &&
+        all(lessThanEqual(p, vec3(clipmap_resolution - radius))))
+      return level;
+  }
+  return clipmap_levels - 1;
+}
+
+// Traces count rays of the set from the position, in the space of the
+// volume, up to ray_length, and computes the ambient occlusion factor; the
+// rays start past the voxel of the position
+float trace_occlusion(vec3 position, vec3 normal, int count,
+                      float ray_length, float voxel_size) {
+  int n_rays_used = 0;
+  float acc_factor = 0;
+  float acc_square = 0;
+
+  mat3 R = compute_hemisphere_rotation(normal);
+  float turns = rotation_offset;
+  if (use_rotation_noise) {
+    ivec2 texel = sample_pixel % textureSize(rotation_noise, 0);
+    turns += texelFetch(rotation_noise, texel, 0).r;
+  }
+  float c = cos(turns * 6.2831853);
+  float s = sin(turns * 6.2831853);
+  mat2 rotation = mat2(c, s, -s, c);
+
+  int first_ray = ray_offset;
+  if (interleaved) {
+    ivec2 sub_image = sample_pixel / sub_image_size;
+    first_ray += (sub_image.y * interleave_size + sub_image.x) * count;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    if (adaptive && i % adaptive_batch == 0 && n_rays_used > 1) {
+      float mean = acc_factor / n_rays_used;
+      float variance = max(acc_square / n_rays_used - mean * mean, 0) *
+                       n_rays_used / (n_rays_used - 1);
+      if (sqrt(variance / n_rays_used) < adaptive_error)
+        break;
+    }
+    n_traced_rays++;
+    vec3 dir = rays[(first_ray + i) % ray_set_size];
+    vec3 ray = R * vec3(rotation * dir.xy, dir.z);
+    float angle = dot(ray, normal);
+    if (angle < 0.1)
+      continue;
+    float d0 = voxel_size * sqrt(3.0) / angle;
+    vec3 start = position + ray * d0;
+    float traveled_dist = d0;
+    bool hit = trace_ray(start, ray, ray_length, traveled_dist);
+    // The cosine distributed mean is twice the one of the uniform rays
+    if (hit) {
+      float factor = (1 - traveled_dist / ray_length) *
+                     (cosine_rays ? 0.5 : angle);
+      acc_factor += factor;
+      acc_square += factor * factor;
+    }
+    n_rays_used++;
+  }
+
+  if (n_rays_used != 0)
+    return acc_factor / n_rays_used;
+  else
+    return 0;
+}
+
+// Computes the ambient occlusion factor
+float compute_ambient_occlusion(vec3 normal_vs, vec3 position_vs) {
+  vec3 position = multmatrix(slice_map_matrix, position_vs);
+  vec3 normal = multnormal(slice_map_matrix_it, normal_vs);
+  float ray_length = max_distance;
+  float voxel_size = step_size;
+  if (use_clipmap) {
+    vec3 grid = multmatrix(clipmap_matrix, position_vs);
+    active_level = select_cascade(grid);
+    float scale = exp2(float(-active_level));
+    position = (grid * scale - clipmap_origins[active_level]) /
+               clipmap_resolution;
+    normal = multnormal(clipmap_matrix_it, normal_vs);
+    ray_length = clipmap_max_distance * scale / clipmap_resolution;
+    voxel_size = 1.0 / clipmap_resolution;
+  }
+  return trace_occlusion(position, normal, n_rays, ray_length, voxel_size);
+}
+
+// Samples the occlusion of the cache half a cell above the surface; the
+// cells store the occlusion premultiplied by their weight, so the cells away
+// from the surface don't take part in the trilinear filter, and the surfaces
+// without cached cells around trace every ray. The optional detail rays
+// estimate the occlusion within detail_distance, with the falloff scaled to
+// that distance; the cache already counts those hits (blurred over a cell),
+// so the detail can't be added to it: the larger of the two is kept, which
+// only raises the occlusion where the contact occlusion is finer than the
+// cells
+float compute_cached_occlusion(vec3 normal_vs, vec3 position_vs) {
+  vec3 position = multmatrix(slice_map_matrix, position_vs);
+  vec3 normal = multnormal(slice_map_matrix_it, normal_vs);
+  float cell_size = 1.0 / textureSize(occlusion_cache, 0).x;
+  vec2 cached = texture(occlusion_cache, position + normal * cell_size *
+                        0.5).rg;
+  if (cached.g < CACHE_MIN_WEIGHT)
+    return trace_occlusion(position, normal, n_rays, max_distance, step_size);
+  float occlusion = cached.r / cached.g;
+  if (detail_rays > 0) {
+    occlusion = max(occlusion, trace_occlusion(position, normal, detail_rays,
+                                               detail_distance, step_size));
+  }
+  return occlusion;
+}
+
+// Accumulates the density inside a cone, sampling coarser mip levels as the
+// cone widens; the occlusion of each sample is attenuated by its distance
+float trace_cone(vec3 start, vec3 dir, float max_dist) {
+  float voxel_size = 1.0 / density_resolution;
+  float occlusion = 0;
+  float dist = voxel_size;
+  while (dist < max_dist && occlusion < 1) {
+    vec3 position = start + dir * dist;
+    if (any(lessThan(position, vec3(0))) ||
+        any(greaterThan(position, vec3(1))))
+      break;
+    n_steps++;
+    float diameter = max(2 * CONE_TAN_HALF_APERTURE * dist, voxel_size);
+    float lod = log2(diameter / voxel_size);
+    float alpha = textureLod(density, position, lod).r;
+    occlusion += (1 - occlusion) * alpha * (1 - dist / max_dist);
+    dist += diameter * 0.5;
+  }
+  return min(occlusion, 1);
+}
+
+// Computes the ambient occlusion factor with a few wide cones over the
+// density mip chain instead of many rays
+float compute_cone_occlusion(vec3 normal_vs, vec3 position_vs) {
+  vec3 position = multmatrix(slice_map_matrix, position_vs);
+  vec3 normal = multnormal(slice_map_matrix_it, normal_vs);
+  mat3 R = compute_hemisphere_rotation(normal);
+
+  // Starts one voxel above the surface, so it doesn't occlude itself
+  vec3 start = position + normal * (sqrt(3.0) / density_resolution);
+  float acc_factor = 0;
+  for (int i = 0; i < N_CONES; ++i) {
+    vec3 dir = R * CONES[i];
+    float angle = max(dot(dir, normal), 0);
+    acc_factor += CONE_WEIGHTS[i] * trace_cone(start, dir, max_distance) *
+                  angle;
+  }
+  return acc_factor;
+}
@@ -0,0 +1,82 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+#include "occlusion.glsl"
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// Density mip chain of the slice map; the level density_level has a texel
+// per cell of the cache
+uniform int density_level;
+
+// Occlusion of the cells next to the surface and its weight
+layout(rg16f) uniform writeonly image3D cache_cells;
+
+// Bounds of the cells whose density changed, and how many cells around them
+// the rays reach
+layout(std430) buffer DirtyBlock {
+  ivec4 dirty_min;
+  ivec4 dirty_max;
+};
+uniform int reach;
+
+// Obtains the density of a cell, 0 outside the volume
+float cell_density(ivec3 cell) {
+  ivec3 size = textureSize(density, density_level);
+  if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, size)))
+    return 0;
+  return texelFetch(density, cell, density_level).r;
+}
+
+// Updates the cells within the reach of the changed ones: the cells that
+// aren't full and have active voxels around are next to the surface, whose
+// normal is the opposite of the density gradient, and trace the rays from
+// their center. The other cells get no weight
+void main() {
+  ivec3 cell = ivec3(gl_GlobalInvocationID);
+  ivec3 size = imageSize(cache_cells);
+  if (any(greaterThanEqual(cell, size)) ||
+      any(lessThan(cell, dirty_min.xyz - reach)) ||
+      any(greaterThan(cell, dirty_max.xyz + reach)))
+    return;
+  float center = cell_density(cell);
+  vec3 gradient;
+  for (int i = 0; i < 3; ++i) {
+    ivec3 offset = ivec3(0);
+    offset[i] = 1;
+    gradient[i] = cell_density(cell + offset) - cell_density(cell - offset);
+  }
+  if (center >= 1 || length(gradient) < 1e-3) {
+    imageStore(cache_cells, cell, vec4(0));
+    return;
+  }
+  vec3 normal = -normalize(gradient);
+  vec3 position = (vec3(cell) + 0.5) / size;
+  float occlusion = trace_occlusion(position, normal, n_rays, max_distance,
+                                    1.0 / size.x);
+  imageStore(cache_cells, cell, vec4(occlusion, 1, 0, 0));
+}
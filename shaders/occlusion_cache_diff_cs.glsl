@@ -0,0 +1,60 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// Density mip chain of the slice map; the level density_level has a texel
+// per cell of the cache
+uniform sampler3D density;
+uniform int density_level;
+
+// Density of the cells when the cache was updated
+layout(r16f) uniform image3D cache_density;
+
+// Bounds of the cells whose density changed
+layout(std430) buffer DirtyBlock {
+  ivec4 dirty_min;
+  ivec4 dirty_max;
+};
+
+// Finds the cells of the occlusion cache whose density changed since the
+// last update, and keeps their new density
+void main() {
+  ivec3 cell = ivec3(gl_GlobalInvocationID);
+  if (any(greaterThanEqual(cell, imageSize(cache_density))))
+    return;
+  float value = texelFetch(density, cell, density_level).r;
+  if (abs(imageLoad(cache_density, cell).r - value) < 1e-3)
+    return;
+  imageStore(cache_density, cell, vec4(value));
+  atomicMin(dirty_min.x, cell.x);
+  atomicMin(dirty_min.y, cell.y);
+  atomicMin(dirty_min.z, cell.z);
+  atomicMax(dirty_max.x, cell.x);
+  atomicMax(dirty_max.y, cell.y);
+  atomicMax(dirty_max.z, cell.z);
+}
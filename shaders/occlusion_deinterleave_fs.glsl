@@ -0,0 +1,69 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Geometry pass inputs
+uniform sampler2D position_sampler;
+uniform sampler2D normal_sampler;
+uniform sampler2D material_sampler;
+
+// Pixels of the geometry pass per traced pixel in each axis; the traced
+// pixel k is the geometry pass pixel k * occlusion_scale + occlusion_scale / 2
+uniform int occlusion_scale;
+
+// Size of the traced image
+uniform ivec2 occlusion_size;
+
+// The target is split in interleave_size x interleave_size sub-images of
+// sub_image_size pixels
+uniform int interleave_size;
+uniform ivec2 sub_image_size;
+
+// Deinterleaved geometry
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec3 normal;
+layout(location = 2) out vec3 material;
+
+// Deinterleaves the geometry of the traced pixels: the pixel p of the
+// sub-image k is the traced pixel p * interleave_size + k, so each sub-image
+// is a coarse copy of the image, offset by k. The pixels past the border of
+// the image are background
+void main() {
+  ivec2 target = ivec2(gl_FragCoord.xy);
+  ivec2 sub_image = target / sub_image_size;
+  ivec2 traced = (target % sub_image_size) * interleave_size + sub_image;
+  if (any(greaterThanEqual(traced, occlusion_size))) {
+    position = vec3(0, 0, 0);
+    normal = vec3(0, 0, 0);
+    material = vec3(0, 0, 0);
+    return;
+  }
+  ivec2 pixel = min(traced * occlusion_scale + occlusion_scale / 2,
+                    textureSize(position_sampler, 0) - 1);
+  position = texelFetch(position_sampler, pixel, 0).xyz;
+  normal = texelFetch(normal_sampler, pixel, 0).xyz;
+  material = texelFetch(material_sampler, pixel, 0).xyz;
+}
@@ -0,0 +1,96 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Geometry pass inputs, which guide the filter
+uniform sampler2D position_sampler;
+uniform sampler2D normal_sampler;
+
+// Occlusion traced at a fraction of the resolution (occlusion factor,
+// traversal steps and samples); the pixel k traced the geometry pass pixel
+// k * occlusion_scale + occlusion_scale / 2
+uniform sampler2D occlusion_sampler;
+uniform int occlusion_scale;
+
+// Distance between the taps of the iteration (2^iteration)
+uniform int step_width;
+
+// Falloff of the weights with the angle between the normals and with the
+// distance to the tangent plane of the pixel (relative to its depth)
+const float NORMAL_POWER = 8.0;
+const float PLANE_TOLERANCE = 0.02;
+
+// B3 spline kernel, from the center to the border
+const float KERNEL[3] = float[](3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0);
+
+// Filtered occlusion
+out vec4 occlusion;
+
+// Obtains the geometry pass pixel traced by the pixel
+ivec2 guide_pixel(ivec2 pixel) {
+  return min(pixel * occlusion_scale + occlusion_scale / 2,
+             textureSize(position_sampler, 0) - 1);
+}
+
+// Iteration of the edge-avoiding a-trous wavelet filter: a 5x5 B3 spline
+// kernel whose taps are step_width pixels apart, so the iterations filter
+// growing footprints at the same cost. The weights of the taps on other
+// surfaces fall off, so the occlusion doesn't bleed across the edges
+void main() {
+  ivec2 pixel = ivec2(gl_FragCoord.xy);
+  vec4 center = texelFetch(occlusion_sampler, pixel, 0);
+  ivec2 guide = guide_pixel(pixel);
+  vec3 normal = texelFetch(normal_sampler, guide, 0).xyz;
+  if (normal == vec3(0, 0, 0)) {
+    occlusion = center;
+    return;
+  }
+  vec3 position = texelFetch(position_sampler, guide, 0).xyz;
+  ivec2 size = textureSize(occlusion_sampler, 0);
+  float tolerance = PLANE_TOLERANCE * max(abs(position.z), 1e-3);
+
+  vec2 sum = vec2(0, 0);
+  float total = 0;
+  for (int j = -2; j <= 2; ++j) {
+    for (int i = -2; i <= 2; ++i) {
+      ivec2 k = pixel + ivec2(i, j) * step_width;
+      if (any(lessThan(k, ivec2(0))) || any(greaterThanEqual(k, size)))
+        continue;
+      ivec2 g = guide_pixel(k);
+      vec3 n = texelFetch(normal_sampler, g, 0).xyz;
+      if (n == vec3(0, 0, 0))
+        continue;
+      vec3 p = texelFetch(position_sampler, g, 0).xyz;
+      float plane_distance = abs(dot(normal, p - position)) / tolerance;
+      float weight = KERNEL[abs(i)] * KERNEL[abs(j)] *
+                     pow(max(dot(normal, n), 0), NORMAL_POWER) *
+                     exp(-plane_distance * plane_distance);
+      sum += texelFetch(occlusion_sampler, k, 0).xy * weight;
+      total += weight;
+    }
+  }
+  occlusion = vec4(sum / total, center.zw);
+}
@@ -0,0 +1,134 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+#include "occlusion.glsl"
+
+// Geometry pass inputs
+uniform sampler2D position_sampler;
+uniform sampler2D normal_sampler;
+uniform sampler2D material_sampler;
+
+// Pixels of the geometry pass per pixel of the occlusion in each axis; each
+// occlusion pixel traces the center pixel of its block
+uniform int occlusion_scale;
+
+// Statistics collected for benchmarking
+uniform bool collect_statistics;
+layout(std430) buffer StatisticsBlock {
+  uint total_steps;
+  uint total_pixels;
+};
+
+// Temporal accumulation: the occlusion is blended with the history of the
+// previous frames, reprojected with the previous view (history_matrix maps
+// the view space to the previous view space) and projection. The history
+// keeps the samples blended of each pixel, up to max_history, the occlusion
+// at full precision, and its surface (world space normal and view depth),
+// which rejects the history of other surfaces
+uniform bool use_history;
+uniform sampler2D history_sampler;
+uniform sampler2D history_occlusion_sampler;
+uniform sampler2D history_surface_sampler;
+uniform mat4 history_matrix;
+uniform mat4 history_projection;
+uniform mat4 world_from_view;
+uniform int max_history;
+
+// Uses the world space occlusion cache instead of tracing every ray
+uniform bool use_cache;
+
+// Relative depth difference and normal cosine of the accepted history
+const float HISTORY_DEPTH_TOLERANCE = 0.02;
+const float HISTORY_NORMAL_TOLERANCE = 0.9;
+
+// Occlusion factor, traversal steps, samples blended and rays traced of the
+// pixel (half floats, read by the following passes), the occlusion factor
+// at full precision, which the history blends, and the surface of the pixel
+layout(location = 0) out vec4 occlusion;
+layout(location = 1) out float accumulated_occlusion;
+layout(location = 2) out vec4 surface;
+
+// Obtains the history of the surface point (occlusion, steps and samples);
+// the samples are 0 if it isn't in the history
+vec3 fetch_history(vec3 position, vec3 world_normal) {
+  vec3 previous = multmatrix(history_matrix, position);
+  vec4 clip = history_projection * vec4(previous, 1);
+  vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+  if (any(lessThan(uv, vec2(0))) || any(greaterThanEqual(uv, vec2(1))))
+    return vec3(0);
+  ivec2 texel = ivec2(uv * textureSize(history_sampler, 0));
+  vec3 history = texelFetch(history_sampler, texel, 0).xyz;
+  history.x = texelFetch(history_occlusion_sampler, texel, 0).x;
+  vec4 history_surface = texelFetch(history_surface_sampler, texel, 0);
+  if (abs(history_surface.w - previous.z) >
+          HISTORY_DEPTH_TOLERANCE * abs(previous.z) ||
+      dot(history_surface.xyz, world_normal) < HISTORY_NORMAL_TOLERANCE)
+    return vec3(0);
+  return history;
+}
+
+void main() {
+  sample_pixel = ivec2(gl_FragCoord.xy);
+  ivec2 pixel = ivec2(gl_FragCoord.xy) * occlusion_scale +
+                occlusion_scale / 2;
+  pixel = min(pixel, textureSize(position_sampler, 0) - 1);
+  int material = int(texelFetch(material_sampler, pixel, 0).x) - 1;
+  if (material == -1) {
+    occlusion = vec4(0, 0, 0, 0);
+    accumulated_occlusion = 0;
+    surface = vec4(0, 0, 0, 0);
+    return;
+  }
+  vec3 position = texelFetch(position_sampler, pixel, 0).xyz;
+  vec3 normal = texelFetch(normal_sampler, pixel, 0).xyz;
+  float ambient_occlusion;
+  if (ao_method == AO_CONE_TRACING)
+    ambient_occlusion = compute_cone_occlusion(normal, position);
+  else if (use_cache)
+    ambient_occlusion = compute_cached_occlusion(normal, position);
+  else
+    ambient_occlusion = compute_ambient_occlusion(normal, position);
+
+  if (collect_statistics) {
+    atomicAdd(total_steps, uint(n_steps));
+    atomicAdd(total_pixels, 1u);
+  }
+  vec2 value = vec2(ambient_occlusion, n_steps);
+
+  vec3 world_normal = normalize(mat3(world_from_view) * normal);
+  float samples = 1;
+  if (use_history) {
+    vec3 history = fetch_history(position, world_normal);
+    if (history.z > 0) {
+      samples = min(history.z + 1, float(max_history));
+      value = mix(history.xy, value, 1 / samples);
+    }
+  }
+  occlusion = vec4(value, samples, n_traced_rays);
+  accumulated_occlusion = value.x;
+  surface = vec4(world_normal, position.z);
+}
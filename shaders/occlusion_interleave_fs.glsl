@@ -0,0 +1,94 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Deinterleaved geometry and occlusion (occlusion factor, traversal steps
+// and rays traced); the pixel p of the sub-image k is the traced pixel
+// p * interleave_size + k
+uniform sampler2D position_sampler;
+uniform sampler2D normal_sampler;
+uniform sampler2D occlusion_sampler;
+uniform int interleave_size;
+uniform ivec2 sub_image_size;
+
+// Size of the traced image
+uniform ivec2 occlusion_size;
+
+// Falloff of the weights with the angle between the normals and with the
+// distance to the tangent plane of the pixel (relative to its depth)
+const float NORMAL_POWER = 8.0;
+const float PLANE_TOLERANCE = 0.02;
+
+// Occlusion factor, traversal steps, samples blended and rays traced of the
+// pixel
+layout(location = 0) out vec4 occlusion;
+
+// Position of the traced pixel in the deinterleaved images
+ivec2 deinterleave(ivec2 traced) {
+  return traced / interleave_size +
+         (traced % interleave_size) * sub_image_size;
+}
+
+// Reinterleaves the occlusion, blurring it over the block of
+// interleave_size x interleave_size pixels around the pixel, which holds a
+// pixel of every sub-image and so every subset of the rays. The weights of
+// the pixels on other surfaces fall off, so the occlusion doesn't bleed
+// across the edges
+void main() {
+  ivec2 pixel = ivec2(gl_FragCoord.xy);
+  ivec2 center = deinterleave(pixel);
+  vec3 normal = texelFetch(normal_sampler, center, 0).xyz;
+  if (normal == vec3(0, 0, 0)) {
+    occlusion = vec4(0, 0, 0, 0);
+    return;
+  }
+  vec3 position = texelFetch(position_sampler, center, 0).xyz;
+  float tolerance = PLANE_TOLERANCE * max(abs(position.z), 1e-3);
+
+  vec4 sum = vec4(0, 0, 0, 0);
+  float total = 0;
+  int first = -interleave_size / 2;
+  for (int j = first; j < first + interleave_size; ++j) {
+    for (int i = first; i < first + interleave_size; ++i) {
+      ivec2 traced = pixel + ivec2(i, j);
+      if (any(lessThan(traced, ivec2(0))) ||
+          any(greaterThanEqual(traced, occlusion_size)))
+        continue;
+      ivec2 k = deinterleave(traced);
+      vec3 n = texelFetch(normal_sampler, k, 0).xyz;
+      if (n == vec3(0, 0, 0))
+        continue;
+      vec3 p = texelFetch(position_sampler, k, 0).xyz;
+      float plane_distance = abs(dot(normal, p - position)) / tolerance;
+      float weight = pow(max(dot(normal, n), 0), NORMAL_POWER) *
+                     exp(-plane_distance * plane_distance);
+      sum += texelFetch(occlusion_sampler, k, 0) * weight;
+      total += weight;
+    }
+  }
+  sum /= total;
+  occlusion = vec4(sum.xy, 1, sum.w);
+}
@@ -0,0 +1,92 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Geometry pass inputs, which guide the upsampling
+uniform sampler2D position_sampler;
+uniform sampler2D normal_sampler;
+
+// Occlusion traced at a fraction of the resolution (occlusion factor,
+// traversal steps, samples blended and rays traced); the pixel k traced the
+// geometry pass pixel k * occlusion_scale + occlusion_scale / 2
+uniform sampler2D occlusion_sampler;
+uniform int occlusion_scale;
+
+// Falloff of the weights with the angle between the normals and with the
+// distance to the tangent plane of the pixel (relative to its depth)
+const float NORMAL_POWER = 8.0;
+const float PLANE_TOLERANCE = 0.02;
+
+// Upsampled occlusion of the pixel
+out vec4 occlusion;
+
+// Joint bilateral upsampling: the bilinear weights of the 4 nearest traced
+// pixels are scaled by how close their surface is to the one of the pixel,
+// so the occlusion doesn't bleed across the edges. If every sample is on
+// another surface the closest one is used
+void main() {
+  ivec2 pixel = ivec2(gl_FragCoord.xy);
+  vec3 normal = texelFetch(normal_sampler, pixel, 0).xyz;
+  if (normal == vec3(0, 0, 0)) {
+    occlusion = vec4(0, 0, 0, 0);
+    return;
+  }
+  vec3 position = texelFetch(position_sampler, pixel, 0).xyz;
+  ivec2 size = textureSize(occlusion_sampler, 0);
+  ivec2 guide_size = textureSize(position_sampler, 0);
+  vec2 low = (vec2(pixel) - occlusion_scale / 2) / occlusion_scale;
+  ivec2 base = ivec2(floor(low));
+  vec2 f = low - base;
+  float tolerance = PLANE_TOLERANCE * max(abs(position.z), 1e-3);
+
+  vec4 sum = vec4(0, 0, 0, 0);
+  float total = 0;
+  vec4 closest = vec4(0, 0, 0, 0);
+  float closest_distance = 1e30;
+  for (int j = 0; j < 2; ++j) {
+    for (int i = 0; i < 2; ++i) {
+      ivec2 k = clamp(base + ivec2(i, j), ivec2(0), size - 1);
+      ivec2 guide = min(k * occlusion_scale + occlusion_scale / 2,
+                        guide_size - 1);
+      vec3 p = texelFetch(position_sampler, guide, 0).xyz;
+      vec3 n = texelFetch(normal_sampler, guide, 0).xyz;
+      vec4 value = texelFetch(occlusion_sampler, k, 0);
+      if (n == vec3(0, 0, 0))
+        continue;
+      float plane_distance = abs(dot(normal, p - position)) / tolerance;
+      float bilinear = (i == 0 ? 1 - f.x : f.x) * (j == 0 ? 1 - f.y : f.y);
+      float weight = bilinear * pow(max(dot(normal, n), 0), NORMAL_POWER) *
+                     exp(-plane_distance * plane_distance);
+      sum += value * weight;
+      total += weight;
+      if (plane_distance < closest_distance) {
+        closest_distance = plane_distance;
+        closest = value;
+      }
+    }
+  }
+  occlusion = total > 1e-4 ? sum / total : closest;
+}
@@ -0,0 +1,47 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#version 450
+
+// One work group per 8x8 columns of a slice map buffer
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// Surface voxels, one word for each 32 voxels of a column
+uniform usampler3D surface_words;
+
+// Slice map buffer (128 voxels of depth) being written and its resolution
+layout(rgba32ui) uniform writeonly uimage2D slice_map;
+uniform int buffer_index;
+uniform int resolution;
+
+void main() {
+  ivec2 column = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(column, ivec2(resolution))))
+    return;
+  uvec4 texel;
+  for (int i = 0; i < 4; ++i)
+    texel[i] = texelFetch(surface_words, ivec3(column, buffer_index * 4 + i),
+                          0).r;
+  imageStore(slice_map, column, texel);
+}
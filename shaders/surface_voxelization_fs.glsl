@@ -0,0 +1,65 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Voxels in each axis of the volume
+uniform int volume_resolution;
+
+// Surface voxels, one 32 bit word for each 32 voxels of a column (the same
+// bits as the slice map channels); only the words [first_word, end_word)
+// are written, the buffers of the slice map outside them are kept
+layout(r32ui) uniform coherent uimage3D surface_words;
+uniform int first_word;
+uniform int end_word;
+
+// Input from the geometry shader
+in vec3 voxel_position;
+flat in int dominant_axis;
+flat in vec4 triangle_bounds;
+
+void main() {
+  vec2 ndc = gl_FragCoord.xy / volume_resolution * 2 - 1;
+  if (any(lessThan(ndc, triangle_bounds.xy)) ||
+      any(greaterThan(ndc, triangle_bounds.zw)))
+    discard;
+
+  // Along the dominant axis the triangle moves at most one voxel per pixel,
+  // so it crosses the voxels within half a pixel of its depth
+  float depth = voxel_position[dominant_axis];
+  float extent = 0.5 * (abs(dFdx(depth)) + abs(dFdy(depth)));
+  ivec3 voxel = ivec3(floor(voxel_position));
+  int last = int(floor(depth + extent));
+  for (int d = int(floor(depth - extent)); d <= last; ++d) {
+    voxel[dominant_axis] = d;
+    if (any(lessThan(voxel, ivec3(0))) ||
+        any(greaterThanEqual(voxel, ivec3(volume_resolution))))
+      continue;
+    int word = voxel.z / 32;
+    if (word < first_word || word >= end_word)
+      continue;
+    imageAtomicOr(surface_words, ivec3(voxel.xy, word), 1u << (voxel.z % 32));
+  }
+}
@@ -0,0 +1,94 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#version 450
+
+// Projects each triangle along the axis its normal is closest to, so it
+// covers as many pixels as possible, and dilates it by half a pixel to
+// emulate conservative rasterization
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+// Voxels in each axis of the volume
+uniform int volume_resolution;
+
+// Position of the fragment in voxels, the dominant axis of the triangle and
+// its projected bounding box (in normalized device coordinates) enlarged by
+// half a pixel, which clips the corners added by the dilation
+out vec3 voxel_position;
+flat out int dominant_axis;
+flat out vec4 triangle_bounds;
+
+void main() {
+  vec3 p[3];
+  for (int i = 0; i < 3; ++i)
+    p[i] = gl_in[i].gl_Position.xyz / gl_in[i].gl_Position.w;
+  vec3 normal = cross(p[1] - p[0], p[2] - p[0]);
+  vec3 n = abs(normal);
+  int axis = n.x > n.y && n.x > n.z ? 0 : n.y > n.z ? 1 : 2;
+  if (n[axis] == 0)
+    return;
+
+  // The other two axes are the projection plane, in counterclockwise order
+  int u = (axis + 1) % 3;
+  int v = (axis + 2) % 3;
+  vec2 q[3];
+  for (int i = 0; i < 3; ++i)
+    q[i] = vec2(p[i][u], p[i][v]);
+  if (normal[axis] < 0) {
+    vec2 t = q[1];
+    q[1] = q[2];
+    q[2] = t;
+  }
+
+  // Each edge is pushed out by half a pixel (1 / R in device coordinates)
+  // along its normal, the new corners are where the shifted edges meet
+  float half_pixel = 1.0 / volume_resolution;
+  vec3 edges[3];
+  for (int i = 0; i < 3; ++i) {
+    edges[i] = cross(vec3(q[i], 1), vec3(q[(i + 1) % 3], 1));
+    edges[i].z += half_pixel * (abs(edges[i].x) + abs(edges[i].y));
+  }
+  vec2 q_min = min(q[0], min(q[1], q[2])) - half_pixel;
+  vec2 q_max = max(q[0], max(q[1], q[2])) + half_pixel;
+
+  for (int i = 0; i < 3; ++i) {
+    vec3 corner = cross(edges[(i + 2) % 3], edges[i]);
+    vec2 c = corner.xy / corner.z;
+    // The depth along the dominant axis comes from the triangle plane
+    vec3 position;
+    position[u] = c.x;
+    position[v] = c.y;
+    position[axis] = p[0][axis] - (normal[u] * (c.x - p[0][u]) +
+                                   normal[v] * (c.y - p[0][v])) /
+                                      normal[axis];
+    voxel_position = (position * 0.5 + 0.5) * volume_resolution;
+    dominant_axis = axis;
+    triangle_bounds = vec4(q_min, q_max);
+    gl_Position = vec4(c, 0, 1);
+    EmitVertex();
+  }
+  EndPrimitive();
+}
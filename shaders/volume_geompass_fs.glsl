@@ -0,0 +1,163 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Gabriel de Quadros Ligneul
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#version 450
+
+// Slice map with the volumetric scene
+uniform usampler2D slice_map[8];
+uniform int volume_resolution;
+
+// View space to the volume (in voxels) and its inverse transpose, for the
+// normals; the projection and its inverse give the view rays and the depth
+uniform mat4 volume_matrix;
+uniform mat4 volume_matrix_it;
+uniform mat4 projection;
+uniform mat4 projection_inverse;
+
+// Vertex material
+uniform int material_id;
+
+// Input from vertex shader
+in vec2 frag_textcoord;
+
+// Geometry output
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec3 normal;
+layout(location = 2) out vec3 material;
+
+// Obtains 32 voxels of the column (x, y), starting at z = 32 * word
+uint fetch_word(ivec2 xy, int word) {
+  uvec4 column = texelFetch(slice_map[word / 4], xy, 0);
+  return column[word % 4];
+}
+
+// Mask with the bits [lo, hi] of a word set
+uint bit_range(int lo, int hi) {
+  return (0xFFFFFFFFu >> (31 - hi)) & (0xFFFFFFFFu << lo);
+}
+
+// Finds the first active voxel of the column (x, y) between the voxels z0
+// and z1 (inclusive), walking from z0 to z1; returns -1 if there is none
+int find_in_column(ivec2 xy, int z0, int z1) {
+  int lo = min(z0, z1);
+  int hi = max(z0, z1);
+  if (z1 >= z0) {
+    for (int word = lo / 32; word <= hi / 32; ++word) {
+      int base = word * 32;
+      uint mask = bit_range(max(lo - base, 0), min(hi - base, 31));
+      uint bits = fetch_word(xy, word) & mask;
+      if (bits != 0)
+        return base + findLSB(bits);
+    }
+  } else {
+    for (int word = hi / 32; word >= lo / 32; --word) {
+      int base = word * 32;
+      uint mask = bit_range(max(lo - base, 0), min(hi - base, 31));
+      uint bits = fetch_word(xy, word) & mask;
+      if (bits != 0)
+        return base + findMSB(bits);
+    }
+  }
+  return -1;
+}
+
+// Casts a ray through the volume, in voxels; returns the distance to the
+// first active voxel (or -1) and the normal of the face where it enters
+//
+// Same column traversal of the lightpass march_ray: Amanatides-Woo over the
+// (x, y) columns and bit masks inside each column
+float cast_ray(vec3 origin, vec3 dir, out vec3 face_normal) {
+  float res = float(volume_resolution);
+  dir = mix(dir, vec3(1e-6), lessThan(abs(dir), vec3(1e-6)));
+  vec3 inv_dir = 1.0 / dir;
+
+  // Clips the ray against the volume
+  vec3 t0 = -origin * inv_dir;
+  vec3 t1 = (res - origin) * inv_dir;
+  vec3 t_near = min(t0, t1);
+  vec3 t_far = max(t0, t1);
+  float t = max(max(t_near.x, t_near.y), max(t_near.z, 0));
+  float t_end = min(t_far.x, min(t_far.y, t_far.z));
+  if (t >= t_end)
+    return -1;
+  // Face where the ray enters the volume (the depth axis if the camera is
+  // inside it)
+  int axis = t == 0 ? 2 : t == t_near.x ? 0 : t == t_near.y ? 1 : 2;
+  face_normal = vec3(0);
+  face_normal[axis] = -sign(dir[axis]);
+
+  vec3 p = origin + dir * t;
+  ivec2 cell = ivec2(clamp(floor(p.xy), vec2(0), vec2(res - 1)));
+  ivec2 cell_step = ivec2(sign(dir.xy));
+  vec2 t_delta = abs(inv_dir.xy);
+  vec2 t_next = (vec2(cell) + step(0, dir.xy) - origin.xy) * inv_dir.xy;
+
+  while (t < t_end) {
+    if (any(lessThan(cell, ivec2(0))) ||
+        any(greaterThanEqual(cell, ivec2(volume_resolution))))
+      break;
+    float t_leave = min(min(t_next.x, t_next.y), t_end);
+    int z0 = clamp(int(floor(origin.z + dir.z * t)), 0, volume_resolution - 1);
+    int z1 = clamp(int(floor(origin.z + dir.z * t_leave)), 0,
+                   volume_resolution - 1);
+    int z = find_in_column(cell, z0, z1);
+    if (z >= 0) {
+      if (z != z0) {
+        face_normal = vec3(0, 0, -sign(dir.z));
+        t = (float(dir.z > 0 ? z : z + 1) - origin.z) * inv_dir.z;
+      }
+      return t;
+    }
+    t = t_leave;
+    if (t_next.x < t_next.y) {
+      cell.x += cell_step.x;
+      t_next.x += t_delta.x;
+      face_normal = vec3(-cell_step.x, 0, 0);
+    } else {
+      cell.y += cell_step.y;
+      t_next.y += t_delta.y;
+      face_normal = vec3(0, -cell_step.y, 0);
+    }
+  }
+  return -1;
+}
+
+void main() {
+  // View ray of the pixel, from the camera
+  vec4 far = projection_inverse * vec4(frag_textcoord * 2 - 1, 1, 1);
+  vec3 ray = far.xyz / far.w;
+  vec3 origin = vec3(volume_matrix * vec4(0, 0, 0, 1));
+  vec3 dir = mat3(volume_matrix) * ray;
+
+  vec3 face_normal;
+  float t = cast_ray(origin, dir, face_normal);
+  if (t < 0)
+    discard;
+
+  position = ray * t;
+  normal = normalize(mat3(volume_matrix_it) * face_normal);
+  material.r = material_id + 1;
+  vec4 clip = projection * vec4(position, 1);
+  gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+}
@@ -31,6 +31,9 @@ uniform usampler1D voxel_depth_lut;
 // Number of buffers used
 uniform int n_volume_buffers;
 
+// First buffer rendered; the previous ones are masked by the draw buffers
+uniform int first_buffer;
+
 // Input from vertex shader
 in vec3 frag_position;
 in vec3 frag_normal;
@@ -38,9 +41,16 @@ in vec3 frag_normal;
 // Geometry output
 out uvec4 voxels[8];
 
+// Depth clamping moves the fragments behind the far plane to it; they must
+// still fall inside the last buffer
+const float MAX_DEPTH = 0.999999;
+
 void main() {
-  float slice_postion = gl_FragCoord.z * n_volume_buffers;
+  float slice_postion = min(gl_FragCoord.z, MAX_DEPTH) * n_volume_buffers;
   int colorbuffer_idx = int(slice_postion);
+  // The fragment only toggles the buffers in front of it
+  if (colorbuffer_idx < first_buffer)
+    discard;
   for (int i = 0; i < colorbuffer_idx; ++i)
     voxels[i] = uvec4(0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF);
   voxels[colorbuffer_idx] = texture(voxel_depth_lut, fract(slice_postion));